@@ -0,0 +1,49 @@
+/*
+ * Library:   lmfit (Levenberg-Marquardt least squares fitting)
+ *
+ * File:      lmcurve_data.c
+ *
+ * Contents:  Implements lmcurve_data, a variant of lmcurve that passes
+ *            a pointer to user data through to the model function.
+ *
+ * Copyright: Joachim Wuttke, Forschungszentrum Juelich GmbH (2004-2013)
+ *
+ * License:   see ../COPYING (FreeBSD)
+ *
+ * Homepage:  apps.jcns.fz-juelich.de/lmfit
+ */
+
+#include "lmmin.h"
+#include "lmcurve_data.h"
+
+
+typedef struct {
+    const double *const t;
+    const double *const y;
+    double (*const g) (const double t, const double *par, void *user);
+    void *const user;
+} lmcurve_data_data_struct;
+
+
+void lmcurve_data_evaluate(
+    const double *const par, const int m_dat, const void *const data,
+    double *const fvec, int *const info)
+{
+    const lmcurve_data_data_struct *d = (const lmcurve_data_data_struct*)data;
+    (void)(info);
+    for (int i = 0; i < m_dat; i++ )
+        fvec[i] = d->y[i] - d->g(d->t[i], par, d->user);
+}
+
+
+void lmcurve_data(
+    const int n_par, double *const par, const int m_dat,
+    const double *const t, const double *const y,
+    double (*const g)(const double t, const double *const par, void *user),
+    void *const user,
+    const lm_control_struct *const control, lm_status_struct *const status)
+{
+    lmcurve_data_data_struct data = {t, y, g, user};
+    lmmin(n_par, par, m_dat, NULL, (const void *const) &data,
+          lmcurve_data_evaluate, control, status);
+}
@@ -0,0 +1,41 @@
+/*
+ * Library:   lmfit (Levenberg-Marquardt least squares fitting)
+ *
+ * File:      lmcurve_data.h
+ *
+ * Contents:  Declares lmcurve_data(), a variant of lmcurve() that passes
+ *            a pointer to user data through to the model function, so
+ *            that fits with different models can run concurrently.
+ *
+ * Copyright: Joachim Wuttke, Forschungszentrum Juelich GmbH (2004-2013)
+ *
+ * License:   see ../COPYING (FreeBSD)
+ *
+ * Homepage:  apps.jcns.fz-juelich.de/lmfit
+ */
+
+#ifndef LMCURVEDATA_H
+#define LMCURVEDATA_H
+#undef __BEGIN_DECLS
+#undef __END_DECLS
+#ifdef __cplusplus
+#define __BEGIN_DECLS extern "C" {
+#define __END_DECLS }
+#else
+#define __BEGIN_DECLS /* empty */
+#define __END_DECLS   /* empty */
+#endif
+
+#include <lmstruct.h>
+
+__BEGIN_DECLS
+
+void lmcurve_data(
+    const int n_par, double* par, const int m_dat,
+    const double* t, const double* y,
+    double (*g)(const double t, const double* par, void* user),
+    void* user,
+    const lm_control_struct* control, lm_status_struct* status);
+
+__END_DECLS
+#endif /* LMCURVEDATA_H */
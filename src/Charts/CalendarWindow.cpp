@@ -316,6 +316,7 @@ CalendarWindow::CalendarWindow(Context *context)
     connect(context, &Context::filterChanged, this, &CalendarWindow::updateActivities);
     connect(context, &Context::homeFilterChanged, this, &CalendarWindow::updateActivities);
     connect(context, &Context::autoImportCompleted, this, &CalendarWindow::updateActivities);
+    connect(context, &Context::refreshEnd, this, &CalendarWindow::updateActivities);
     connect(context, &Context::rideAdded, this, &CalendarWindow::updateActivitiesIfInRange);
     connect(context, &Context::rideDeleted, this, &CalendarWindow::updateActivitiesIfInRange);
     connect(context, &Context::rideChanged, this, &CalendarWindow::updateActivitiesIfInRange);
@@ -960,10 +961,8 @@ CalendarWindow::getActivities
         }
     }
 
-    for (RideItem *rideItem : context->athlete->rideCache->rides()) {
-        if (   rideItem->dateTime.date() < firstDay
-            || rideItem->dateTime.date() > lastDay
-            || rideItem == nullptr) {
+    for (RideItem *rideItem : context->athlete->rideCache->ridesInRange(firstDay, lastDay)) {
+        if (rideItem == nullptr) {
             continue;
         }
         if (   (context->isfiltered && ! context->filters.contains(rideItem->fileName))
@@ -1207,8 +1206,8 @@ CalendarWindow::findFreeSlot
     }
     QList<std::pair<QTime, int>> busySlots;
     busySlots.append(std::make_pair(QTime(0, 0), getStartHour() * 60 * 60));
-    for (RideItem *rideItem : context->athlete->rideCache->rides()) {
-        if (rideItem != nullptr && rideItem->planned == sourceItem->planned && rideItem->dateTime.date() == newDate) {
+    for (RideItem *rideItem : context->athlete->rideCache->ridesInRange(newDate, newDate)) {
+        if (rideItem != nullptr && rideItem->planned == sourceItem->planned) {
             busySlots.append(std::make_pair(rideItem->dateTime.time(), static_cast<int>(rideItem->getForSymbol("workout_time"))));
         }
     }
@@ -1513,10 +1512,8 @@ CalendarWindow::linkActivities
         }
         double rideMetricValue = rideItem->getForSymbol(getSecondaryMetric(), GlobalContext::context()->useMetricUnits);
         QList<LinkEntry> candidates;
-        for (RideItem *candidateItem : context->athlete->rideCache->rides()) {
-            if (   candidateItem->dateTime.date() >= minDate
-                && candidateItem->dateTime.date() <= maxDate
-                && candidateItem->planned != linkEntry.planned
+        for (RideItem *candidateItem : context->athlete->rideCache->ridesInRange(minDate, maxDate)) {
+            if (   candidateItem->planned != linkEntry.planned
                 && candidateItem->sport == rideItem->sport
                 && candidateItem->getLinkedFileName().isEmpty()) {
                 LinkEntry candidate;
@@ -1678,7 +1678,7 @@ MetricOverviewItem::setDateRange(DateRange dr)
     double v=0; // value
     double c=0; // count
     bool first=true;
-    foreach(RideItem *item, parent->context->athlete->rideCache->rides()) {
+    foreach(RideItem *item, parent->context->athlete->rideCache->ridesInRange(spec.dateRange())) {
 
         if (!spec.pass(item)) continue;
 
@@ -1745,7 +1745,7 @@ MetricOverviewItem::setDateRange(DateRange dr)
     double min=0, max=0;
     double sum=0;
     first=true;
-    foreach(RideItem *item, parent->context->athlete->rideCache->rides()) {
+    foreach(RideItem *item, parent->context->athlete->rideCache->ridesInRange(spec.dateRange())) {
 
         if (!spec.pass(item)) continue;
 
@@ -1799,7 +1799,7 @@ TopNOverviewItem::setDateRange(DateRange dr)
     maxvalue="";
     maxv=0; // must never have -ve max
     minv=0; // always zero minimum
-    foreach(RideItem *item, parent->context->athlete->rideCache->rides()) {
+    foreach(RideItem *item, parent->context->athlete->rideCache->ridesInRange(spec.dateRange())) {
 
         if (!spec.pass(item)) continue;
 
@@ -1980,7 +1980,7 @@ DonutOverviewItem::setDateRange(DateRange dr)
 
     // aggregate sum and count etc
     QMap<QString, aggregator> data;
-    foreach(RideItem *item, parent->context->athlete->rideCache->rides()) {
+    foreach(RideItem *item, parent->context->athlete->rideCache->ridesInRange(spec.dateRange())) {
 
         if (!spec.pass(item)) continue;
 
@@ -2147,7 +2147,7 @@ ZoneOverviewItem::setDateRange(DateRange dr)
     setFilter(this, spec);
 
     // aggregate sum and count etc
-    foreach(RideItem *item, parent->context->athlete->rideCache->rides()) {
+    foreach(RideItem *item, parent->context->athlete->rideCache->ridesInRange(spec.dateRange())) {
 
         if (!spec.pass(item)) continue;
 
@@ -2469,7 +2469,7 @@ IntervalOverviewItem::setDateRange(DateRange dr)
     bool first=true;
 
     QList<BPointF> points;
-    foreach(RideItem *item, parent->context->athlete->rideCache->rides()) {
+    foreach(RideItem *item, parent->context->athlete->rideCache->ridesInRange(spec.dateRange())) {
 
         if (!spec.pass(item)) continue;
 
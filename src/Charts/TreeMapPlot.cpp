@@ -62,7 +62,7 @@ TreeMapPlot::setData(TMSettings *settings)
 {
     root->clear();
 
-    foreach (RideItem *item, context->athlete->rideCache->rides()) {
+    foreach (RideItem *item, context->athlete->rideCache->ridesInRange(settings->specification.dateRange())) {
 
         // don't plot if filtered
         if (!settings->specification.pass(item)) continue;
@@ -290,7 +290,7 @@ TreeMapWindow::cellClicked(QString f1, QString f2)
 
     // create a list of activities in this cell
     int count = 0;
-    foreach(RideItem *item, context->athlete->rideCache->rides()) {
+    foreach(RideItem *item, context->athlete->rideCache->ridesInRange(settings.specification.dateRange())) {
 
         // honour the settings
         if (!settings.specification.pass(item)) continue;
@@ -39,6 +39,10 @@
 #include <limits>
 #include <QScrollArea>
 #include <QDialog>
+#include <QPlainTextEdit>
+#include <QFontDatabase>
+#include <QFileDialog>
+#include <QMessageBox>
 
 UserChart::UserChart(QWidget *parent, Context *context, bool rangemode, QString bg)
     : QWidget(parent), context(context), rangemode(rangemode), stale(true), last(NULL), ride(NULL), intervals(0), item(NULL)
@@ -197,6 +201,10 @@ UserChart::refresh()
         if (p != NULL && p->selected == true) intervals++;
     }
 
+    // record where the time goes when asked
+    DataFilterProfile *profile = settingsTool_->profile();
+    if (profile) profile->clear();
+
     // ok, we've run out of excuses, looks like we need to plot
     chart->setBackgroundColor(RGBColor(chartinfo.bgcolor));
     chart->initialiseChart(chartinfo.title, chartinfo.type, chartinfo.animate, chartinfo.legendpos, chartinfo.stack, chartinfo.orientation, chartinfo.scale);
@@ -217,8 +225,12 @@ UserChart::refresh()
 
         // cast so we can work with it
         UserChartData *ucd = static_cast<UserChartData*>(series.user1);
+        ucd->rt->profile = profile;
         // NOTE: specification is blank so doesn't honor perspective or filters, use activity {} in program for that (!!)
+        if (profile) profile->enter(series.name);
         ucd->compute(const_cast<RideItem*>(ride), Specification(), dr);
+        if (profile) profile->leave();
+        ucd->rt->profile = NULL;
         series.xseries = ucd->x.asNumeric();
         series.yseries = ucd->y.asNumeric();
         series.fseries = ucd->f.asString();
@@ -305,6 +317,7 @@ UserChart::refresh()
                         series.opengl, series.legend, series.datalabels, series.fill, series.aggregateby, series.annotations);
 
     }
+    if (profile) settingsTool_->refreshProfileTab();
 
     foreach (GenericAxisInfo axis, axisinfo) {
 
@@ -912,6 +925,29 @@ UserChartSettings::UserChartSettings(Context *context, bool rangemode, GenericCh
 
     axisLayout->addWidget(axisActionButtons);
 
+    // Profile tab
+    // where the time went when the series were last computed
+    QWidget *profileWidget = new QWidget(this);
+    QVBoxLayout *profileLayout = new QVBoxLayout(profileWidget);
+    tabs->addTab(profileWidget, tr("Profile"));
+
+    profiling = new QCheckBox(tr("Profile the series programs when refreshed"), this);
+    profiling->setChecked(false);
+    profileLayout->addWidget(profiling);
+
+    profileReport = new QPlainTextEdit(this);
+    profileReport->setReadOnly(true);
+    profileReport->setLineWrapMode(QPlainTextEdit::NoWrap);
+    profileReport->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    profileLayout->addWidget(profileReport);
+
+    profileSave = new QPushButton(tr("Save..."), this);
+    profileSave->setEnabled(false);
+    profileLayout->addWidget(profileSave, 0, Qt::AlignRight);
+
+    connect(profiling, SIGNAL(stateChanged(int)), this, SLOT(profilingChanged()));
+    connect(profileSave, SIGNAL(clicked()), this, SLOT(saveProfile()));
+
     // watch for chartinfo edits (the series/axis stuff is managed by separate dialogs)
     connect(title, SIGNAL(textChanged(QString)), this, SLOT(updateChartInfo()));
     connect(description, SIGNAL(textChanged()), this, SLOT(updateChartInfo()));
@@ -925,6 +961,31 @@ UserChartSettings::UserChartSettings(Context *context, bool rangemode, GenericCh
     connect(bgcolor, SIGNAL(colorChosen(QColor)), this, SLOT(updateChartInfo()));
 }
 
+void
+UserChartSettings::refreshProfileTab()
+{
+    profileReport->setPlainText(profile_.isEmpty() ? QString() : profile_.report());
+    profileSave->setEnabled(!profile_.isEmpty());
+}
+
+void
+UserChartSettings::profilingChanged()
+{
+    profile_.clear();
+    refreshProfileTab();
+
+    // refresh the chart to profile it
+    if (profiling->isChecked()) emit chartConfigChanged();
+}
+
+void
+UserChartSettings::saveProfile()
+{
+    QString filename = QFileDialog::getSaveFileName(this, tr("Save Profile"), QString(), tr("CSV files (*.csv)"));
+    if (filename != "" && !profile_.save(filename))
+        QMessageBox::warning(this, tr("Save Profile"), tr("Unable to write %1").arg(filename));
+}
+
 void
 UserChartSettings::insertLayout(QLayout *p)
 {
@@ -1363,6 +1424,8 @@ EditUserSeriesDialog::EditUserSeriesDialog(Context *context, bool rangemode, Gen
     main->addLayout(hf);
     //main->addStretch();
     QHBoxLayout *buttonLayout = new QHBoxLayout;
+    optimisedButton = new QPushButton(tr("Show Optimised"), this);
+    buttonLayout->addWidget(optimisedButton);
     buttonLayout->addStretch();
     okButton = new QPushButton(tr("&OK"), this);
     cancelButton = new QPushButton(tr("&Cancel"), this);
@@ -1562,6 +1625,7 @@ EditUserSeriesDialog::EditUserSeriesDialog(Context *context, bool rangemode, Gen
     connect(okButton, SIGNAL(clicked()), this, SLOT(okClicked()));
     connect(cancelButton, SIGNAL(clicked()), this, SLOT(cancelClicked()));
     connect(program, SIGNAL(syntaxErrors(QStringList&)), this, SLOT(setErrors(QStringList&)));
+    connect(optimisedButton, SIGNAL(clicked()), this, SLOT(showOptimised()));
 }
 
 void
@@ -1571,6 +1635,38 @@ EditUserSeriesDialog::setErrors(QStringList &list)
 
 }
 
+void
+EditUserSeriesDialog::showOptimised()
+{
+    // parse and compile the program as the chart will
+    DataFilter filter(NULL, context, program->toPlainText());
+
+    QString text;
+    if (filter.root()) {
+        const DataFilterOptimizer::Stats &done = filter.optimizations();
+        text = QString(tr("%1 folded, %2 branches and %3 statements removed, %4 computed once per activity (%5 shared)"))
+               .arg(done.folded).arg(done.branches).arg(done.statements).arg(done.hoisted).arg(done.shared);
+        text += "\n\n" + DataFilterOptimizer::dump(filter.root());
+    } else {
+        text = filter.getErrors().join("\n");
+    }
+
+    QDialog dialog(this);
+    dialog.setWindowTitle(tr("Optimised Program"));
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+    QPlainTextEdit *tree = new QPlainTextEdit(&dialog);
+    tree->setReadOnly(true);
+    tree->setLineWrapMode(QPlainTextEdit::NoWrap);
+    tree->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    tree->setPlainText(text);
+    layout->addWidget(tree);
+    QPushButton *close = new QPushButton(tr("&Close"), &dialog);
+    layout->addWidget(close, 0, Qt::AlignRight);
+    connect(close, SIGNAL(clicked()), &dialog, SLOT(accept()));
+    dialog.resize(600 * dpiXFactor, 500 * dpiXFactor);
+    dialog.exec();
+}
+
 void
 EditUserSeriesDialog::cancelClicked()
 {
@@ -32,6 +32,9 @@
 #include "GenericPlot.h"
 #include "ColorButton.h"
 #include "DataFilter.h"
+#include "DataFilterProfile.h"
+
+#include <QPlainTextEdit>
 
 // the chart
 class ChartSpace;
@@ -135,6 +138,9 @@ class UserChartSettings : public QWidget {
         // we want some additional config?
         void insertLayout(QLayout *);
 
+        // the profile to record the series programs in, NULL when not profiling
+        DataFilterProfile *profile() { return profiling->isChecked() ? &profile_ : NULL; }
+
     private:
         Context *context;
         bool rangemode;
@@ -157,6 +163,12 @@ class UserChartSettings : public QWidget {
         // axes tab
         QTableWidget *axisTable;
 
+        // profile tab
+        QCheckBox *profiling;
+        QPlainTextEdit *profileReport;
+        QPushButton *profileSave;
+        DataFilterProfile profile_;
+
     public slots:
 
         // configuration - chart
@@ -179,6 +191,11 @@ class UserChartSettings : public QWidget {
         void addAxis();
         void deleteAxis();
 
+        // profile of the last refresh
+        void refreshProfileTab();
+        void profilingChanged();
+        void saveProfile();
+
     signals:
 
         void chartConfigChanged();
@@ -214,6 +231,7 @@ class EditUserSeriesDialog : public QDialog
         void cancelClicked();
 
         void setErrors(QStringList &errors);
+        void showOptimised(); // the tree as it will be evaluated
 
     private:
         Context *context;
@@ -232,7 +250,7 @@ class EditUserSeriesDialog : public QDialog
         QCheckBox *fill, *opengl, *legend, *datalabels;
         QLineEdit *labels, *colors;
 
-        QPushButton *okButton, *cancelButton;
+        QPushButton *okButton, *cancelButton, *optimisedButton;
 
 };
 
@@ -21,6 +21,7 @@
 #include "UserChart.h"
 #include "UserChartData.h"
 #include "DataFilter.h"
+#include "DataFilterBatch.h"
 #include "Athlete.h"
 
 UserChartData::UserChartData(Context *context, UserChart *parent, QString script, bool rangemode) : context(context), script(script), rangemode(rangemode)
@@ -58,8 +59,9 @@ UserChartData::compute(RideItem *item, Specification spec, DateRange dr)
 {
     if (!root || item == NULL)  return;
 
-    // clear rt indexes
+    // clear rt indexes and the values kept for the ride
     rt->indexes.clear();
+    rt->resetInvariants();
 
     // clear previous data
     relevant=x=y=z=d=t=Result(0);
@@ -84,9 +86,8 @@ UserChartData::compute(RideItem *item, Specification spec, DateRange dr)
             spec.setFilterSet(fs);
 
             // loop through rides for daterange
-            foreach(RideItem *ride, context->athlete->rideCache->rides()) {
+            foreach(RideItem *ride, context->athlete->rideCache->ridesInRange(dr)) {
 
-                if (!dr.pass(ride->dateTime.date())) continue; // relies upon the daterange being passed to eval...
                 if (!spec.pass(ride)) continue; // relies upon the daterange being passed to eval...
 
 
@@ -98,9 +99,12 @@ UserChartData::compute(RideItem *item, Specification spec, DateRange dr)
         if (!spec.isEmpty(item->ride()) && fsample) {
             RideFileIterator it(item->ride(), spec);
 
-            while(it.hasNext()) {
-                struct RideFilePoint *point = it.next();
-                root->eval(rt, fsample, Result(0), 0, const_cast<RideItem*>(item), point, NULL, spec, dr);
+            // whole series at once if the sample function allows it
+            if (!fsample->batch || !fsample->batch->run(rt, item, it.firstIndex(), it.lastIndex(), NULL)) {
+                while(it.hasNext()) {
+                    struct RideFilePoint *point = it.next();
+                    root->eval(rt, fsample, Result(0), 0, const_cast<RideItem*>(item), point, NULL, spec, dr);
+                }
             }
         }
 
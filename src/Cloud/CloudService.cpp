@@ -1004,11 +1004,8 @@ CloudServiceSyncDialog::refreshClicked()
     // clear current
     rideFiles.clear();
 
-    Specification specification;
-    specification.setDateRange(DateRange(from->date(), to->date()));
-    foreach(RideItem *item, context->athlete->rideCache->rides()) {
-        if (specification.pass(item))
-            rideFiles << QFileInfo(item->fileName).baseName().mid(0,14);
+    foreach(RideItem *item, context->athlete->rideCache->ridesInRange(from->date(), to->date())) {
+        rideFiles << QFileInfo(item->fileName).baseName().mid(0,14);
     }
 
     //
@@ -1059,7 +1056,8 @@ CloudServiceSyncDialog::refreshClicked()
             // this is fucking painful, we need to look at every ride we have
             // and add on the duration - if it ends at the same time as this
             // then adjust the target no suffix to the start time
-            foreach(RideItem *item, context->athlete->rideCache->rides()) {
+            // (it can't have started after it ended)
+            foreach(RideItem *item, context->athlete->rideCache->ridesInRange(QDate(), ridedatetime.addSecs(2).date())) {
 
                 QDateTime end = item->dateTime.addSecs(item->getForSymbol("workout_time"));
                 long diff = end.toMSecsSinceEpoch() - ridedatetime.toMSecsSinceEpoch();
@@ -1793,11 +1791,8 @@ CloudServiceAutoDownload::run()
 
                 QStringList rideFiles; // what we have already
 
-                Specification specification;
-                specification.setDateRange(DateRange(now.addDays(-30).date(), now.date()));
-                foreach(RideItem *item, context->athlete->rideCache->rides()) {
-                    if (specification.pass(item))
-                        rideFiles << QFileInfo(item->fileName).baseName().mid(0,16);
+                foreach(RideItem *item, context->athlete->rideCache->ridesInRange(now.addDays(-30).date(), now.date())) {
+                    rideFiles << QFileInfo(item->fileName).baseName().mid(0,16);
                 }
 
                 // eliminate matches
@@ -36,6 +36,7 @@
 #include "WithingsDownload.h"
 #include "CalendarDownload.h"
 #include "PMCData.h"
+#include "DataFilterMemo.h"
 #include "Banister.h"
 #include "TrainerDay.h"
 #ifdef GC_HAVE_ICAL
@@ -158,6 +159,9 @@ Athlete::Athlete(Context *context, const QDir &homeDir)
     // seconds step of the upgrade - now everything of configuration needed should be in place in Context
     v3.upgradeLate(context);
 
+    // settings used when computing, once zones are known and upgraded
+    refreshSettings();
+
     // Routes
     routes = new Routes(context, home->config());
 
@@ -168,9 +172,13 @@ Athlete::Athlete(Context *context, const QDir &homeDir)
     cloudAutoDownload = new CloudServiceAutoDownload(context);
     connect(context, SIGNAL(refreshEnd()), cloudAutoDownload, SLOT(autoDownload()));
 
+    // user metrics may use it as soon as the cache refreshes
+    dfmemo = new DataFilterMemo(context);
+
     // now most dependencies are in get cache
     QEventLoop loop;
     rideCache = new RideCache(context);
+    connect(rideCache, SIGNAL(itemChanged(RideItem*)), dfmemo, SLOT(invalidate()));
     connect(rideCache, SIGNAL(loadComplete()), &loop, SLOT(quit()));
     connect(rideCache, SIGNAL(loadComplete()), this, SLOT(loadComplete()));
 
@@ -236,6 +244,7 @@ Athlete::~Athlete()
 {
     // close the ride cache down first
     delete rideCache;
+    delete dfmemo;
 
     // save those preset charts
     LTMSettings reader;
@@ -255,6 +264,9 @@ Athlete::~Athlete()
     delete seasons;
     delete measures;
 
+    foreach (const SettingsSnapshot *snapshot, retired_) delete snapshot;
+    delete settings_.loadAcquire();
+
     foreach (Zones* zones, zones_) delete zones;
     foreach (HrZones* hrzones, hrzones_) delete hrzones;
     for (int i=0; i<2; i++) delete pacezones_[i];
@@ -368,6 +380,15 @@ Athlete::configChanged(qint32 state)
     }
 }
 
+void
+Athlete::refreshSettings()
+{
+    // publish a fresh snapshot, readers may still be using the
+    // old one so it is kept until we're closed
+    const SettingsSnapshot *old = settings_.fetchAndStoreOrdered(new SettingsSnapshot(this));
+    if (old) retired_ << old;
+}
+
 void
 Athlete::importFilesWhenOpeningAthlete() {
 
@@ -559,14 +580,15 @@ Athlete::getPMCFor(QString metricName, int stsdays, int ltsdays)
     PMCData *returning = NULL;
 
     // if we don't already have one, create it
-    returning = pmcData.value(metricName, NULL);
+    QString key = QString("%1/%2/%3").arg(metricName).arg(stsdays).arg(ltsdays);
+    returning = pmcData.value(key, NULL);
     if (!returning) {
 
         // specification is blank and passes for all
         returning = new PMCData(context, Specification(), metricName, stsdays, ltsdays);
 
         // add to our collection
-        pmcData.insert(metricName, returning);
+        pmcData.insert(key, returning);
     }
 
     return returning;
@@ -578,14 +600,15 @@ Athlete::getPMCFor(Leaf *expr, DataFilterRuntime *df, int stsdays, int ltsdays)
     PMCData *returning = NULL;
 
     // if we don't already have one, create it
-    returning = pmcData.value(expr->signature(), NULL);
+    QString key = QString("%1/%2/%3").arg(expr->signature()).arg(stsdays).arg(ltsdays);
+    returning = pmcData.value(key, NULL);
     if (!returning) {
 
         // specification is blank and passes for all
         returning = new PMCData(context, Specification(), expr, df, stsdays, ltsdays);
 
         // add to our collection
-        pmcData.insert(expr->signature(), returning);
+        pmcData.insert(key, returning);
     }
 
     return returning;
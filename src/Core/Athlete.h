@@ -21,6 +21,7 @@
 
 #include "Measures.h"
 #include "DataFilter.h"
+#include "SettingsSnapshot.h"
 
 #include <QDir>
 #include <QSqlDatabase>
@@ -29,6 +30,7 @@
 #include <QUuid>
 #include <QNetworkReply>
 #include <QHeaderView>
+#include <QAtomicPointer>
 
 
 class Zones;
@@ -49,6 +51,7 @@ class IntervalItem;
 class IntervalTreeView;
 class PDEstimate;
 class PMCData;
+class DataFilterMemo;
 class LTMSettings;
 class Routes;
 class AthleteDirectoryStructure;
@@ -89,6 +92,10 @@ class Athlete : public QObject
         PaceZones *pacezones_[2];
         void setCriticalPower(int cp);
 
+        // settings used in hot loops, safe to read from any thread
+        const SettingsSnapshot *settings() const { return settings_.loadAcquire(); }
+        void refreshSettings(); // called when config changes
+
         // Data
         Seasons *seasons;
         Routes *routes;
@@ -107,7 +114,7 @@ class Athlete : public QObject
         // PMC Data
         PMCData *getPMCFor(QString metricName, int stsDays = -1, int ltsDays = -1); // no Specification used!
         PMCData *getPMCFor(Leaf *expr, DataFilterRuntime *df, int stsDays = -1, int ltsDays = -1); // no Specification used!
-        QMap<QString, PMCData*> pmcData; // all the different PMC series
+        QMap<QString, PMCData*> pmcData; // all the different PMC series, by metric or expression/sts/lts
 
         // Banister Data
         Banister *getBanisterFor(QString metricName, QString perfMetricName, int t1, int t2); // t1/t2 not used yet
@@ -139,6 +146,7 @@ class Athlete : public QObject
 
         // DataFilter global storage/cache
         QMap<QString,Result> dfcache;
+        DataFilterMemo *dfmemo; // results of the expensive builtins
 
         Context *context;
 
@@ -165,6 +173,12 @@ class Athlete : public QObject
         void configChanged(qint32);
         void loadComplete();
 
+    private:
+
+        // published snapshot and the ones it replaced, which
+        // readers may still hold until we're closed
+        QAtomicPointer<const SettingsSnapshot> settings_;
+        QVector<const SettingsSnapshot*> retired_;
 };
 
 
@@ -203,6 +203,10 @@ void
 Context::notifyConfigChanged(qint32 state)
 {
     QApplication::setOverrideCursor(Qt::WaitCursor);
+
+    // before anyone goes looking at them
+    if (athlete) athlete->refreshSettings();
+
     emit configChanged(state);
     QApplication::restoreOverrideCursor();
 }
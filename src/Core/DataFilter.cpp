@@ -19,6 +19,10 @@
 #include "Utils.h"
 #include "Statistic.h"
 #include "DataFilter.h"
+#include "DataFilterProgram.h"
+#include "DataFilterBatch.h"
+#include "DataFilterMemo.h"
+#include "DataFilterProfile.h"
 #include "Context.h"
 #include "Athlete.h"
 #include "RideItem.h"
@@ -35,7 +39,8 @@
 #include "Seasons.h" // for SearchFilterBox::matches
 #include <QDebug>
 #include <QMutex>
-#include "lmcurve.h"
+#include <QtConcurrent>
+#include "lmcurve_data.h"
 #include "LTMTrend.h" // for LR when copying CP chart filtering mechanism
 #include "WPrime.h" // for LR when copying CP chart filtering mechanism
 #include "FastKmeans.h" // for kmeans(...)
@@ -408,6 +413,254 @@ static struct {
     { "", -1 }
 };
 
+// functions Leaf::eval handles itself before the v4 table. The id is
+// bound to the leaf when validated so a call is a switch rather than
+// comparing the name with each one in turn
+enum {
+    DF_none = 0,
+    DF_user,            // user defined function
+    DF_isNumber, DF_isString, DF_double, DF_tolower, DF_toupper, DF_join, DF_split, DF_trim,
+    DF_replace, DF_exists, DF_datestring, DF_timestring, DF_asaggstring, DF_metricname,
+    DF_metricunit, DF_asstring, DF_activities, DF_daterange, DF_config, DF_zones, DF_bool,
+    DF_string, DF_c, DF_pdfbeta, DF_cdfbeta, DF_pdfgamma, DF_cdfgamma, DF_cdfnormal, DF_pdfnormal,
+    DF_seq, DF_rep, DF_rev, DF_length, DF_cumsum, DF_bin, DF_aggregate, DF_append, DF_remove,
+    DF_mid, DF_xdata, DF_xdataseries, DF_xdataunits, DF_xdatavalues, DF_samples, DF_metadata,
+    DF_completervalues, DF_normalize, DF_filename, DF_linked, DF_kmeans, DF_metrics,
+    DF_metricstrings, DF_aggmetrics, DF_aggmetricstrings, DF_intervals, DF_intervalstrings,
+    DF_events, DF_measures, DF_bests, DF_meanmax, DF_interpolate, DF_resample, DF_dist, DF_argsort,
+    DF_rank, DF_sort, DF_uniq, DF_arguniq, DF_multiuniq, DF_store, DF_fetch, DF_curve,
+    DF_lowerbound, DF_random, DF_quantile, DF_multisort, DF_head, DF_tail, DF_sapply, DF_match,
+    DF_nonzero, DF_annotate, DF_smooth, DF_lm, DF_lr, DF_mlr, DF_variance, DF_stddev, DF_pmc,
+    DF_banister, DF_week, DF_weekdate, DF_month, DF_monthdate, DF_powerindex, DF_best, DF_tiz,
+    DF_round,
+};
+
+static const char *DataFilterBuiltins[] = {
+    "isNumber", "isString", "double", "tolower", "toupper", "join", "split", "trim", "replace",
+    "exists", "datestring", "timestring", "asaggstring", "metricname", "metricunit", "asstring",
+    "activities", "daterange", "config", "zones", "bool", "string", "c", "pdfbeta", "cdfbeta",
+    "pdfgamma", "cdfgamma", "cdfnormal", "pdfnormal", "seq", "rep", "rev", "length", "cumsum",
+    "bin", "aggregate", "append", "remove", "mid", "xdata", "xdataseries", "xdataunits",
+    "xdatavalues", "samples", "metadata", "completervalues", "normalize", "filename", "linked",
+    "kmeans", "metrics", "metricstrings", "aggmetrics", "aggmetricstrings", "intervals",
+    "intervalstrings", "events", "measures", "bests", "meanmax", "interpolate", "resample", "dist",
+    "argsort", "rank", "sort", "uniq", "arguniq", "multiuniq", "store", "fetch", "curve",
+    "lowerbound", "random", "quantile", "multisort", "head", "tail", "sapply", "match", "nonzero",
+    "annotate", "smooth", "lm", "lr", "mlr", "variance", "stddev", "pmc", "banister", "week",
+    "weekdate", "month", "monthdate", "powerindex", "best", "tiz", "round",
+    NULL
+};
+
+static int builtinFor(DataFilterRuntime *df, Leaf *leaf)
+{
+    static const QHash<QString, int> ids = [] () {
+        QHash<QString, int> returning;
+        for (int i=0; DataFilterBuiltins[i]; i++) returning.insert(DataFilterBuiltins[i], DF_user + 1 + i);
+        return returning;
+    } ();
+
+    // user functions take precedence, but not count() in user metrics
+    if (leaf->function != "count" && df->functions.contains(leaf->function)) return DF_user;
+    return ids.value(leaf->function, DF_none);
+}
+
+// math.h functions of one number at the top of DataFilterFunctions
+static Leaf::MathFunction mathFunctionFor(int fnum)
+{
+    switch (fnum) {
+    case 0: return cos;
+    case 1 : return tan;
+    case 2 : return sin;
+    case 3 : return acos;
+    case 4 : return atan;
+    case 5 : return asin;
+    case 6 : return cosh;
+    case 7 : return tanh;
+    case 8 : return sinh;
+    case 9 : return acosh;
+    case 10 : return atanh;
+    case 11 : return asinh;
+
+    case 12 : return exp;
+    case 13 : return log;
+    case 14 : return log10;
+
+    case 15 : return ceil;
+    case 16 : return floor;
+
+    case 18 : return fabs;
+    case 19 : return Utils::myisinf;
+    case 20 : return Utils::myisnan;
+
+    default: return NULL;
+    }
+}
+
+// offset into DataFilterFunctions, -1 if not there or
+// called with the wrong number of parameters
+static int v4FunctionFor(Leaf *leaf)
+{
+    for (int i=0; DataFilterFunctions[i].parameters != -1; i++) {
+        if (DataFilterFunctions[i].name == leaf->function) {
+
+            // parameter mismatch not allowed; function signature mismatch
+            // should be impossible...
+            if (DataFilterFunctions[i].parameters && DataFilterFunctions[i].parameters != leaf->fparms.count())
+                return -1;
+            return i;
+        }
+    }
+    return -1;
+}
+
+// builtins that assign symbols, change the ride or share state across
+// rides (models, the chart cache, random numbers, signals) and so can't
+// be evaluated for different rides at the same time
+static const char *DataFilterSideEffects[] = {
+    "append", "remove", "multisort", "multiuniq", "lm", "set", "unset",
+    "autoprocess", "postprocess", "print", "annotate", "random", "store",
+    "fetch", "curve", "lts", "sts", "sb", "rr", "pmc", "banister",
+    "estimate", "estimates", "bests", "meanmax", "activities",
+    NULL
+};
+
+// true if evaluating the expression only reads the ride it is given,
+// the tree must be bound, user functions are followed as they're called
+static bool readOnly(DataFilterRuntime *df, Leaf *leaf, QSet<Leaf*> &visited)
+{
+    static const QSet<QString> sideeffects = [] () {
+        QSet<QString> returning;
+        for (int i=0; DataFilterSideEffects[i]; i++) returning.insert(DataFilterSideEffects[i]);
+        return returning;
+    } ();
+
+    if (leaf == NULL || visited.contains(leaf)) return true;
+    visited.insert(leaf);
+
+    switch(leaf->type) {
+
+    case Leaf::Float :
+    case Leaf::Integer :
+    case Leaf::String :
+        return true;
+
+    case Leaf::Symbol :
+        // the pmc is created on first use
+        return leaf->bound.kind != SymbolBinding::CTL && leaf->bound.kind != SymbolBinding::ATL &&
+               leaf->bound.kind != SymbolBinding::TSB;
+
+    case Leaf::Compound :
+        foreach(Leaf *p, *(leaf->lvalue.b)) if (!readOnly(df, p, visited)) return false;
+        return true;
+
+    case Leaf::Operation:
+    case Leaf::BinaryOperation:
+    case Leaf::Logical :
+        if (leaf->type != Leaf::Logical && leaf->op == ASSIGN) return false;
+        return readOnly(df, leaf->lvalue.l, visited) && (!leaf->op || readOnly(df, leaf->rvalue.l, visited));
+
+    case Leaf::UnaryOperation:
+        return readOnly(df, leaf->lvalue.l, visited);
+
+    case Leaf::Function:
+        if (leaf->builtin == DF_user) {
+            if (!readOnly(df, df->functions.value(leaf->function), visited)) return false;
+        } else if (leaf->builtin < 0 || sideeffects.contains(leaf->function)) return false;
+        if (!readOnly(df, leaf->lvalue.l, visited) || !readOnly(df, leaf->series, visited)) return false;
+        foreach(Leaf* l, leaf->fparms) if (!readOnly(df, l, visited)) return false;
+        return true;
+
+    case Leaf::Index:
+    case Leaf::Select:
+        if (!readOnly(df, leaf->lvalue.l, visited)) return false;
+        foreach(Leaf* l, leaf->fparms) if (!readOnly(df, l, visited)) return false;
+        return true;
+
+    case Leaf::Conditional:
+        return readOnly(df, leaf->cond.l, visited) && readOnly(df, leaf->lvalue.l, visited) &&
+               readOnly(df, leaf->rvalue.l, visited);
+
+    default:
+        // python scripts and anything new
+        return false;
+    }
+}
+
+// builtins over a date range whose results are kept in the athlete's
+// memo, when their parameters have no side effects (they are evaluated
+// for the key as well as by the builtin)
+static bool memoised(DataFilterRuntime *df, Leaf *leaf)
+{
+    switch (leaf->builtin) {
+    case DF_bests :
+    case DF_meanmax :
+    case DF_aggmetrics :
+    case DF_aggmetricstrings :
+    case DF_pmc :
+        break;
+    case DF_none :
+        if (leaf->fnum >= 0 && leaf->function == "estimates") break;
+        return false;
+    default:
+        return false;
+    }
+
+    foreach(Leaf *parm, leaf->fparms) {
+        QSet<Leaf*> visited;
+        if (!readOnly(df, parm, visited)) return false;
+    }
+    return true;
+}
+
+// everything a memoised builtin's result depends upon: the call, the
+// parameters it evaluates, the date range and the filters in force.
+// Empty if the result is per ride or the parameters aren't scalar.
+QString
+Leaf::memoKey(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, RideItem *m, RideFilePoint *p,
+              const QHash<QString,RideMetric*> *c, const Specification &s, const DateRange &d)
+{
+    int first = 1;
+    bool spec = false, filters = false;
+
+    switch (leaf->builtin) {
+    case DF_bests :
+        filters = true;
+        break;
+    case DF_meanmax :
+        // the ride's own is in its cpx, and x/y evaluated as vectors
+        if (leaf->fparms.count() == 2 || (leaf->fparms.count() == 1 && d.from == QDate() && d.to == QDate())) return QString();
+        break;
+    case DF_aggmetrics :
+    case DF_aggmetricstrings :
+        spec = filters = true;
+        break;
+    case DF_pmc :
+        first = leaf->fparms.count(); // the parameters are the expression
+        break;
+    default:
+        // estimates, the parameter is a duration or a name
+        spec = true;
+        if (leaf->fparms[1]->type == Leaf::Symbol) first = 2;
+        break;
+    }
+
+    QString returning = leaf->memo;
+    for (int i=first; i<leaf->fparms.count(); i++) {
+        Result value = leaf->fparms[i]->eval(df, leaf->fparms[i], x, it, m, p, c, s, d);
+        if (value.isVector()) return QString();
+        returning += "|" + (value.isNumber ? QString::number(value.number(), 'g', 17) : value.string());
+    }
+    returning += QString("|%1:%2").arg(d.from.toJulianDay()).arg(d.to.toJulianDay());
+    if (spec) returning += "|" + s.fingerprint();
+    if (filters) {
+        FilterSet fs;
+        fs.addFilter(m->context->isfiltered, m->context->filters);
+        fs.addFilter(m->context->ishomefiltered, m->context->homeFilters);
+        returning += QString("|%1").arg(fs.fingerprint());
+    }
+    return returning;
+}
+
 static QStringList pdmodels(Context *context)
 {
     QStringList returning;
@@ -1759,6 +2012,11 @@ void Leaf::clear(Leaf *leaf)
 {
     if (leaf == NULL) return; // critical to avoid crashes
 
+    delete leaf->program;
+    leaf->program = NULL;
+    delete leaf->batch;
+    leaf->batch = NULL;
+
     switch(leaf->type) {
     case Leaf::Script :
     case Leaf::String : delete leaf->lvalue.s; break;
@@ -3254,7 +3512,125 @@ void Leaf::validateFilter(Context *context, DataFilterRuntime *df, Leaf *leaf)
     }
 }
 
-DataFilter::DataFilter(QObject *parent, Context *context) : QObject(parent), context(context), treeRoot(NULL), parent_(parent)
+void Leaf::bind(DataFilterRuntime *df, Leaf *leaf)
+{
+    if (leaf == NULL) return;
+
+    switch(leaf->type) {
+
+    case Leaf::Symbol :
+        {
+            // every symbol gets a slot since user symbols can
+            // be assigned to any name and override the builtins
+            leaf->bound = SymbolBinding::resolve(df, *(leaf->lvalue.n));
+            leaf->bound.slot = df->symbols.slot(*(leaf->lvalue.n));
+        }
+        break;
+
+    case Leaf::Compound :
+        foreach(Leaf *p, *(leaf->lvalue.b)) bind(df, p);
+        break;
+
+    case Leaf::Operation:
+    case Leaf::BinaryOperation:
+    case Leaf::Logical :
+        bind(df, leaf->lvalue.l);
+        if (leaf->op) bind(df, leaf->rvalue.l);
+        break;
+
+    case Leaf::UnaryOperation:
+        bind(df, leaf->lvalue.l);
+        break;
+
+    case Leaf::Function:
+        leaf->builtin = builtinFor(df, leaf);
+        leaf->fnum = v4FunctionFor(leaf);
+        bind(df, leaf->lvalue.l);
+        bind(df, leaf->series);
+        foreach(Leaf* l, leaf->fparms) bind(df, l);
+        leaf->memo = memoised(df, leaf) ? leaf->signature() : QString();
+        break;
+
+    case Leaf::Index:
+    case Leaf::Select:
+        bind(df, leaf->lvalue.l);
+        foreach(Leaf* l, leaf->fparms) bind(df, l);
+        break;
+
+    case Leaf::Conditional:
+        bind(df, leaf->cond.l);
+        bind(df, leaf->lvalue.l);
+        bind(df, leaf->rvalue.l);
+        break;
+
+    default:
+        break;
+    }
+}
+
+SymbolBinding
+SymbolBinding::resolve(DataFilterRuntime *df, const QString &symbol)
+{
+    SymbolBinding returning;
+
+    // ride series name when running through samples
+    if (df->dataSeriesSymbols.contains(symbol)) returning.series = RideFile::seriesForSymbol(symbol);
+
+    if (symbol == "i") returning.kind = Iteration;
+    else if (symbol == "x") returning.kind = X;
+    else if (symbol == "isRide") returning.kind = IsRide;
+    else if (symbol == "isRun") returning.kind = IsRun;
+    else if (symbol == "isSwim") returning.kind = IsSwim;
+    else if (symbol == "isXtrain") returning.kind = IsXtrain;
+    else if (symbol == "isAero") returning.kind = IsAero;
+    else if (!symbol.compare("NA", Qt::CaseInsensitive)) returning.kind = NA;
+    else if (!symbol.compare("RECINTSECS", Qt::CaseInsensitive)) returning.kind = RecIntSecs;
+    else if (!symbol.compare("Current", Qt::CaseInsensitive)) returning.kind = Current;
+    else if (!symbol.compare("Today", Qt::CaseInsensitive)) returning.kind = Today;
+    else if (!symbol.compare("Date", Qt::CaseInsensitive)) returning.kind = Date;
+    else if (!symbol.compare("Time", Qt::CaseInsensitive)) returning.kind = Time;
+    else if (!symbol.compare("Planned", Qt::CaseInsensitive)) returning.kind = Planned;
+    else if (!symbol.compare("ctl", Qt::CaseInsensitive)) returning.kind = CTL;
+    else if (!symbol.compare("atl", Qt::CaseInsensitive)) returning.kind = ATL;
+    else if (!symbol.compare("tsb", Qt::CaseInsensitive)) returning.kind = TSB;
+    else {
+        // metric or metadata, the technical name is looked up once
+        returning.kind = df->lookupType.value(symbol) ? Number : Text;
+        returning.field = df->lookupMap.value(symbol, "");
+        if (returning.kind == Number) {
+            const RideMetric *metric = RideMetricFactory::instance().rideMetric(returning.field);
+            if (metric) returning.metric = metric->index();
+        }
+    }
+    return returning;
+}
+
+int
+DataFilterSymbols::slot(const QString &name)
+{
+    int returning = index.value(name, -1);
+    if (returning < 0) {
+        returning = values.count();
+        index.insert(name, returning);
+        values << Result();
+        set << false;
+    }
+    return returning;
+}
+
+QStringList
+DataFilterSymbols::keys() const
+{
+    QStringList returning;
+    QHashIterator<QString, int> i(index);
+    while (i.hasNext()) {
+        i.next();
+        if (set[i.value()]) returning << i.key();
+    }
+    return returning;
+}
+
+DataFilter::DataFilter(QObject *parent, Context *context) : QObject(parent), context(context), binding(QReadWriteLock::Recursive), treeRoot(NULL), concurrent(false), parent_(parent)
 {
     // let folks know who owns this rumtime for signalling
     rt.owner = this;
@@ -3282,7 +3658,7 @@ DataFilter::DataFilter(QObject *parent, Context *context) : QObject(parent), con
     //connect(context, SIGNAL(rideSelected(RideItem*)), this, SLOT(dynamicParse()));
 }
 
-DataFilter::DataFilter(QObject *parent, Context *context, QString formula) : QObject(parent), context(context), treeRoot(NULL), parent_(parent)
+DataFilter::DataFilter(QObject *parent, Context *context, QString formula) : QObject(parent), context(context), binding(QReadWriteLock::Recursive), treeRoot(NULL), concurrent(false), parent_(parent)
 {
     // let folks know who owns this rumtime for signalling
     rt.owner = this;
@@ -3322,6 +3698,7 @@ DataFilter::DataFilter(QObject *parent, Context *context, QString formula) : QOb
         treeRoot=NULL;
 
     errors = DataFiltererrors;
+    compile();
 }
 
 Result DataFilter::evaluate(RideItem *item, RideFilePoint *p)
@@ -3461,23 +3838,14 @@ QStringList DataFilter::parseFilter(Context *context, QString query, QStringList
     } else { // yep! .. we have a winner!
 
         rt.isdynamic = treeRoot->isDynamic(treeRoot);
+        compile();
 
         // successfully parsed, lets check semantics
         //treeRoot->print(0,NULL);
         emit parseGood();
 
-        // clear current filter list
-        filenames.clear();
-
-        // get all fields...
-        foreach(RideItem *item, context->athlete->rideCache->rides()) {
-
-            // evaluate each ride...
-            Result result = treeRoot->eval(&rt, treeRoot, Result(0), 0,item, NULL);
-            if (result.isNumber && result.number()) {
-                filenames << item->fileName;
-            }
-        }
+        // evaluate each ride
+        filterRides();
         emit results(filenames);
         if (list) *list = filenames;
     }
@@ -3491,20 +3859,123 @@ DataFilter::dynamicParse()
 {
     if (rt.isdynamic) {
         // need to reapply on current state
+        filterRides();
+        emit results(filenames);
+        if (list) *list = filenames;
+    }
+}
 
-        // clear current filter list
-        filenames.clear();
+void
+DataFilter::filterRides()
+{
+    // clear current filter list
+    filenames.clear();
+
+    // get all fields...
+    const QVector<RideItem*> &rides = context->athlete->rideCache->rides();
+    QVector<Result> results = evaluate(rides, treeRoot);
+    for (int i=0; i<rides.count(); i++) {
+        if (results[i].isNumber && results[i].number())
+            filenames << rides[i]->fileName;
+    }
+}
+
+QVector<Result>
+DataFilter::evaluate(const QVector<RideItem*> &rides)
+{
+    if (!treeRoot || errors.count()) return QVector<Result>(rides.count(), Result(0));
 
-        // get all fields...
-        foreach(RideItem *item, context->athlete->rideCache->rides()) {
+    // if we are a set of functions start at main
+    if (rt.functions.count()) return evaluate(rides, rt.functions.value("main", NULL));
+    return evaluate(rides, treeRoot);
+}
 
-            // evaluate each ride...
-            Result result = treeRoot->eval(&rt, treeRoot, Result(0), 0, item, NULL);
-            if (result.isNumber && result.number())
-                filenames << item->fileName;
+QVector<Result>
+DataFilter::evaluate(const QVector<RideItem*> &rides, Leaf *start)
+{
+    QVector<Result> returning(rides.count(), Result(0));
+    if (!start) return returning;
+
+    // reset stack
+    rt.stack = 0;
+
+    // side effects need the one runtime and the rides in order, and
+    // there's no point starting threads for a handful of rides
+    const int threads = QThreadPool::globalInstance()->maxThreadCount();
+    if (!concurrent || threads < 2 || rides.count() < 256) {
+        for (int i=0; i<rides.count(); i++)
+            returning[i] = treeRoot->eval(&rt, start, Result(0), 0, rides[i], NULL);
+        return returning;
+    }
+
+    // a few chunks per thread to even out rides that take longer,
+    // each with a copy of the runtime (the tree and programs are
+    // shared, they don't change when evaluated)
+    struct Chunk {
+        int from, to;
+        DataFilterRuntime rt;
+    };
+    const int size = qMax(64, (rides.count() + (threads * 4) - 1) / (threads * 4));
+    QVector<Chunk> chunks;
+    for (int from=0; from < rides.count(); from += size) {
+        Chunk chunk;
+        chunk.from = from;
+        chunk.to = qMin(from + size, rides.count());
+        chunk.rt = rt;
+        chunk.rt.lastindex = -1;
+        chunks << chunk;
+    }
+
+    // each chunk writes its own results, so they are in ride order
+    Leaf *root = treeRoot;
+    Result *out = returning.data();
+    QThread *thread = QThread::currentThread();
+    QtConcurrent::blockingMap(chunks, [root, start, &rides, out, thread] (Chunk &chunk) {
+        for (int i=chunk.from; i<chunk.to; i++) {
+            RideItem *item = rides[i];
+            bool open = item->isOpen();
+
+            out[i] = root->eval(&chunk.rt, start, Result(0), 0, item, NULL);
+
+            // a ride opened to get at samples is left open as it
+            // would be when evaluated serially, so belongs to the caller
+            if (!open && item->isOpen()) item->ride(false)->moveToThread(thread);
         }
-        emit results(filenames);
-        if (list) *list = filenames;
+    });
+    return returning;
+}
+
+void
+DataFilter::compile()
+{
+    if (!treeRoot || DataFiltererrors.count()) return;
+
+    // resolve symbols first, the programs load them by slot
+    treeRoot->bind(&rt, treeRoot);
+
+    // fold constants, drop dead branches and hoist out of sample()
+    optimized = DataFilterOptimizer::optimize(&rt, treeRoot);
+
+    // the root and the functions it declares, when they are called
+    // by name the tree interpreter hands over to the program
+    QList<Leaf*> entries;
+    entries << treeRoot;
+    if (treeRoot->type == Leaf::Compound) {
+        foreach(Leaf *statement, *(treeRoot->lvalue.b))
+            if (statement->type == Leaf::Compound && statement->function != "") entries << statement;
+    }
+
+    foreach(Leaf *leaf, entries)
+        if (!leaf->program) leaf->program = DataFilterProgram::compile(&rt, leaf);
+
+    // can rides be evaluated alongside each other?
+    QSet<Leaf*> visited;
+    concurrent = readOnly(&rt, treeRoot, visited);
+
+    // user charts and metrics call sample() for every sample
+    if (rt.functions.value("sample") && entries.contains(rt.functions.value("sample"))) {
+        Leaf *sample = rt.functions.value("sample");
+        if (!sample->batch) sample->batch = DataFilterBatch::compile(&rt, sample);
     }
 }
 
@@ -3517,11 +3988,16 @@ void DataFilter::clearFilter()
         errors.clear();
     }
     rt.isdynamic = false;
+    concurrent = false;
+    optimized = DataFilterOptimizer::Stats();
     sig = "";
 }
 
 void DataFilter::configChanged(qint32)
 {
+    // wait for any user metric computes to finish with the tree
+    QWriteLocker locker(&binding);
+
     rt.lookupMap.clear();
     rt.lookupType.clear();
 
@@ -3553,8 +4029,13 @@ void DataFilter::configChanged(qint32)
 
     // sample date series
     rt.dataSeriesSymbols = RideFile::symbols();
+
+    // metric and metadata fields may have changed
+    if (treeRoot && errors.isEmpty()) treeRoot->bind(&rt, treeRoot);
 }
 
+thread_local qint64 Result::allocations = 0;
+
 void
 Result::vectorize(int count)
 {
@@ -3600,11 +4081,335 @@ static int monthsTo(QDate from, QDate to)
     return months;
 }
 
+// the binary arithmetic, comparison and string operators, shared
+// with compiled programs so both engines have the same semantics
+Leaf::MathFunction Leaf::mathFunction(Leaf *leaf)
+{
+    // must be bound, the name could be a user function
+    if (leaf->type != Leaf::Function || leaf->builtin != DF_none || leaf->fparms.count() != 1) return NULL;
+    return mathFunctionFor(leaf->fnum);
+}
+
+Result Leaf::apply(MathFunction func, Result &v)
+{
+    Result returning(0);
+    if (v.asNumeric().count()) {
+        for(int i=0; i<v.asNumeric().count(); i++) {
+            double r = func(v.asNumeric()[i]);
+            returning.asNumeric() << r;
+            returning.number() += r;
+        }
+    } else {
+        returning.number() =  func(v.number());
+    }
+    return returning;
+}
+
+Result Leaf::index(Result &value, Result &index)
+{
+    // are we returning the value or a vector of values?
+    if (index.asNumeric().count()) {
+
+        Result returning(0);
+        if (!value.isNumber) returning.isNumber = false;
+
+        // a range
+        for(int i=0; i<index.asNumeric().count(); i++) {
+            int ii=index.asNumeric()[i];
+
+            // ignore out of bounds
+            if (ii < 0 || (value.isNumber && ii >= value.asNumeric().count()) || (!value.isNumber && ii >= value.asString().count())) continue;
+
+            if (value.isNumber) {
+                // numbers do sum
+                returning.asNumeric() << value.asNumeric()[ii];
+                returning.number() += value.asNumeric()[ii];
+            } else {
+                returning.asString() << value.asString()[ii];
+            }
+        }
+
+        return returning;
+
+    } else {
+        // a single value
+        if (value.isNumber) {
+            if (index.number() < 0 || index.number() >= value.asNumeric().count()) return Result(0);
+            return Result(value.asNumeric()[index.number()]);
+        } else {
+            if (index.number() < 0 || index.number() >= value.asString().count()) return Result("");
+            return Result(value.asString()[index.number()]);
+
+        }
+    }
+}
+
+int DataFilterRuntime::indexOf(RideFile *ride, RideFilePoint *p)
+{
+    const QVector<RideFilePoint*> &points = ride->dataPoints();
+    int next = lastindex + 1;
+    if (next < points.count() && points[next] == p) lastindex = next;
+    else if (lastindex < 0 || lastindex >= points.count() || points[lastindex] != p) lastindex = points.indexOf(p);
+    return lastindex;
+}
+
+Result Leaf::symbol(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, RideItem *m, RideFilePoint *p, const QHash<QString,RideMetric*> *c)
+{
+    // checked expressions are bound, resolve by name if not
+    SymbolBinding resolved;
+    if (leaf->bound.kind == SymbolBinding::Unbound) {
+        resolved = SymbolBinding::resolve(df, *(leaf->lvalue.n));
+        resolved.slot = df->symbols.find(*(leaf->lvalue.n));
+    }
+    const SymbolBinding &b = leaf->bound.kind == SymbolBinding::Unbound ? resolved : leaf->bound;
+
+    // ride series name when running through sample override metrics etc
+    if (p && b.series != RideFile::none) {
+        if (b.series == RideFile::index) return Result(df->indexOf(m->ride(), p));
+        return Result(p->value(b.series));
+    }
+
+    // user defined symbols override all others !
+    if (df->symbols.isSet(b.slot)) return df->symbols.at(b.slot);
+
+    switch (b.kind) {
+
+    case SymbolBinding::Iteration: return Result(it);
+    case SymbolBinding::X: return x.isNumber ? Result(Result(x).number()) : Result(Result(x).string());
+    case SymbolBinding::IsRide: return Result(m->isBike ? 1 : 0);
+    case SymbolBinding::IsRun: return Result(m->isRun ? 1 : 0);
+    case SymbolBinding::IsSwim: return Result(m->isSwim ? 1 : 0);
+    case SymbolBinding::IsXtrain: return Result(m->isXtrain ? 1 : 0);
+    case SymbolBinding::IsAero: return Result(m->isAero ? 1 : 0);
+    case SymbolBinding::NA: return Result(RideFile::NA);
+
+    case SymbolBinding::RecIntSecs:
+        if (m->ride(false)) return Result(m->ride(false)->recIntSecs());
+        return Result(1); // if in doubt
+
+    case SymbolBinding::Current:
+        if (m->context->currentRideItem())
+            return Result(QDate(1900,01,01).daysTo(m->context->currentRideItem()->dateTime.date()));
+        return Result(0);
+
+    case SymbolBinding::Today: return Result(QDate(1900,01,01).daysTo(QDate::currentDate()));
+    case SymbolBinding::Date: return Result(QDate(1900,01,01).daysTo(m->dateTime.date()));
+    case SymbolBinding::Time: return Result(QTime(0,0,0).secsTo(m->dateTime.time()));
+    case SymbolBinding::Planned: return Result(m->planned);
+
+    case SymbolBinding::CTL:
+    case SymbolBinding::ATL:
+    case SymbolBinding::TSB:
+        {
+            // a coggan PMC metric
+            PMCData *pmcData = m->context->athlete->getPMCFor("coggan_tss");
+            if (b.kind == SymbolBinding::CTL) return Result(pmcData->lts(m->dateTime.date()));
+            if (b.kind == SymbolBinding::ATL) return Result(pmcData->sts(m->dateTime.date()));
+            return Result(pmcData->sb(m->dateTime.date()));
+        }
+
+    case SymbolBinding::Number:
+        {
+            // check metadata string to number first ...
+            QString meta = m->getText(b.field, "unknown");
+            if (meta != "unknown") return Result(meta.toDouble());
+            if (c) return Result(RideMetric::getForSymbol(b.field, c));
+
+            // precomputed metric by index, as RideItem::getForSymbol
+            const QVector<double> &metrics = m->metrics();
+            if (b.metric >= 0 && metrics.count() && metrics.count() == RideMetricFactory::instance().metricCount())
+                return Result(metrics[b.metric]);
+            return Result(0);
+        }
+
+    default:
+        // string symbol will evaluate to zero as unary expression
+        return Result(m->getText(b.field, ""));
+    }
+}
+
+Result Leaf::operate(int op, Result &lhs, Result &rhs)
+{
+    switch (op) {
+
+    // basic operations should all work with vectors or numbers
+    case ADD:
+    case SUBTRACT:
+    case DIVIDE:
+    case MULTIPLY:
+    case POW:
+    {
+        Result returning(0);
+
+        // only if numberic on both sides
+        if (lhs.isNumber && rhs.isNumber) {
+
+
+            // its a vector operation... (asNumeric would allocate for a number)
+            if (lhs.isVector() || rhs.isVector()) {
+
+                int size = lhs.asNumeric().count() > rhs.asNumeric().count() ? lhs.asNumeric().count() : rhs.asNumeric().count();
+
+                // coerce both into a vector of matching size
+                lhs.vectorize(size);
+                rhs.vectorize(size);
+
+                for(int i=0; i<size; i++) {
+                    double left = lhs.asNumeric()[i];
+                    double right = rhs.asNumeric()[i];
+                    double value = 0;
+
+                    switch (op) {
+                    case ADD: value = left + right; break;
+                    case SUBTRACT: value = left - right; break;
+                    case DIVIDE: value = right ? left / right : 0; break;
+                    case MULTIPLY: value = left * right; break;
+                    case POW: value = pow(left,right); break;
+                    }
+                    returning.asNumeric() << value;
+                    returning.number() += value;
+                }
+
+            } else {
+                switch (op) {
+                case ADD: returning.number() = lhs.number() + rhs.number(); break;
+                case SUBTRACT: returning.number() = lhs.number() - rhs.number(); break;
+                case DIVIDE: returning.number() = rhs.number() ? lhs.number() / rhs.number() : 0; break;
+                case MULTIPLY: returning.number() = lhs.number() * rhs.number(); break;
+                case POW: returning.number() = pow(lhs.number(), rhs.number()); break;
+                }
+            }
+        } else {
+
+            // either the left or rhs is not a number, it is a string
+            // so we need to return a string result
+            returning.isNumber = false;
+
+            // basically add is the only meaningful operation to apply
+            // to string values; for vectors append, for string just concatenate
+            if (op == ADD) {
+                if (lhs.isVector() || rhs.isVector()) {
+
+                    // create a bigger vector
+                    if (lhs.isVector()) returning.asString() << lhs.asString();
+                    else returning.asString() << lhs.string();
+                    if (rhs.isVector()) returning.asString() << rhs.asString();
+                    else returning.asString() << rhs.string();
+
+                } else {
+                    // cat strings
+                    returning.string() = lhs.string() + rhs.string();
+                }
+            } else {
+                // just return the lhs
+                returning = lhs;
+            }
+        }
+        return returning;
+    }
+    break;
+
+    case EQ:
+    {
+        if (lhs.isNumber) return Result(lhs.number() == rhs.number());
+        else return Result(lhs.string() == rhs.string());
+    }
+    break;
+
+    case NEQ:
+    {
+        if (lhs.isNumber) return Result(lhs.number() != rhs.number());
+        else return Result(lhs.string() != rhs.string());
+    }
+    break;
+
+    case LT:
+    {
+        if (lhs.isNumber) return Result(lhs.number() < rhs.number());
+        else return Result(lhs.string() < rhs.string());
+    }
+    break;
+    case LTE:
+    {
+        if (lhs.isNumber) return Result(lhs.number() <= rhs.number());
+        else return Result(lhs.string() <= rhs.string());
+    }
+    break;
+    case GT:
+    {
+        if (lhs.isNumber) return Result(lhs.number() > rhs.number());
+        else return Result(lhs.string() > rhs.string());
+    }
+    break;
+    case GTE:
+    {
+        if (lhs.isNumber) return Result(lhs.number() >= rhs.number());
+        else return Result(lhs.string() >= rhs.string());
+    }
+    break;
+
+    case MATCHES:
+        if (!lhs.isNumber && !rhs.isNumber) return Result(QRegExp(rhs.string()).exactMatch(lhs.string()));
+        else return Result(false);
+        break;
+
+    case ENDSWITH:
+        if (!lhs.isNumber && !rhs.isNumber) return Result(lhs.string().endsWith(rhs.string()));
+        else return Result(false);
+        break;
+
+    case BEGINSWITH:
+        if (!lhs.isNumber && !rhs.isNumber) return Result(lhs.string().startsWith(rhs.string()));
+        else return Result(false);
+        break;
+
+    case CONTAINS:
+        {
+        if (!lhs.isNumber && !rhs.isNumber) {
+            if (lhs.isVector()) return Result(lhs.asString().contains(rhs.string()));
+            else return Result(lhs.string().contains(rhs.string()) ? true : false);
+        } else return Result(false);
+        }
+        break;
+
+    default:
+        break;
+    }
+    return Result(0);
+}
+
 Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, RideItem *m, RideFilePoint *p, const QHash<QString,RideMetric*> *c, const  Specification &s, const DateRange &d)
 {
     // Avoid crash on NULL leaf
     if (!leaf) return Result(0);
 
+    // record the call, then evaluate it as usual
+    if (df->profile && leaf != df->profiling && DataFilterProfile::profiled(leaf)) {
+        Leaf *profiling = df->profiling;
+        df->profiling = leaf;
+        df->profile->enter(DataFilterProfile::name(leaf));
+        Result returning = eval(df, leaf, x, it, m, p, c, s, d);
+        df->profile->leave();
+        df->profiling = profiling;
+        return returning;
+    }
+
+    // roots and functions are compiled
+    if (leaf->program && !df->interpret) return leaf->program->run(df, x, it, m, p, c, s, d);
+
+    // the same for every sample of the ride, so only computed for the first,
+    // without the sample so it isn't looked up again (it doesn't depend on it)
+    if (leaf->invariant && p && !df->interpret && leaf->invariant <= df->invariants.count()) {
+        if (m != df->invariantsFor || c != df->invariantsWith) df->resetInvariants(m, c);
+
+        int i = leaf->invariant - 1;
+        if (!df->known[i]) {
+            df->invariants[i] = eval(df, leaf, x, it, m, NULL, c, s, d);
+            df->known[i] = true;
+        }
+        return df->invariants[i];
+    }
+
     switch(leaf->type) {
 
     //
@@ -3646,9 +4451,16 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
     {
         double duration;
 
+        // what is being called is bound once validated, look it up if not
+        int builtin = leaf->builtin, fnum = leaf->fnum;
+        if (builtin < 0) {
+            builtin = builtinFor(df, leaf);
+            fnum = v4FunctionFor(leaf);
+        }
+
         // calling a user defined function (but don't call user defined count in user metrics)
         // terrible design mistake using "count" as a user defined function for user metrics. Sorry.
-        if (leaf->function != "count" && df->functions.contains(leaf->function)) {
+        if (builtin == DF_user) {
 
             // going down
             df->stack += 1;
@@ -3668,16 +4480,47 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             return res;
         }
 
-        if (leaf->function == "isNumber") {
+        // the athlete's memo (or the runtime's), computing it if it isn't there
+        DataFilterMemo *memo = NULL;
+        if (leaf->memo != "" && m && df->memoising != leaf) {
+            if (df->memo) memo = df->memo;
+            else if (m->context->athlete) memo = m->context->athlete->dfmemo;
+        }
+        if (memo) {
+
+            QString key = memoKey(df, leaf, x, it, m, p, c, s, d);
+            if (key != "") {
+                Result returning(0);
+                int generation;
+                if (memo->lookup(key, returning, generation)) return returning;
+
+                Leaf *memoising = df->memoising;
+                df->memoising = leaf;
+                returning = eval(df, leaf, x, it, m, p, c, s, d);
+                df->memoising = memoising;
+
+                memo->insert(key, returning, generation);
+                return returning;
+            }
+        }
+
+        switch (builtin) {
+
+        case DF_isNumber :
+        {
             return eval(df, leaf->fparms[0],x, it, m, p, c, s, d).isNumber;
         }
+        break;
 
-        if (leaf->function == "isString") {
+        case DF_isString :
+        {
             return !eval(df, leaf->fparms[0],x, it, m, p, c, s, d).isNumber;
         }
+        break;
 
         // coersion
-        if (leaf->function == "double") {
+        case DF_double :
+        {
 
             Result returning = eval(df, leaf->fparms[0],x, it, m, p, c, s, d);
 
@@ -3685,9 +4528,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             if (returning.isVector()) return returning.asNumeric();
             else return returning.number();
         }
+        break;
 
         // string functions
-        if (leaf->function == "tolower") {
+        case DF_tolower :
+        {
 
             Result returning = eval(df, leaf->fparms[0],x, it, m, p, c, s, d);
 
@@ -3704,8 +4549,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
-        if (leaf->function == "toupper") {
+        case DF_toupper :
+        {
 
             Result returning = eval(df, leaf->fparms[0],x, it, m, p, c, s, d);
 
@@ -3723,8 +4570,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             return returning;
 
         }
+        break;
 
-        if (leaf->function == "join") {
+        case DF_join :
+        {
 
             Result returning = eval(df, leaf->fparms[0],x, it, m, p, c, s, d);
             QString sep = eval(df, leaf->fparms[1],x, it, m, p, c, s, d).string();
@@ -3746,8 +4595,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
-        if (leaf->function == "split") {
+        case DF_split :
+        {
 
             Result returning = eval(df, leaf->fparms[0],x, it, m, p, c, s, d);
             QString sep = eval(df, leaf->fparms[1],x, it, m, p, c, s, d).string();
@@ -3765,8 +4616,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
-        if (leaf->function == "trim") {
+        case DF_trim :
+        {
 
             Result returning = eval(df, leaf->fparms[0],x, it, m, p, c, s, d);
 
@@ -3783,8 +4636,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
-        if (leaf->function == "replace") {
+        case DF_replace :
+        {
 
             Result returning = eval(df, leaf->fparms[0],x, it, m, p, c, s, d);
             QString s1 =  eval(df, leaf->fparms[1],x, it, m, p, c, s, d).string();
@@ -3803,16 +4658,21 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
-        if (leaf->function == "exists") {
+        case DF_exists :
+        {
             // get symbol name
             QString symbol =  *(leaf->fparms[0]->lvalue.s);
 
             // does it exist - as a function or symbol?
             return df->functions.contains(symbol) || df->symbols.contains(symbol);
         }
+        break;
 
-        if (leaf->function == "datestring" || leaf->function == "timestring") {
+        case DF_datestring :
+        case DF_timestring :
+        {
 
             Result returning;
 
@@ -3835,9 +4695,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
         // aggregate strings is easier to separate
-        if (leaf->function == "asaggstring") {
+        case DF_asaggstring :
+        {
 
             Result returning(0);
             returning.isNumber = false;
@@ -3865,8 +4727,12 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
-        if (leaf->function == "metricname" || leaf->function == "metricunit" || leaf->function == "asstring") {
+        case DF_metricname :
+        case DF_metricunit :
+        case DF_asstring :
+        {
 
             bool wantname = (leaf->function == "metricname");
             bool wantunit = (leaf->function == "metricunit");
@@ -3918,8 +4784,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             if (list.count() == 1) return Result(list[0]);
             else return Result(list);
         }
+        break;
 
-        if (leaf->function == "activities") {
+        case DF_activities :
+        {
 
             // filters activities using an expression, in the same way the
             // daterange function filters on date, in fact the daterange
@@ -3940,19 +4808,20 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             // get a filter list
             QStringList filters;
-            foreach(RideItem *ride, m->context->athlete->rideCache->rides()) {
-
-                Result r = filter.evaluate(ride, NULL);
-                if (r.number()) filters << ride->fileName;
-            }
+            const QVector<RideItem*> &rides = m->context->athlete->rideCache->rides();
+            QVector<Result> results = filter.evaluate(rides);
+            for (int i=0; i<rides.count(); i++)
+                if (results[i].number()) filters << rides[i]->fileName;
             Specification spec = s;
             spec.addMatches(filters);
 
             // now evaluate- but using an updated specification
             return  eval(df, leaf->fparms[1],x, it, m, p, c, spec, d);
         }
+        break;
 
-        if (leaf->function == "daterange") {
+        case DF_daterange :
+        {
 
             // cannot get a context via ride as none selected or available
             if (m == NULL) return Result(0);
@@ -3983,8 +4852,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return Result(0);
         }
+        break;
 
-        if (leaf->function == "config") {
+        case DF_config :
+        {
             //
             // Get CP and W' for date of ride
             //
@@ -4111,9 +4982,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
                 return Result(SEX);
             }
         }
+        break;
 
         // zone descriptions and high / lows, but not cp/cv, w'/d' et al
-        if (leaf->function == "zones") {
+        case DF_zones :
+        {
             // parms
             QString series = *leaf->fparms[0]->lvalue.n;
             QString field = *leaf->fparms[1]->lvalue.n;
@@ -4272,9 +5145,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             // returning what was collected
             return Result(strings);
         }
+        break;
 
         // bool(expr) - convert to boolean
-        if (leaf->function == "bool") {
+        case DF_bool :
+        {
             Result r=eval(df, leaf->fparms[0],x, it, m, p, c, s, d);
             if (r.isVector()) {
                 Result returning;
@@ -4289,9 +5164,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
                 else return Result(0);
             }
         }
+        break;
 
         // string(expr) convert to string
-        if (leaf->function == "string") {
+        case DF_string :
+        {
             Result r=eval(df, leaf->fparms[0],x, it, m, p, c, s, d);
 
             if (r.isNumber) {
@@ -4309,13 +5186,15 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return r; // just return what it is
         }
+        break;
 
         // c (concat into a vector)
         // since we now support string and numeric values and vectors
         // we create a numeric vector by default.
         // If any values are found that are strings we convert all values
         // to strings avoid double looping
-        if (leaf->function == "c") {
+        case DF_c :
+        {
 
             // the return value of a vector is always its sum
             // so we need to keep that up to date too
@@ -4346,8 +5225,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
-        if (leaf->function == "pdfbeta") {
+        case DF_pdfbeta :
+        {
 
             Result returning(0);
             double a= eval(df, leaf->fparms[0],x, it, m, p, c, s, d).number();
@@ -4367,8 +5248,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
-        if (leaf->function == "cdfbeta") {
+        case DF_cdfbeta :
+        {
 
             Result returning(0);
             double a= eval(df, leaf->fparms[0],x, it, m, p, c, s, d).number();
@@ -4388,8 +5271,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
-        if (leaf->function == "pdfgamma") {
+        case DF_pdfgamma :
+        {
 
             Result returning(0);
             double a= eval(df, leaf->fparms[0],x, it, m, p, c, s, d).number();
@@ -4409,8 +5294,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
-        if (leaf->function == "cdfgamma") {
+        case DF_cdfgamma :
+        {
 
             Result returning(0);
             double a= eval(df, leaf->fparms[0],x, it, m, p, c, s, d).number();
@@ -4430,8 +5317,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
-        if (leaf->function == "cdfnormal") {
+        case DF_cdfnormal :
+        {
 
             Result returning(0);
             double sigma= eval(df, leaf->fparms[0],x, it, m, p, c, s, d).number();
@@ -4450,8 +5339,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
-        if (leaf->function == "pdfnormal") {
+        case DF_pdfnormal :
+        {
 
             Result returning(0);
             double sigma= eval(df, leaf->fparms[0],x, it, m, p, c, s, d).number();
@@ -4470,9 +5361,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
         // seq
-        if (leaf->function == "seq") {
+        case DF_seq :
+        {
             Result returning(0);
 
             double start= eval(df, leaf->fparms[0],x, it, m, p, c, s, d).number();
@@ -4501,9 +5394,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             // sequence
             return returning;
         }
+        break;
 
         // rep
-        if (leaf->function == "rep") {
+        case DF_rep :
+        {
             Result returning(0);
 
             Result value= eval(df, leaf->fparms[0],x, it, m, p, c, s, d);
@@ -4522,9 +5417,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
         // rev - reverse the vector
-        if (leaf->function == "rev") {
+        case DF_rev :
+        {
             Result returning(0);
             Result value= eval(df, leaf->fparms[0],x, it, m, p, c, s, d);
             if (value.isVector()) {
@@ -4544,16 +5441,20 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
         // length
-        if (leaf->function == "length") {
+        case DF_length :
+        {
             Result v = eval(df, leaf->fparms[0],x, it, m, p, c, s, d);
             if (v.isNumber) return Result(v.asNumeric().count());
             else return Result(v.asString().count());
         }
+        break;
 
         // cumsum
-        if (leaf->function == "cumsum") {
+        case DF_cumsum :
+        {
             Result returning(0);
 
             Result v = eval(df, leaf->fparms[0],x, it, m, p, c, s, d);
@@ -4567,9 +5468,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
         // bin
-        if (leaf->function == "bin") {
+        case DF_bin :
+        {
             // parm 1 - values
             // parm 2 - bins
             // values and bins must contain > 1 entry ! (returns 0 otherwise)
@@ -4601,9 +5504,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
         // aggregate
-        if (leaf->function == "aggregate") {
+        case DF_aggregate :
+        {
 
             // returns an aggregated vector, using by as the group by value
             // and func defines how we aggregate
@@ -4683,9 +5588,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
         // append
-        if (leaf->function == "append") {
+        case DF_append :
+        {
 
             // append (symbol, stuff, pos)
 
@@ -4741,9 +5648,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return Result(current.asNumeric().count());
         }
+        break;
 
         // remove
-        if (leaf->function == "remove") {
+        case DF_remove :
+        {
 
             // remove (symbol, pos, count)
 
@@ -4774,9 +5683,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return Result(current.isNumber ? current.asNumeric().count() : current.asString().count());
         }
+        break;
 
         // mid
-        if (leaf->function == "mid") {
+        case DF_mid :
+        {
 
             Result returning(0);
 
@@ -4806,8 +5717,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
-        if (leaf->function == "xdata") {
+        case DF_xdata :
+        {
             Result returning(0);
 
             QString name = *(leaf->fparms[0]->lvalue.s);
@@ -4851,8 +5764,12 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
-        if (leaf->function == "xdataseries" || leaf->function == "xdataunits" || leaf->function=="xdatavalues") {
+        case DF_xdataseries :
+        case DF_xdataunits :
+        case DF_xdatavalues :
+        {
             Result returning(0);
 
             QString name = *(leaf->fparms[0]->lvalue.s);
@@ -4887,8 +5804,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
-        if (leaf->function == "samples") {
+        case DF_samples :
+        {
 
             // nothing to return -- note we check if the ride is open
             // this is to avoid misuse outside of a filter when working
@@ -4935,8 +5854,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
                 return returning;
             }
         }
+        break;
 
-        if (leaf->function == "metadata") {
+        case DF_metadata :
+        {
 
             Result returning("");
             returning.isNumber = false;
@@ -4972,8 +5893,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
-        if (leaf->function == "completervalues") {
+        case DF_completervalues :
+        {
 
             // get the metadata completer values for the specified field name
             Result returning("");
@@ -4991,11 +5914,13 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
         // normalize values to between 0 and 1
         // use when generating a heatmap in a data overview table
         // but potentially for other things in the future
-        if (leaf->function == "normalize") {
+        case DF_normalize :
+        {
 
             Result min =  eval(df, leaf->fparms[0],x, it, m, p, c, s, d);
             Result max =  eval(df, leaf->fparms[1],x, it, m, p, c, s, d);
@@ -5013,8 +5938,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
-        if (leaf->function == "filename") {
+        case DF_filename :
+        {
 
             Result returning("");
             returning.isNumber = false;
@@ -5047,8 +5974,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
-        if (leaf->function == "linked") {
+        case DF_linked :
+        {
 
             Result returning("");
             returning.isNumber = false;
@@ -5081,8 +6010,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
-        if (leaf->function == "kmeans") {
+        case DF_kmeans :
+        {
             // kmeans(centers|assignments, k, dim1, dim2, dim3)
 
             Result returning(0);
@@ -5108,9 +6039,13 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
-        if (leaf->function == "metrics" || leaf->function == "metricstrings" ||
-            leaf->function == "aggmetrics" || leaf->function == "aggmetricstrings") {
+        case DF_metrics :
+        case DF_metricstrings :
+        case DF_aggmetrics :
+        case DF_aggmetricstrings :
+        {
 
             bool wantstrings = (leaf->function.endsWith("strings"));
             QDate earliest(1900,01,01);
@@ -5251,8 +6186,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
-        if (leaf->function == "intervals" || leaf->function == "intervalstrings") {
+        case DF_intervals :
+        case DF_intervalstrings :
+        {
 
             bool currentride = false;
             bool wantstrings = (leaf->function == "intervalstrings");
@@ -5379,8 +6317,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
-        if (leaf->function == "events") {
+        case DF_events :
+        {
 
             // symbol determines what to return
             QString symbol = *(leaf->fparms[0]->lvalue.n);
@@ -5413,9 +6353,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
         // measures
-        if (leaf->function == "measures") {
+        case DF_measures :
+        {
 
             Result returning(0);
             QDate earliest(1900,01,01);
@@ -5459,9 +6401,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
         // retrieve best meanmax effort for a given duration and daterange
-        if (leaf->function == "bests") {
+        case DF_bests :
+        {
 
             if (m == NULL) return Result(0); // no ride then no context
 
@@ -5518,9 +6462,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             return returning;
 
         }
+        break;
 
         // meanmax array
-        if (leaf->function == "meanmax") {
+        case DF_meanmax :
+        {
 
             if (m == NULL) return Result(0); // no ride then no context
 
@@ -5795,9 +6741,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             // return a vector
             return returning;
         }
+        break;
 
         // interpolation
-        if (leaf->function == "interpolate") {
+        case DF_interpolate :
+        {
 
             // interpolate(algo, xvector, yvector, xvalues) - returns yvalues for each xvalue
             Result returning(0);
@@ -5838,9 +6786,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
 
-        if (leaf->function == "resample") {
+        case DF_resample :
+        {
 #ifdef GC_HAVE_SAMPLERATE
 
             Result returning(0);
@@ -5905,9 +6855,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             return Result(-1); // nothing resampled
 #endif
         }
+        break;
 
         // distribution
-        if (leaf->function == "dist") {
+        case DF_dist :
+        {
 
             if (m == NULL) return Result(0); // no ride then no context
 
@@ -5956,9 +6908,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
         // argsort
-        if (leaf->function == "argsort") {
+        case DF_argsort :
+        {
             Result returning(0);
 
             // ascending or descending?
@@ -5979,9 +6933,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
         // rank
-        if (leaf->function == "rank") {
+        case DF_rank :
+        {
             Result returning(0);
 
             // ascending or descending?
@@ -6000,9 +6956,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
         // sort
-        if (leaf->function == "sort") {
+        case DF_sort :
+        {
             Result returning(0);
 
             // ascending or descending?
@@ -6033,9 +6991,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
         // uniq - returns vector
-        if (leaf->function == "uniq") {
+        case DF_uniq :
+        {
 
 
             // evaluate all the lists
@@ -6059,9 +7019,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
         // arguniq
-        if (leaf->function == "arguniq") {
+        case DF_arguniq :
+        {
             Result returning(0);
 
             // get vector and an argsort
@@ -6076,9 +7038,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
         // multiuniq
-        if (leaf->function == "multiuniq") {
+        case DF_multiuniq :
+        {
 
             // evaluate all the lists
             for(int i=0; i<leaf->fparms.count(); i++) eval(df, leaf->fparms[i],x, it, m, p, c, s, d);
@@ -6120,9 +7084,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return Result(count);
         }
+        break;
 
         // store/fetch from athlete storage
-        if (leaf->function == "store") {
+        case DF_store :
+        {
 
             if (m == NULL) return Result(0); // no ride then no context
 
@@ -6135,8 +7101,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return Result(0);
         }
+        break;
 
-        if (leaf->function == "fetch") {
+        case DF_fetch :
+        {
 
             if (m == NULL) return Result(0); // no ride then no context
 
@@ -6148,9 +7116,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
         // access user chart curve data, if it's there
-        if (leaf->function == "curve") {
+        case DF_curve :
+        {
 
             // not on a chart m8
             if (df->chart == NULL) return Result(0);
@@ -6170,9 +7140,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
         // lowerbound
-        if (leaf->function == "lowerbound") {
+        case DF_lowerbound :
+        {
 
             Result returning(-1);
 
@@ -6193,9 +7165,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
                 return Result(i - list.asString().begin());
             }
         }
+        break;
 
         // random
-        if (leaf->function == "random") {
+        case DF_random :
+        {
 
             int n= eval(df, leaf->fparms[0],x, it, m, p, c, s, d).number(); // how many ?
             Result returning(0);
@@ -6210,9 +7184,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             return returning;
 
         }
+        break;
 
         // quantile
-        if (leaf->function == "quantile") {
+        case DF_quantile :
+        {
 
             Result         v= eval(df, leaf->fparms[0],x, it, m, p, c, s, d);
             Result quantiles= eval(df, leaf->fparms[1],x, it, m, p, c, s, d);
@@ -6243,9 +7219,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
         // sort
-        if (leaf->function == "multisort") {
+        case DF_multisort :
+        {
 
             // ascend/descend?
             QString symbol = *(leaf->fparms[0]->lvalue.n);
@@ -6291,8 +7269,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return Result(count);
         }
+        break;
 
-        if (leaf->function == "head") {
+        case DF_head :
+        {
 
             Result returning(0);
 
@@ -6314,8 +7294,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
-        if (leaf->function == "tail") {
+        case DF_tail :
+        {
 
             Result returning(0);
 
@@ -6337,9 +7319,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
         // sapply
-        if (leaf->function == "sapply") {
+        case DF_sapply :
+        {
             Result returning(0);
 
             Result value = eval(df,leaf->fparms[0],x, it, m, p, c, s, d); // lhs might also be a symbol
@@ -6365,9 +7349,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
         // match
-        if (leaf->function == "match") {
+        case DF_match :
+        {
 
             // for every value in vector 1 return the index for it
             // in vector 2, if it is not there then it will not be
@@ -6406,9 +7392,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
         // non-zero - return index to non-zero values
-        if (leaf->function == "nonzero") {
+        case DF_nonzero :
+        {
 
             Result returning(0);
             Result v = eval(df,leaf->fparms[0],x, it, m, p, c, s, d); // lhs might also be a symbol
@@ -6424,9 +7412,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
         // annotate
-        if (leaf->function == "annotate") {
+        case DF_annotate :
+        {
 
             QString type = *(leaf->fparms[0]->lvalue.n);
 
@@ -6509,9 +7499,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
 
         }
+        break;
 
         // smooth
-        if (leaf->function == "smooth") {
+        case DF_smooth :
+        {
 
             Result returning(0);
 
@@ -6543,9 +7535,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
         // levenberg-marquardt nls
-        if (leaf->function == "lm") {
+        case DF_lm :
+        {
             Result returning(0);
             returning.asNumeric() << 0 << -1 << -1 ; // assume failure
 
@@ -6586,9 +7580,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
         // linear regression
-        if (leaf->function == "lr") {
+        case DF_lr :
+        {
             Result returning(0);
             returning.asNumeric() << 0 << 0 << 0 << 0; // set slope, intercept, r2 and see to 0
 
@@ -6614,8 +7610,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
-        if (leaf->function == "mlr") {
+        case DF_mlr :
+        {
 
             // return
             Result returning(0);
@@ -6664,24 +7662,30 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
         // stddev
-        if (leaf->function == "variance") {
+        case DF_variance :
+        {
             // array
             Result v = eval(df,leaf->fparms[0],x, it, m, p, c, s, d);
             Statistic calc;
             return calc.variance(v.asNumeric(), v.asNumeric().count());
         }
+        break;
 
-        if (leaf->function == "stddev") {
+        case DF_stddev :
+        {
             // array
             Result v = eval(df,leaf->fparms[0],x, it, m, p, c, s, d);
             Statistic calc;
             return calc.standarddeviation(v.asNumeric(), v.asNumeric().count());
         }
+        break;
 
         // pmc
-        if (leaf->function == "pmc") {
+        case DF_pmc :
+        {
 
             if (m == NULL) return Result(0); // no ride then no context
 
@@ -6729,9 +7733,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
         // banister
-        if (leaf->function == "banister") {
+        case DF_banister :
+        {
 
             if (m == NULL) return Result(0); // no ride then no context
 
@@ -6770,9 +7776,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
         // date handling functions
-        if (leaf->function == "week") {
+        case DF_week :
+        {
 
             // convert number or vector of dates to weeks since 1900
             QDate earliest(1900,01,01);
@@ -6793,8 +7801,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
-        if (leaf->function == "weekdate") {
+        case DF_weekdate :
+        {
 
             // convert number or vector of dates to weeks since 1900
             QDate earliest(1900,01,01);
@@ -6815,7 +7825,9 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
-        if (leaf->function == "month") {
+        break;
+        case DF_month :
+        {
 
             // convert number or vector of dates to weeks since 1900
             QDate earliest(1900,01,01);
@@ -6836,8 +7848,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
-        if (leaf->function == "monthdate") {
+        case DF_monthdate :
+        {
 
             // convert number or vector of dates to weeks since 1900
             QDate earliest(1900,01,01);
@@ -6860,9 +7874,11 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
             return returning;
         }
+        break;
 
         // powerindex(power,duration) - return value or vector of values translating to powerindex
-        if (leaf->function == "powerindex") {
+        case DF_powerindex :
+        {
 
             Result returning(0);
             Result power = eval(df, leaf->fparms[0],x, it, m, p, c, s, d);
@@ -6880,9 +7896,12 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
         // get here for tiz and best
-        if (leaf->function == "best" || leaf->function == "tiz") {
+        case DF_best :
+        case DF_tiz :
+        {
 
             switch (leaf->lvalue.l->type) {
 
@@ -6941,8 +7960,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
                 return Result(RideFileCache::tiz(m->context, m->fileName, leaf->seriesType, duration));
             }
         }
+        break;
 
-        if (leaf->function == "round") {
+        case DF_round :
+        {
             // round(expr) or round(expr, dp)
             Result returning(0);
 
@@ -6964,23 +7985,13 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             }
             return returning;
         }
+        break;
 
-        // if we get here its general function handling
-        // what function is being called?
-        int fnum=-1;
-        for (int i=0; DataFilterFunctions[i].parameters != -1; i++) {
-            if (DataFilterFunctions[i].name == leaf->function) {
-
-                // parameter mismatch not allowed; function signature mismatch
-                // should be impossible...
-                if (DataFilterFunctions[i].parameters && DataFilterFunctions[i].parameters != leaf->fparms.count())
-                    fnum=-1;
-                else
-                    fnum = i;
-                break;
-            }
+        default:
+            break;
         }
 
+        // if we get here its general function handling
         // not found...
         if (fnum < 0) return Result(0);
 
@@ -6988,52 +7999,12 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             case 0 : case 1 : case 2: case 3: case 4: case 5: case 6: case 7: case 8: case 9: case 10:
             case 11 : case 12: case 13: case 14: case 15: case 16: case 18: case 19: case 20:
             {
-                Result returning(0);
-
-
                 // TRIG FUNCTIONS
 
                 // bit ugly but cleanest way of doing this without repeating
                 // looping stuff - we use a function pointer to save that...
-                double (*func)(double);
-                switch (fnum) {
-                default:
-                case 0: func = cos; break;
-                case 1 : func = tan; break;
-                case 2 : func = sin; break;
-                case 3 : func = acos; break;
-                case 4 : func = atan; break;
-                case 5 : func = asin; break;
-                case 6 : func = cosh; break;
-                case 7 : func = tanh; break;
-                case 8 : func = sinh; break;
-                case 9 : func = acosh; break;
-                case 10 : func = atanh; break;
-                case 11 : func = asinh; break;
-
-                case 12 : func = exp; break;
-                case 13 : func = log; break;
-                case 14 : func = log10; break;
-
-                case 15 : func = ceil; break;
-                case 16 : func = floor; break;
-
-                case 18 : func = fabs; break;
-                case 19 : func = Utils::myisinf; break;
-                case 20 : func = Utils::myisnan; break;
-                }
-
                 Result v = eval(df, leaf->fparms[0],x, it, m, p, c, s, d);
-                if (v.asNumeric().count()) {
-                    for(int i=0; i<v.asNumeric().count(); i++) {
-                        double r = func(v.asNumeric()[i]);
-                        returning.asNumeric() << r;
-                        returning.number() += r;
-                    }
-                } else {
-                    returning.number() =  func(v.number());
-                }
-                return returning;
+                return Leaf::apply(mathFunctionFor(fnum), v);
             }
             break;
 
@@ -7401,7 +8372,7 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
                             }
                         }
                     }
-                    return Result(returning);
+                    return returning;
                 }
                 break;
 
@@ -7899,128 +8870,8 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
     //
     case Leaf::Symbol :
     {
-        double lhsdouble=0.0f;
-        bool lhsisNumber=false;
-        QString lhsstring;
-        QString rename;
-        QString symbol = *(leaf->lvalue.n);
-
         if (m == NULL) return Result(0); // no ride then no context
-
-        // ride series name when running through sample override metrics etc
-        if (p && (lhsisNumber = df->dataSeriesSymbols.contains(*(leaf->lvalue.n))) == true) {
-
-            RideFile::SeriesType type = RideFile::seriesForSymbol((*(leaf->lvalue.n)));
-            if (type == RideFile::index) return Result(m->ride()->dataPoints().indexOf(p));
-            return Result(p->value(type));
-        }
-
-        // user defined symbols override all others !
-        if (df->symbols.contains(symbol)) return Result(df->symbols.value(symbol));
-
-        // is it isRun ?
-        if (symbol == "i") {
-
-            lhsdouble = it;
-            lhsisNumber = true;
-
-        } else if (symbol == "x") {
-
-            if (x.isNumber) {
-                lhsdouble = Result(x).number();
-                lhsisNumber = true;
-            } else {
-                lhsstring = Result(x).string();
-                lhsisNumber = false;
-            }
-
-        } else if (symbol == "isRide") {
-            lhsdouble = m->isBike ? 1 : 0;
-            lhsisNumber = true;
-
-        } else if (symbol == "isRun") {
-            lhsdouble = m->isRun ? 1 : 0;
-            lhsisNumber = true;
-
-        } else if (symbol == "isSwim") {
-            lhsdouble = m->isSwim ? 1 : 0;
-            lhsisNumber = true;
-
-        } else if (symbol == "isXtrain") {
-            lhsdouble = m->isXtrain ? 1 : 0;
-            lhsisNumber = true;
-
-        } else if (symbol == "isAero") {
-            lhsdouble = m->isAero ? 1 : 0;
-            lhsisNumber = true;
-
-        } else if (!symbol.compare("NA", Qt::CaseInsensitive)) {
-
-            lhsdouble = RideFile::NA;
-            lhsisNumber = true;
-
-        } else if (!symbol.compare("RECINTSECS", Qt::CaseInsensitive)) {
-
-            lhsdouble = 1; // if in doubt
-            if (m->ride(false)) lhsdouble = m->ride(false)->recIntSecs();
-            lhsisNumber = true;
-
-        } else if (!symbol.compare("Current", Qt::CaseInsensitive)) {
-
-            if (m->context->currentRideItem())
-                lhsdouble = QDate(1900,01,01).
-                daysTo(m->context->currentRideItem()->dateTime.date());
-            else
-                lhsdouble = 0;
-            lhsisNumber = true;
-
-        } else if (!symbol.compare("Today", Qt::CaseInsensitive)) {
-
-            lhsdouble = QDate(1900,01,01).daysTo(QDate::currentDate());
-            lhsisNumber = true;
-
-        } else if (!symbol.compare("Date", Qt::CaseInsensitive)) {
-
-            lhsdouble = QDate(1900,01,01).daysTo(m->dateTime.date());
-            lhsisNumber = true;
-
-        } else if (!symbol.compare("Time", Qt::CaseInsensitive)) {
-
-            lhsdouble = QTime(0,0,0).secsTo(m->dateTime.time());
-            lhsisNumber = true;
-
-        } else if (!symbol.compare("Planned", Qt::CaseInsensitive)) {
-
-            lhsdouble = m->planned;
-            lhsisNumber = true;
-
-        } else if (isCoggan(symbol)) {
-            // a coggan PMC metric
-            PMCData *pmcData = m->context->athlete->getPMCFor("coggan_tss");
-            if (!symbol.compare("ctl", Qt::CaseInsensitive)) lhsdouble = pmcData->lts(m->dateTime.date());
-            if (!symbol.compare("atl", Qt::CaseInsensitive)) lhsdouble = pmcData->sts(m->dateTime.date());
-            if (!symbol.compare("tsb", Qt::CaseInsensitive)) lhsdouble = pmcData->sb(m->dateTime.date());
-            lhsisNumber = true;
-
-        } else if ((lhsisNumber = df->lookupType.value(*(leaf->lvalue.n))) == true) {
-            // get symbol value
-            // check metadata string to number first ...
-            QString meta = m->getText(rename=df->lookupMap.value(symbol,""), "unknown");
-            if (meta == "unknown")
-                if (c) lhsdouble = RideMetric::getForSymbol(rename=df->lookupMap.value(symbol,""), c);
-                else lhsdouble = m->getForSymbol(rename=df->lookupMap.value(symbol,""));
-            else
-                lhsdouble = meta.toDouble();
-            lhsisNumber = true;
-
-            //qDebug()<<"symbol" << *(lvalue.n) << "is" << lhsdouble << "via" << rename;
-        } else {
-            // string symbol will evaluate to zero as unary expression
-            lhsstring = m->getText(rename=df->lookupMap.value(symbol,""), "");
-            //qDebug()<<"symbol" << *(lvalue.n) << "is" << lhsstring << "via" << rename;
-        }
-        if (lhsisNumber) return Result(lhsdouble);
-        else return Result(lhsstring);
+        return symbol(df, leaf, x, it, m, p, c);
     }
     break;
 
@@ -8096,8 +8947,7 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
                 if (leaf->lvalue.l->type == Leaf::Symbol) {
 
                     // update the symbol value
-                    QString symbol = *(leaf->lvalue.l->lvalue.n);
-                    df->symbols.insert(symbol, rhs);
+                    df->symbols.assign(leaf->lvalue.l->bound.slot, *(leaf->lvalue.l->lvalue.n), rhs);
 
                 } else {
 
@@ -8176,122 +9026,6 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
 
         break;
 
-        // basic operations should all work with vectors or numbers
-        case ADD:
-        case SUBTRACT:
-        case DIVIDE:
-        case MULTIPLY:
-        case POW:
-        {
-            Result returning(0);
-
-            // only if numberic on both sides
-            if (lhs.isNumber && rhs.isNumber) {
-
-
-                // its a vector operation...
-                if (lhs.asNumeric().count() || rhs.asNumeric().count()) {
-
-                    int size = lhs.asNumeric().count() > rhs.asNumeric().count() ? lhs.asNumeric().count() : rhs.asNumeric().count();
-
-                    // coerce both into a vector of matching size
-                    lhs.vectorize(size);
-                    rhs.vectorize(size);
-
-                    for(int i=0; i<size; i++) {
-                        double left = lhs.asNumeric()[i];
-                        double right = rhs.asNumeric()[i];
-                        double value = 0;
-
-                        switch (leaf->op) {
-                        case ADD: value = left + right; break;
-                        case SUBTRACT: value = left - right; break;
-                        case DIVIDE: value = right ? left / right : 0; break;
-                        case MULTIPLY: value = left * right; break;
-                        case POW: value = pow(left,right); break;
-                        }
-                        returning.asNumeric() << value;
-                        returning.number() += value;
-                    }
-
-                } else {
-                    switch (leaf->op) {
-                    case ADD: returning.number() = lhs.number() + rhs.number(); break;
-                    case SUBTRACT: returning.number() = lhs.number() - rhs.number(); break;
-                    case DIVIDE: returning.number() = rhs.number() ? lhs.number() / rhs.number() : 0; break;
-                    case MULTIPLY: returning.number() = lhs.number() * rhs.number(); break;
-                    case POW: returning.number() = pow(lhs.number(), rhs.number()); break;
-                    }
-                }
-            } else {
-
-                // either the left or rhs is not a number, it is a string
-                // so we need to return a string result
-                returning.isNumber = false;
-
-                // basically add is the only meaningful operation to apply
-                // to string values; for vectors append, for string just concatenate
-                if (leaf->op == ADD) {
-                    if (lhs.isVector() || rhs.isVector()) {
-
-                        // create a bigger vector
-                        if (lhs.isVector()) returning.asString() << lhs.asString();
-                        else returning.asString() << lhs.string();
-                        if (rhs.isVector()) returning.asString() << rhs.asString();
-                        else returning.asString() << rhs.string();
-
-                    } else {
-                        // cat strings
-                        returning.string() = lhs.string() + rhs.string();
-                    }
-                } else {
-                    // just return the lhs
-                    returning = lhs;
-                }
-            }
-            return returning;
-        }
-        break;
-
-        case EQ:
-        {
-            if (lhs.isNumber) return Result(lhs.number() == rhs.number());
-            else return Result(lhs.string() == rhs.string());
-        }
-        break;
-
-        case NEQ:
-        {
-            if (lhs.isNumber) return Result(lhs.number() != rhs.number());
-            else return Result(lhs.string() != rhs.string());
-        }
-        break;
-
-        case LT:
-        {
-            if (lhs.isNumber) return Result(lhs.number() < rhs.number());
-            else return Result(lhs.string() < rhs.string());
-        }
-        break;
-        case LTE:
-        {
-            if (lhs.isNumber) return Result(lhs.number() <= rhs.number());
-            else return Result(lhs.string() <= rhs.string());
-        }
-        break;
-        case GT:
-        {
-            if (lhs.isNumber) return Result(lhs.number() > rhs.number());
-            else return Result(lhs.string() > rhs.string());
-        }
-        break;
-        case GTE:
-        {
-            if (lhs.isNumber) return Result(lhs.number() >= rhs.number());
-            else return Result(lhs.string() >= rhs.string());
-        }
-        break;
-
         case ELVIS:
         {
             // it was evaluated above, which is kinda cheating
@@ -8299,32 +9033,10 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
             if (lhs.isNumber && lhs.number()) return Result(lhs.number());
             else return Result(rhs.number());
         }
-        case MATCHES:
-            if (!lhs.isNumber && !rhs.isNumber) return Result(QRegExp(rhs.string()).exactMatch(lhs.string()));
-            else return Result(false);
-            break;
-
-        case ENDSWITH:
-            if (!lhs.isNumber && !rhs.isNumber) return Result(lhs.string().endsWith(rhs.string()));
-            else return Result(false);
-            break;
-
-        case BEGINSWITH:
-            if (!lhs.isNumber && !rhs.isNumber) return Result(lhs.string().startsWith(rhs.string()));
-            else return Result(false);
-            break;
-
-        case CONTAINS:
-            {
-            if (!lhs.isNumber && !rhs.isNumber) {
-                if (lhs.isVector()) return Result(lhs.asString().contains(rhs.string()));
-                else return Result(lhs.string().contains(rhs.string()) ? true : false);
-            } else return Result(false);
-            }
-            break;
 
         default:
-            break;
+            // arithmetic, comparison and string operators
+            return operate(leaf->op, lhs, rhs);
         }
     }
     break;
@@ -8379,42 +9091,7 @@ Result Leaf::eval(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, R
     {
         Result index = eval(df,leaf->fparms[0],x, it, m, p, c, s, d);
         Result value = eval(df,leaf->lvalue.l,x, it, m, p, c, s, d); // lhs might also be a symbol
-
-        // are we returning the value or a vector of values?
-        if (index.asNumeric().count()) {
-
-            Result returning(0);
-            if (!value.isNumber) returning.isNumber = false;
-
-            // a range
-            for(int i=0; i<index.asNumeric().count(); i++) {
-                int ii=index.asNumeric()[i];
-
-                // ignore out of bounds
-                if (ii < 0 || (value.isNumber && ii >= value.asNumeric().count()) || (!value.isNumber && ii >= value.asString().count())) continue;
-
-                if (value.isNumber) {
-                    // numbers do sum
-                    returning.asNumeric() << value.asNumeric()[ii];
-                    returning.number() += value.asNumeric()[ii];
-                } else {
-                    returning.asString() << value.asString()[ii];
-                }
-            }
-
-            return returning;
-
-        } else {
-            // a single value
-            if (value.isNumber) {
-                if (index.number() < 0 || index.number() >= value.asNumeric().count()) return Result(0);
-                return Result(value.asNumeric()[index.number()]);
-            } else {
-                if (index.number() < 0 || index.number() >= value.asString().count()) return Result("");
-                return Result(value.asString()[index.number()]);
-
-            }
-        }
+        return Leaf::index(value, index);
     }
 
     // SELECTING FROM VECTORS
@@ -8518,19 +9195,12 @@ DFModel::fitData(QVector<double>&x, QVector<double>&y)
         startingparms << p.number();
     }
 
-    // get access to lmfit, single threaded :(
+    // get access to lmfit, the model is passed through to f()
     lm_control_struct control = lm_control_double;
     lm_status_struct status;
 
-    // use forwarder via global variable, so mutex around this !
-    calllmfit.lock();
-    calllmfitmodel = this;
-
     //fprintf(stderr, "Fitting ...\n" ); fflush(stderr);
-    lmcurve(parameters.count(), const_cast<double*>(startingparms.constData()), x.count(), x.constData(), y.constData(), calllmfitf, &control, &status);
-
-    // release for others
-    calllmfit.unlock();
+    lmcurve_data(parameters.count(), startingparms.data(), x.count(), x.constData(), y.constData(), PDModel::fitf, this, &control, &status);
 
     // starting parms now contain final output lets
     // update the runtime to get them back to the user
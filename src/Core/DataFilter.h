@@ -27,9 +27,11 @@
 #include <QHash>
 #include <QStringList>
 #include <QTextDocument>
+#include <QReadWriteLock>
 #include "RideCache.h"
 #include "RideFile.h" //for SeriesType
 #include "Utils.h" //for SeriesType
+#include "DataFilterOptimizer.h"
 
 #include <gsl/gsl_randist.h>
 
@@ -39,82 +41,168 @@ class RideMetric;
 class FieldDefinition;
 class DataFilter;
 class DataFilterRuntime;
-
+class DataFilterProgram;
+class DataFilterBatch;
+class DataFilterProfile;
+class DataFilterMemo;
+
+// the value of an expression, a number or a string, either of which can
+// be a vector. Numbers (by far the most common) are held inline, the
+// containers are only allocated for strings and vectors.
 class Result {
     public:
 
         // construct a result
-        Result (double value) : isNumber(true), string_(""), number_(value) {}
-        Result (QVector<double>x) : isNumber(true), string_(""), number_(0), vector(x) { foreach(double n, x) number_ += n; }
-        Result (QString value) : isNumber(false), string_(value), number_(0.0f) {}
-        Result (QStringList &list) : isNumber(false), string_(""), number_(0.0f) { foreach (QString string, list) strings<<string; }
-        Result () : isNumber(true), string_(""), number_(0) {}
+        Result (double value) : isNumber(true), number_(value), sum_(false), data(NULL) {}
+        Result (QVector<double>x) : isNumber(true), number_(0), sum_(x.count() > 0), data(new ResultData) { data->vector = x; }
+        Result (QString value) : isNumber(false), number_(0.0f), sum_(false), data(new ResultData) { data->string_ = value; }
+        Result (QStringList &list) : isNumber(false), number_(0.0f), sum_(false), data(new ResultData) { foreach (QString string, list) data->strings<<string; }
+        Result () : isNumber(true), number_(0), sum_(false), data(NULL) {}
+
+        // the containers are implicitly shared, so copies are cheap, but
+        // each result has its own so references to them stay valid
+        Result (const Result &other) : isNumber(other.isNumber), number_(other.number_), sum_(other.sum_),
+                                       data(other.data ? new ResultData(*other.data) : NULL) {}
+        Result (Result &&other) : isNumber(other.isNumber), number_(other.number_), sum_(other.sum_), data(other.data) { other.data = NULL; }
+        Result &operator=(const Result &other) {
+            if (this != &other) {
+                isNumber = other.isNumber; number_ = other.number_; sum_ = other.sum_;
+                if (other.data) { if (data) *data = *other.data; else data = new ResultData(*other.data); }
+                else if (data) data->clear();
+            }
+            return *this;
+        }
+        Result &operator=(Result &&other) {
+            if (this != &other) {
+                isNumber = other.isNumber; number_ = other.number_; sum_ = other.sum_;
+                if (other.data) {
+                    if (data) { *data = std::move(*other.data); }
+                    else { data = other.data; other.data = NULL; }
+                } else if (data) data->clear();
+            }
+            return *this;
+        }
+        ~Result() { delete data; }
+
+        // containers allocated by the thread, for DataFilterProfile
+        static thread_local qint64 allocations;
 
         // vectorize, turn into vector of size n
         void vectorize(int size);
 
         // we can't use QString with union
         bool isNumber;           // if true, value is numeric
-        bool isVector() const { return vector.count() > 0 || strings.count() > 0; }
+        bool isVector() const { return data && (data->vector.count() > 0 || data->strings.count() > 0); }
 
         // return as number or string, coerce if needed
         double &number() {
+            sum();
             if (!isNumber) {
-                if (!isVector()) number_ = string_.toDouble();
+                if (!isVector()) number_ = data ? data->string_.toDouble() : 0;
                 else asNumeric(); // this will coerce and crucially compute sum
             }
             return number_;
         }
 
-        QString &string() { if (isNumber) string_ = Utils::removeDP("%1").arg(number_);
-                            else if (strings.count() == 1) string_ = strings.at(0); // when vector is only 1 entry
-                            return string_; }
+        QString &string() { sum();
+                            ResultData *d = containers();
+                            if (isNumber) d->string_ = Utils::removeDP("%1").arg(number_);
+                            else if (d->strings.count() == 1) d->string_ = d->strings.at(0); // when vector is only 1 entry
+                            return d->string_; }
 
         // coerce strings to numbers
         QVector<double>&asNumeric() {
+            sum();
+            ResultData *d = containers();
             if (!isNumber) {
-                if (strings.count() == vector.count()) return vector;
+                if (d->strings.count() == d->vector.count()) return d->vector;
                 else {
-                    vector.clear();
+                    d->vector.clear();
                     number_=0;
-                    for(int i=0; i<strings.count(); i++) {
-                        double v = strings.at(i).toDouble();
-                        vector << v;
+                    for(int i=0; i<d->strings.count(); i++) {
+                        double v = d->strings.at(i).toDouble();
+                        d->vector << v;
                         number_ += v;
                     }
                 }
             }
-            return vector;
+            return d->vector;
         }
 
         // coerce numbers to strings
         QVector<QString> &asString() {
+            sum();
+            ResultData *d = containers();
             if (isNumber) {
-                if (strings.count() == vector.count()) return strings;
+                if (d->strings.count() == d->vector.count()) return d->strings;
                 else {
-                    strings.clear();
-                    for(int i=0; i<vector.count(); i++)  strings << Utils::removeDP(QString("%1").arg(vector.at(i)));
+                    d->strings.clear();
+                    for(int i=0; i<d->vector.count(); i++)  d->strings << Utils::removeDP(QString("%1").arg(d->vector.at(i)));
                 }
             }
-            return strings;
+            return d->strings;
         }
 
     private:
 
-        QString string_;
-        double number_;
-        QVector<double> vector;
-        QVector<QString> strings;
+        struct ResultData {
+            ResultData() { allocations++; }
+            ResultData(const ResultData &other) : string_(other.string_), vector(other.vector), strings(other.strings) { allocations++; }
+            ResultData &operator=(const ResultData &) = default;
+            ResultData &operator=(ResultData &&) = default;
+
+            QString string_;
+            QVector<double> vector;
+            QVector<QString> strings;
+            void clear() { string_ = QString(); vector = QVector<double>(); strings = QVector<QString>(); }
+        };
+
+        ResultData *containers() { if (!data) data = new ResultData; return data; }
+
+        // a vector's number is its sum, added up when first needed
+        void sum() {
+            if (sum_) {
+                sum_ = false;
+                number_ = 0;
+                if (data) foreach(double n, data->vector) number_ += n; // unless moved from
+            }
+        }
 
+        double number_;
+        bool sum_;              // number_ is still to be summed from the vector
+        ResultData *data;       // NULL for a plain number
 };
+Q_DECLARE_TYPEINFO(Result, Q_MOVABLE_TYPE);
 
 class DataFilterRuntime;
+
+// what a symbol refers to, resolved when the expression is validated
+// so evaluating it is a load rather than a lookup by name every time
+class SymbolBinding {
+    public:
+
+        enum Kind { Unbound, Iteration, X, IsRide, IsRun, IsSwim, IsXtrain, IsAero,
+                    NA, RecIntSecs, Current, Today, Date, Time, Planned,
+                    CTL, ATL, TSB, Number, Text };
+
+        SymbolBinding() : kind(Unbound), slot(-1), series(RideFile::none), metric(-1) {}
+
+        // in the same order Leaf::eval used to check them by name
+        static SymbolBinding resolve(DataFilterRuntime *df, const QString &symbol);
+
+        Kind kind;
+        int slot;                       // user symbol slot, -1 if not reserved
+        RideFile::SeriesType series;    // when evaluating samples, none if not a series
+        int metric;                     // metric index for Number, -1 if metadata
+        QString field;                  // metric or metadata field for Number and Text
+};
+
 class Leaf {
     Q_DECLARE_TR_FUNCTIONS(Leaf)
 
     public:
 
-        Leaf(int loc, int leng) : type(none),lvalue(),rvalue(),cond(),op(0),series(NULL),dynamic(false),loc(loc),leng(leng),inerror(false) { }
+        Leaf(int loc, int leng) : type(none),lvalue(),rvalue(),cond(),op(0),series(NULL),dynamic(false),loc(loc),leng(leng),inerror(false),program(NULL),batch(NULL),builtin(-1),fnum(-1),invariant(0) { }
 
         // evaluate against a RideItem using its context
         //
@@ -128,11 +216,32 @@ class Leaf {
         //
         Result eval(DataFilterRuntime *df, Leaf *, const Result &x, long it, RideItem *m, RideFilePoint *p = NULL, const QHash<QString,RideMetric*> *metrics=NULL, const Specification &spec=Specification(), const  DateRange &d=DateRange());
 
+        // binary operators on evaluated operands (may coerce them)
+        static Result operate(int op, Result &lhs, Result &rhs);
+
+        // the math.h function of one number a call is to, NULL if not one
+        typedef double (*MathFunction)(double);
+        static MathFunction mathFunction(Leaf *leaf);
+
+        // a math.h function over a number or each element of a vector
+        static Result apply(MathFunction func, Result &v);
+
+        // value[index], an element or the elements a vector of indexes selects
+        static Result index(Result &value, Result &index);
+
+        // the memo key for a memoised builtin call, empty if not kept
+        static QString memoKey(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, RideItem *m, RideFilePoint *p,
+                               const QHash<QString,RideMetric*> *c, const Specification &s, const DateRange &d);
+
+        // value of a symbol leaf for a ride (not NULL), using its binding
+        static Result symbol(DataFilterRuntime *df, Leaf *leaf, const Result &x, long it, RideItem *m, RideFilePoint *p, const QHash<QString,RideMetric*> *c);
+
         // tree traversal etc
         void print(int level, DataFilterRuntime*);  // print leaf and all children
         void color(Leaf *, QTextDocument *);  // update the document to match
         bool isDynamic(Leaf *);
         void validateFilter(Context *context, DataFilterRuntime *, Leaf*); // validate
+        void bind(DataFilterRuntime *, Leaf*); // resolve symbols once validated
         bool isNumber(DataFilterRuntime *df, Leaf *leaf);
         void findSymbols(QStringList &symbols); // when working with formulas
         void clear(Leaf*);
@@ -164,6 +273,56 @@ class Leaf {
         int loc, leng;
         bool inerror;
         RideFile::XDataJoin xjoin; // how to join xdata with main
+
+        // compiled form of a root or function body, owned by the leaf
+        DataFilterProgram *program;
+        DataFilterBatch *batch; // sample function over whole series
+
+        // what a symbol refers to, see bind()
+        SymbolBinding bound;
+
+        // what a function calls, bound with the symbols
+        int builtin;    // -1 if not bound yet
+        int fnum;       // offset into the v4 function table, -1 if not there
+        QString memo;   // signature if the result is kept in the athlete's memo
+
+        // computed once per ride when evaluating samples, 0 if not (see DataFilterOptimizer)
+        int invariant;
+};
+
+// user defined symbols, by name or by the slot a symbol
+// leaf was bound to when the expression was validated
+class DataFilterSymbols {
+
+    public:
+
+        // used like a QHash<QString,Result>
+        bool contains(const QString &name) const { return isSet(index.value(name, -1)); }
+        Result value(const QString &name) const { int s = index.value(name, -1); return isSet(s) ? values[s] : Result(); }
+        void insert(const QString &name, const Result &value) { assign(slot(name), name, value); }
+        void clear() { index.clear(); values.clear(); set.clear(); }
+        int count() const { return set.count(true); }
+        QStringList keys() const;
+
+        // slot for a name, reserved if not there yet
+        int slot(const QString &name);
+        int find(const QString &name) const { return index.value(name, -1); }
+
+        bool isSet(int slot) const { return slot >= 0 && slot < set.count() && set[slot]; }
+        const Result &at(int slot) const { return values[slot]; }
+
+        // the name is used if the slot was never bound
+        void assign(int slot, const QString &name, const Result &value) {
+            if (slot < 0 || slot >= values.count()) slot = this->slot(name);
+            values[slot] = value;
+            set[slot] = true;
+        }
+
+    private:
+
+        QHash<QString, int> index;
+        QVector<Result> values;
+        QVector<bool> set;
 };
 
 class UserChart;
@@ -179,6 +338,36 @@ public:
     // stack count (to stop recursion 'hanging'
     int stack = 0;
 
+    // ignore compiled programs and walk the tree
+    bool interpret = false;
+
+    // index of a sample in the ride, they are usually visited
+    // in order so the one after the last found is checked first
+    int indexOf(RideFile *ride, RideFilePoint *p);
+    int lastindex = -1;
+
+    // memoised builtin being computed, so it isn't looked up again
+    Leaf *memoising = NULL;
+
+    // memo to use instead of the athlete's, if set
+    DataFilterMemo *memo = NULL;
+
+    // calls are recorded when profiling, shared by copies of the runtime
+    DataFilterProfile *profile = NULL;
+    Leaf *profiling = NULL;
+
+    // values of the invariants in the per sample functions (Leaf::invariant - 1)
+    // for the ride and interval they were computed for, reset before each ride
+    QVector<Result> invariants;
+    QVector<bool> known;
+    RideItem *invariantsFor = NULL;
+    const QHash<QString,RideMetric*> *invariantsWith = NULL;
+    void resetInvariants(RideItem *m = NULL, const QHash<QString,RideMetric*> *c = NULL) {
+        known.fill(false, invariants.count());
+        invariantsFor = m;
+        invariantsWith = c;
+    }
+
     // needs to be reapplied as the ride selection changes
     bool isdynamic;
 
@@ -194,7 +383,7 @@ public:
     QStringList dataSeriesSymbols;
 
     // user defined symbols
-    QHash<QString, Result> symbols;
+    DataFilterSymbols symbols;
 
     // user defined functions
     QHash<QString, Leaf*> functions;
@@ -244,6 +433,16 @@ class DataFilter : public QObject
         Result evaluate(RideItem *rideItem, RideFilePoint *p);
         Result evaluate(DateRange dr, QString filter="");
         Result evaluate(Specification spec, DateRange dr);
+
+        // evaluate(ride, NULL) for each of the rides, the results are in
+        // the same order. Split across the thread pool when the expression
+        // only reads the ride (see isConcurrent), with a runtime per chunk
+        QVector<Result> evaluate(const QVector<RideItem*> &rides);
+        bool isConcurrent() const { return concurrent; }
+
+        // what the optimizer did when it was compiled
+        const DataFilterOptimizer::Stats &optimizations() const { return optimized; }
+
         QStringList getErrors() { return errors; };
         void colorSyntax(QTextDocument *content, int pos);
 
@@ -252,6 +451,11 @@ class DataFilter : public QObject
 
         int refcount; // used by user metrics
 
+        // the clones of a user metric evaluate the tree alongside each
+        // other, they hold this for reading while they do so the tree
+        // isn't rebound under them when the config changes
+        QReadWriteLock binding;
+
     public slots:
         QStringList parseFilter(Context *context, QString query, QStringList *list=0);
         QStringList check(QString query);
@@ -270,8 +474,13 @@ class DataFilter : public QObject
 
     private:
         void setSignature(QString &query);
+        void compile(); // compile root and functions after validation
+        QVector<Result> evaluate(const QVector<RideItem*> &rides, Leaf *start);
+        void filterRides(); // evaluate for every ride, setting filenames
 
         Leaf *treeRoot;
+        bool concurrent; // no assignments or shared state, so can run in parallel
+        DataFilterOptimizer::Stats optimized;
         QStringList errors;
 
         QStringList filenames;
@@ -0,0 +1,312 @@
+/*
+ * Copyright (c) 2026 The GoldenCheetah Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "DataFilterBatch.h"
+#include "DataFilterProfile.h"
+#include "RideItem.h"
+#include "RideFile.h"
+
+#include "DataFilter_yacc.h"
+
+#include <cmath>
+
+DataFilterBatch *
+DataFilterBatch::compile(DataFilterRuntime *df, Leaf *function)
+{
+    if (!function || function->type != Leaf::Compound) return NULL;
+
+    QList<Statement> statements;
+    QStringList targets;
+
+    foreach(Leaf *leaf, *(function->lvalue.b)) {
+
+        Statement add;
+        add.symbol = NULL;
+
+        // append(v, expr)
+        if (leaf->type == Leaf::Function && leaf->function == "append" && !df->functions.contains("append") &&
+            leaf->fparms.count() == 2 && leaf->fparms[0]->type == Leaf::Symbol) {
+
+            add.append = true;
+            add.symbol = leaf->fparms[0];
+            add.expr = leaf->fparms[1];
+
+        // total <- total + expr
+        } else if ((leaf->type == Leaf::Operation || leaf->type == Leaf::BinaryOperation) && leaf->op == ASSIGN &&
+                   leaf->lvalue.l->type == Leaf::Symbol &&
+                   (leaf->rvalue.l->type == Leaf::Operation || leaf->rvalue.l->type == Leaf::BinaryOperation) &&
+                   leaf->rvalue.l->op == ADD && leaf->rvalue.l->lvalue.l->type == Leaf::Symbol &&
+                   *(leaf->rvalue.l->lvalue.l->lvalue.n) == *(leaf->lvalue.l->lvalue.n)) {
+
+            add.append = false;
+            add.symbol = leaf->lvalue.l;
+            add.expr = leaf->rvalue.l->rvalue.l;
+
+        // no effect, so long as there are no side effects
+        } else if (elementwise(leaf, QStringList())) {
+            continue;
+
+        } else return NULL;
+
+        // a series can't be assigned as far as a sample is concerned
+        QString symbol = *(add.symbol->lvalue.n);
+        if (add.symbol->bound.kind == SymbolBinding::Unbound || add.symbol->bound.series != RideFile::none) return NULL;
+
+        // one statement per symbol, since they are applied in turn
+        if (targets.contains(symbol)) return NULL;
+        targets << symbol;
+        statements << add;
+    }
+
+    // the expressions can't depend on anything changed in the loop
+    foreach(const Statement &statement, statements)
+        if (!elementwise(statement.expr, targets)) return NULL;
+
+    if (statements.isEmpty()) return NULL;
+
+    DataFilterBatch *returning = new DataFilterBatch();
+    returning->statements = statements;
+    return returning;
+}
+
+bool
+DataFilterBatch::elementwise(Leaf *leaf, const QStringList &targets)
+{
+    if (!leaf) return true; // NULL is zero
+    if (leaf->invariant) return true; // the same for every sample
+
+    switch (leaf->type) {
+
+    case Leaf::Float :
+    case Leaf::Integer :
+        return true;
+
+    case Leaf::Symbol :
+        // bound so we know if it is a series
+        return leaf->bound.kind != SymbolBinding::Unbound &&
+               (leaf->bound.series != RideFile::none || !targets.contains(*(leaf->lvalue.n)));
+
+    case Leaf::Logical :
+        return elementwise(leaf->lvalue.l, targets) && (!leaf->op || elementwise(leaf->rvalue.l, targets));
+
+    case Leaf::UnaryOperation :
+        return elementwise(leaf->lvalue.l, targets);
+
+    case Leaf::Operation :
+    case Leaf::BinaryOperation :
+        switch (leaf->op) {
+        case ADD: case SUBTRACT: case DIVIDE: case MULTIPLY: case POW:
+        case EQ: case NEQ: case LT: case LTE: case GT: case GTE:
+        case ELVIS:
+            return elementwise(leaf->lvalue.l, targets) && elementwise(leaf->rvalue.l, targets);
+        default:
+            return false;
+        }
+
+    case Leaf::Conditional :
+        if (leaf->op != IF_ && leaf->op != 0) return false;
+        return elementwise(leaf->cond.l, targets) && elementwise(leaf->lvalue.l, targets) &&
+               elementwise(leaf->rvalue.l, targets);
+
+    case Leaf::Function :
+        return Leaf::mathFunction(leaf) != NULL && elementwise(leaf->fparms[0], targets);
+
+    default:
+        return false;
+    }
+}
+
+bool
+DataFilterBatch::run(DataFilterRuntime *df, RideItem *m, int first, int last, const QHash<QString,RideMetric*> *c) const
+{
+    // the tree is the reference when checking
+    if (df->interpret || !m || !m->ride()) return false;
+
+    Columns at;
+    at.df = df;
+    at.m = m;
+    at.c = c;
+    at.points = &m->ride()->dataPoints();
+    at.first = first;
+    at.count = (first >= 0 && last >= first) ? last - first + 1 : 0;
+
+    if (at.count == 0) return true; // nothing to do
+    if (last >= at.points->count()) return false;
+
+    // a call of sample for all of them when profiling
+    DataFilterProfile::Scope profiling(df->profile, "sample { } (batch)");
+
+    // the symbols need to be numbers, and an accumulated
+    // one a single number, for the loop to be element-wise
+    foreach(const Statement &statement, statements) {
+        Result current = df->symbols.value(*(statement.symbol->lvalue.n));
+        if (!current.isNumber || (!statement.append && current.isVector())) return false;
+    }
+
+    // compute every column before changing anything
+    QVector<QVector<double> > values(statements.count());
+    for (int i=0; i<statements.count(); i++)
+        if (!column(at, statements[i].expr, values[i])) return false;
+
+    for (int i=0; i<statements.count(); i++) {
+
+        const Statement &statement = statements[i];
+        const QVector<double> &value = values[i];
+        Result current = df->symbols.value(*(statement.symbol->lvalue.n));
+
+        // added in sample order, so the sums come out the same
+        double &sum = current.number();
+        if (statement.append) {
+            QVector<double> &vector = current.asNumeric();
+            vector.reserve(vector.count() + value.count());
+            for (int j=0; j<value.count(); j++) {
+                sum += value[j];
+                vector.append(value[j]);
+            }
+        } else {
+            for (int j=0; j<value.count(); j++) sum += value[j];
+        }
+
+        df->symbols.assign(statement.symbol->bound.slot, *(statement.symbol->lvalue.n), current);
+    }
+    return true;
+}
+
+bool
+DataFilterBatch::column(const Columns &at, Leaf *leaf, QVector<double> &out)
+{
+    const int n = at.count;
+    out.resize(n);
+
+    // NULL is zero
+    if (!leaf) {
+        out.fill(0);
+        return true;
+    }
+
+    // doesn't change from one sample to the next
+    if (leaf->invariant) {
+        Result value = leaf->eval(at.df, leaf, Result(0), 0, at.m, NULL, at.c);
+        if (!value.isNumber || value.isVector()) return false;
+        out.fill(value.number());
+        return true;
+    }
+
+    switch (leaf->type) {
+
+    case Leaf::Float :
+        out.fill(leaf->lvalue.f);
+        return true;
+
+    case Leaf::Integer :
+        out.fill(leaf->lvalue.i);
+        return true;
+
+    case Leaf::Symbol :
+    {
+        RideFile::SeriesType series = leaf->bound.series;
+        double *o = out.data();
+        if (series == RideFile::index) {
+            for (int i=0; i<n; i++) o[i] = at.first + i;
+        } else if (series != RideFile::none) {
+            RideFilePoint * const *points = at.points->constData() + at.first;
+            for (int i=0; i<n; i++) o[i] = points[i]->value(series);
+        } else {
+            // doesn't change from one sample to the next
+            Result value = Leaf::symbol(at.df, leaf, Result(0), 0, at.m, NULL, at.c);
+            if (!value.isNumber || value.isVector()) return false;
+            out.fill(value.number());
+        }
+        return true;
+    }
+
+    case Leaf::Logical :
+    {
+        if (!column(at, leaf->lvalue.l, out)) return false;
+        if (!leaf->op) return true; // parenthesis
+
+        QVector<double> rhs;
+        if (!column(at, leaf->rvalue.l, rhs)) return false;
+        double *o = out.data();
+        const double *r = rhs.constData();
+        if (leaf->op == AND) for (int i=0; i<n; i++) o[i] = (o[i] && r[i]) ? 1 : 0;
+        else for (int i=0; i<n; i++) o[i] = (o[i] || r[i]) ? 1 : 0;
+        return true;
+    }
+
+    case Leaf::UnaryOperation :
+    {
+        if (!column(at, leaf->lvalue.l, out)) return false;
+        double *o = out.data();
+        if (leaf->op == '-') for (int i=0; i<n; i++) o[i] = o[i] * -1;
+        else if (leaf->op == '!') for (int i=0; i<n; i++) o[i] = !o[i];
+        else out.fill(0);
+        return true;
+    }
+
+    case Leaf::Operation :
+    case Leaf::BinaryOperation :
+    {
+        QVector<double> rhs;
+        if (!column(at, leaf->lvalue.l, out) || !column(at, leaf->rvalue.l, rhs)) return false;
+        double *o = out.data();
+        const double *r = rhs.constData();
+
+        switch (leaf->op) {
+        case ADD: for (int i=0; i<n; i++) o[i] = o[i] + r[i]; break;
+        case SUBTRACT: for (int i=0; i<n; i++) o[i] = o[i] - r[i]; break;
+        case MULTIPLY: for (int i=0; i<n; i++) o[i] = o[i] * r[i]; break;
+        case DIVIDE: for (int i=0; i<n; i++) o[i] = r[i] ? o[i] / r[i] : 0; break;
+        case POW: for (int i=0; i<n; i++) o[i] = pow(o[i], r[i]); break;
+        case EQ: for (int i=0; i<n; i++) o[i] = o[i] == r[i]; break;
+        case NEQ: for (int i=0; i<n; i++) o[i] = o[i] != r[i]; break;
+        case LT: for (int i=0; i<n; i++) o[i] = o[i] < r[i]; break;
+        case LTE: for (int i=0; i<n; i++) o[i] = o[i] <= r[i]; break;
+        case GT: for (int i=0; i<n; i++) o[i] = o[i] > r[i]; break;
+        case GTE: for (int i=0; i<n; i++) o[i] = o[i] >= r[i]; break;
+        case ELVIS: for (int i=0; i<n; i++) o[i] = o[i] ? o[i] : r[i]; break;
+        default: return false;
+        }
+        return true;
+    }
+
+    case Leaf::Conditional :
+    {
+        // both sides are computed, they have no side effects
+        QVector<double> lhs, rhs;
+        if (!column(at, leaf->cond.l, out) || !column(at, leaf->lvalue.l, lhs) ||
+            !column(at, leaf->rvalue.l, rhs)) return false;
+        double *o = out.data();
+        const double *l = lhs.constData(), *r = rhs.constData();
+        for (int i=0; i<n; i++) o[i] = o[i] ? l[i] : r[i];
+        return true;
+    }
+
+    case Leaf::Function :
+    {
+        Leaf::MathFunction func = Leaf::mathFunction(leaf);
+        if (!func || !column(at, leaf->fparms[0], out)) return false;
+        double *o = out.data();
+        for (int i=0; i<n; i++) o[i] = func(o[i]);
+        return true;
+    }
+
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2026 The GoldenCheetah Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_DataFilterBatch_h
+#define _GC_DataFilterBatch_h 1
+
+#include "DataFilter.h"
+
+#include <QVector>
+#include <QList>
+
+//
+// A sample() function run over whole series at once instead of being
+// called for every sample by user charts and user metrics.
+//
+// Only the common idioms are handled, a body made up of
+//
+//      append(v, expr);        collect a value per sample
+//      total <- total + expr;  accumulate a value per sample
+//      expr;                   no effect
+//
+// where expr is element-wise: numbers, series symbols, symbols that
+// don't change in the loop, arithmetic, comparisons, logical and
+// conditional operators, the math.h functions and anything the
+// optimizer found is the same for every sample. Each expr is
+// evaluated as a column, one loop per node over every sample, and
+// then applied to the symbols in sample order so the results are the
+// same as calling the function for every sample.
+//
+// Anything else (other functions, other assignments, loops) is left
+// to the caller to evaluate sample by sample.
+//
+class DataFilterBatch
+{
+    public:
+
+        // returns NULL if the function has to be run sample by sample
+        static DataFilterBatch *compile(DataFilterRuntime *df, Leaf *function);
+
+        // run for the samples first to last (as a RideFileIterator visits
+        // them), returns false having changed nothing if the symbols it
+        // uses aren't plain numbers
+        bool run(DataFilterRuntime *df, RideItem *m, int first, int last, const QHash<QString,RideMetric*> *c) const;
+
+    private:
+
+        struct Statement {
+            bool append;        // else accumulate
+            Leaf *symbol;
+            Leaf *expr;
+        };
+
+        struct Columns {
+            DataFilterRuntime *df;
+            RideItem *m;
+            const QHash<QString,RideMetric*> *c;
+            const QVector<RideFilePoint*> *points;
+            int first, count;
+        };
+
+        static bool elementwise(Leaf *leaf, const QStringList &targets);
+        static bool column(const Columns &at, Leaf *leaf, QVector<double> &out);
+
+        QList<Statement> statements;
+};
+
+#endif // _GC_DataFilterBatch_h
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2026 The GoldenCheetah Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "DataFilterMemo.h"
+#include "Context.h"
+
+#include <QMutexLocker>
+
+// bests and meanmax arrays are a few thousand doubles
+static const int defaultBudget = 32 * 1024 * 1024;
+
+DataFilterMemo::DataFilterMemo(Context *context) : context(context), generation(0), hits(0), misses(0), invalidations(0)
+{
+    cache.setMaxCost(defaultBudget);
+
+    // anything that changes rides, metrics or estimates
+    connect(context, SIGNAL(rideAdded(RideItem*)), this, SLOT(invalidate()));
+    connect(context, SIGNAL(rideDeleted(RideItem*)), this, SLOT(invalidate()));
+    connect(context, SIGNAL(rideSaved(RideItem*)), this, SLOT(invalidate()));
+    connect(context, SIGNAL(refreshUpdate(QDate)), this, SLOT(invalidate()));
+    connect(context, SIGNAL(estimatesRefreshed()), this, SLOT(invalidate()));
+    connect(context, SIGNAL(configChanged(qint32)), this, SLOT(invalidate()));
+}
+
+bool
+DataFilterMemo::lookup(const QString &key, Result &value, int &generation)
+{
+    QMutexLocker locker(&mutex);
+
+    generation = this->generation;
+    Result *found = cache.object(key);
+    if (found) {
+        hits++;
+        value = *found;
+        return true;
+    }
+    misses++;
+    return false;
+}
+
+void
+DataFilterMemo::insert(const QString &key, const Result &value, int generation)
+{
+    QMutexLocker locker(&mutex);
+
+    // computed from data that has since changed
+    if (generation != this->generation) return;
+
+    cache.insert(key, new Result(value), cost(value));
+}
+
+void
+DataFilterMemo::setBudget(int bytes)
+{
+    QMutexLocker locker(&mutex);
+    cache.setMaxCost(bytes);
+}
+
+DataFilterMemo::Stats
+DataFilterMemo::stats() const
+{
+    QMutexLocker locker(&mutex);
+
+    Stats returning;
+    returning.hits = hits;
+    returning.misses = misses;
+    returning.invalidations = invalidations;
+    returning.entries = cache.count();
+    returning.cost = cache.totalCost();
+    returning.budget = cache.maxCost();
+    return returning;
+}
+
+void
+DataFilterMemo::invalidate()
+{
+    QMutexLocker locker(&mutex);
+
+    generation++;
+    if (cache.count()) invalidations++;
+    cache.clear();
+}
+
+int
+DataFilterMemo::cost(const Result &value)
+{
+    // asNumeric and asString don't coerce a value of their own type
+    Result copy = value;
+    if (copy.isNumber) return sizeof(Result) + copy.asNumeric().count() * sizeof(double);
+
+    int returning = sizeof(Result);
+    foreach(const QString &string, copy.asString()) returning += sizeof(QString) + string.size() * sizeof(QChar);
+    return returning;
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2026 The GoldenCheetah Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_DataFilterMemo_h
+#define _GC_DataFilterMemo_h 1
+
+#include "DataFilter.h"
+
+#include <QObject>
+#include <QCache>
+#include <QMutex>
+
+class Context;
+
+//
+// Results of the expensive DataFilter builtins that work across a date
+// range (bests, meanmax, aggmetrics, estimates and pmc) shared by every
+// chart, tile and filter for the athlete.
+//
+// Entries are keyed by the call and everything it depends upon (see
+// memoKey in DataFilter.cpp) and the whole memo is invalidated when
+// rides are added, deleted or changed, the metrics are refreshed or the
+// config changes. Results computed from data that has changed since
+// they were looked up are not kept.
+//
+// Lookups come from the refresh threads as well as the GUI, so it is
+// guarded by a mutex, but the builtins are computed outside of it.
+//
+class DataFilterMemo : public QObject
+{
+    Q_OBJECT
+
+    public:
+
+        DataFilterMemo(Context *context);
+
+        // true and value set on a hit, generation is passed to insert
+        bool lookup(const QString &key, Result &value, int &generation);
+        void insert(const QString &key, const Result &value, int generation);
+
+        // least recently used are dropped beyond the budget
+        void setBudget(int bytes);
+
+        struct Stats {
+            qint64 hits, misses, invalidations;
+            int entries, cost, budget;      // cost and budget in bytes
+        };
+        Stats stats() const;
+
+    public slots:
+
+        void invalidate();
+
+    private:
+
+        static int cost(const Result &value);
+
+        Context *context;
+
+        mutable QMutex mutex;
+        QCache<QString, Result> cache;
+        int generation;
+        qint64 hits, misses, invalidations;
+};
+
+#endif // _GC_DataFilterMemo_h
@@ -0,0 +1,413 @@
+/*
+ * Copyright (c) 2026 The GoldenCheetah Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "DataFilterOptimizer.h"
+#include "DataFilter.h"
+
+#include "DataFilter_yacc.h"
+
+#include <cmath>
+#include <climits>
+
+bool DataFilterOptimizer::enabled = true;
+
+// the functions called for every sample by user charts and metrics
+static const char *perSampleFunctions[] = { "sample", "before", "after", NULL };
+
+// per ride builtins, usually the reason to hoist an expression
+static bool hoistable(DataFilterRuntime *df, Leaf *leaf)
+{
+    static const QStringList perride = QStringList() << "config" << "best" << "tiz" << "round";
+
+    if (Leaf::mathFunction(leaf)) return true;
+    return perride.contains(leaf->function) && !df->functions.contains(leaf->function);
+}
+
+static bool isNumber(Leaf *leaf)
+{
+    return leaf && (leaf->type == Leaf::Float || leaf->type == Leaf::Integer);
+}
+
+// the leaves a leaf evaluates, the series named by config(cp)
+// and the like is a name rather than a value so isn't one
+static QList<Leaf*> children(Leaf *leaf)
+{
+    QList<Leaf*> returning;
+
+    switch (leaf->type) {
+
+    case Leaf::Compound :
+        returning = *(leaf->lvalue.b);
+        break;
+
+    case Leaf::Logical :
+        returning << leaf->lvalue.l;
+        if (leaf->op) returning << leaf->rvalue.l;
+        break;
+
+    case Leaf::Operation :
+    case Leaf::BinaryOperation :
+        returning << leaf->lvalue.l << leaf->rvalue.l;
+        break;
+
+    case Leaf::UnaryOperation :
+        returning << leaf->lvalue.l;
+        break;
+
+    case Leaf::Function :
+    case Leaf::Index :
+    case Leaf::Select :
+        returning << leaf->lvalue.l << leaf->fparms;
+        break;
+
+    case Leaf::Conditional :
+        returning << leaf->cond.l << leaf->lvalue.l << leaf->rvalue.l;
+        break;
+
+    default:
+        break;
+    }
+
+    returning.removeAll(NULL);
+    return returning;
+}
+
+// user functions are registered by the leaf when validated so can't be removed
+static bool declares(Leaf *leaf)
+{
+    if (!leaf) return false;
+    if (leaf->type == Leaf::Compound && leaf->function != "") return true;
+
+    foreach(Leaf *child, children(leaf)) if (declares(child)) return true;
+    return false;
+}
+
+// turn the leaf into a number, false if it can't be held exactly
+static bool literal(Leaf *leaf, double value)
+{
+    bool integer = value == floor(value) && value >= INT_MIN && value <= INT_MAX && !(value == 0 && std::signbit(value));
+    if (!integer && static_cast<double>(static_cast<float>(value)) != value) return false; // NaN too
+
+    leaf->clear(leaf);
+    leaf->lvalue.l = leaf->rvalue.l = leaf->cond.l = NULL;
+    leaf->series = NULL;
+    leaf->function = leaf->memo = QString();
+    leaf->op = 0;
+    leaf->builtin = leaf->fnum = -1;
+
+    if (integer) {
+        leaf->type = Leaf::Integer;
+        leaf->lvalue.i = static_cast<int>(value);
+    } else {
+        leaf->type = Leaf::Float;
+        leaf->lvalue.f = static_cast<float>(value);
+    }
+    return true;
+}
+
+// replace the leaf with one of its children, the others are freed
+static void replace(Leaf *leaf, Leaf *with)
+{
+    if (leaf->lvalue.l == with) leaf->lvalue.l = NULL;
+    if (leaf->rvalue.l == with) leaf->rvalue.l = NULL;
+    if (leaf->cond.l == with) leaf->cond.l = NULL;
+
+    Leaf taken = *with;
+    delete with;
+    leaf->clear(leaf);
+    *leaf = taken;
+}
+
+// identifies an invariant, so the same expression is only computed once
+static QString key(Leaf *leaf)
+{
+    if (!leaf) return "0";
+
+    switch (leaf->type) {
+
+    case Leaf::Float : return QString::number(leaf->lvalue.f, 'g', 9);
+    case Leaf::Integer : return QString::number(leaf->lvalue.i);
+    case Leaf::String : return "\"" + *(leaf->lvalue.s) + "\"";
+    case Leaf::Symbol : return *(leaf->lvalue.n);
+
+    case Leaf::Logical :
+    case Leaf::Operation :
+    case Leaf::BinaryOperation :
+        return QString("(%1 %2 %3)").arg(key(leaf->lvalue.l)).arg(leaf->op).arg(leaf->op ? key(leaf->rvalue.l) : QString());
+
+    case Leaf::UnaryOperation :
+        return QString("(%1%2)").arg(QChar(leaf->op)).arg(key(leaf->lvalue.l));
+
+    case Leaf::Conditional :
+        return QString("(%1 ? %2 : %3)").arg(key(leaf->cond.l)).arg(key(leaf->lvalue.l)).arg(key(leaf->rvalue.l));
+
+    case Leaf::Function :
+    {
+        QStringList parms;
+        if (leaf->series) parms << *(leaf->series->lvalue.n);
+        if (leaf->lvalue.l) parms << key(leaf->lvalue.l);
+        foreach(Leaf *parm, leaf->fparms) parms << key(parm);
+        return leaf->function + "(" + parms.join(",") + ")";
+    }
+
+    default:
+        return QString();
+    }
+}
+
+DataFilterOptimizer::Stats
+DataFilterOptimizer::optimize(DataFilterRuntime *df, Leaf *root)
+{
+    Stats stats;
+    if (!enabled || !root) return stats;
+
+    fold(df, root, stats);
+
+    // symbols changed anywhere can't be invariant, the
+    // functions that change them may be called from sample
+    QStringList symbols;
+    assigned(df, root, symbols);
+
+    QHash<QString,int> ids;
+    for (int i=0; perSampleFunctions[i]; i++) {
+        Leaf *function = df->functions.value(perSampleFunctions[i]);
+        if (function && function->type == Leaf::Compound) hoist(df, function, symbols, ids, stats);
+    }
+
+    df->invariants.resize(ids.count());
+    df->resetInvariants();
+    return stats;
+}
+
+void
+DataFilterOptimizer::fold(DataFilterRuntime *df, Leaf *leaf, Stats &stats)
+{
+    if (!leaf) return;
+
+    // bottom up, so an expression sees its operands folded
+    foreach(Leaf *child, children(leaf)) fold(df, child, stats);
+
+    switch (leaf->type) {
+
+    case Leaf::Compound :
+    {
+        // a number on its own does nothing, unless it's the value of the block
+        QList<Leaf*> &statements = *(leaf->lvalue.b);
+        for (int i=0; i<statements.count()-1;) {
+            if (isNumber(statements[i])) {
+                delete statements.takeAt(i);
+                stats.statements++;
+            } else i++;
+        }
+        return;
+    }
+
+    case Leaf::Logical :
+        if (!isNumber(leaf->lvalue.l) || (leaf->op && !isNumber(leaf->rvalue.l))) return;
+        break;
+
+    case Leaf::UnaryOperation :
+        if (!isNumber(leaf->lvalue.l)) return;
+        break;
+
+    case Leaf::Operation :
+    case Leaf::BinaryOperation :
+        if (leaf->op == ASSIGN || !isNumber(leaf->lvalue.l) || !isNumber(leaf->rvalue.l)) return;
+        break;
+
+    case Leaf::Function :
+        if (!Leaf::mathFunction(leaf) || !isNumber(leaf->fparms[0])) return;
+        break;
+
+    case Leaf::Conditional :
+    {
+        if (!isNumber(leaf->cond.l)) return;
+        bool taken = leaf->eval(df, leaf->cond.l, Result(0), 0, NULL).number() != 0;
+
+        // a loop that never runs
+        if (leaf->op == WHILE) {
+            if (!taken && !declares(leaf->lvalue.l) && literal(leaf, 0)) stats.branches++;
+            return;
+        }
+
+        Leaf *branch = taken ? leaf->lvalue.l : leaf->rvalue.l;
+        if (declares(taken ? leaf->rvalue.l : leaf->lvalue.l)) return;
+
+        // no else is zero
+        if (branch) replace(leaf, branch);
+        else literal(leaf, 0);
+        stats.branches++;
+        return;
+    }
+
+    default:
+        return;
+    }
+
+    // only numbers are involved, so the interpreter needs no ride
+    Result value = leaf->eval(df, leaf, Result(0), 0, NULL);
+    if (value.isNumber && !value.isVector() && literal(leaf, value.number())) stats.folded++;
+}
+
+void
+DataFilterOptimizer::assigned(DataFilterRuntime *df, Leaf *leaf, QStringList &symbols)
+{
+    if (!leaf) return;
+
+    // target of an assignment, or an element of it
+    if ((leaf->type == Leaf::Operation || leaf->type == Leaf::BinaryOperation) && leaf->op == ASSIGN) {
+        Leaf *target = leaf->lvalue.l;
+        if (target->type == Leaf::Index) target = target->lvalue.l;
+        if (target->type == Leaf::Symbol) symbols << *(target->lvalue.n);
+    }
+
+    // builtins like append() and lm() change the symbols they are passed
+    if (leaf->type == Leaf::Function && !hoistable(df, leaf))
+        foreach(Leaf *parm, leaf->fparms) parm->findSymbols(symbols);
+
+    foreach(Leaf *child, children(leaf)) assigned(df, child, symbols);
+}
+
+bool
+DataFilterOptimizer::invariant(DataFilterRuntime *df, Leaf *leaf, const QStringList &assigned, bool &calls)
+{
+    if (!leaf) return true;
+
+    switch (leaf->type) {
+
+    case Leaf::Float :
+    case Leaf::Integer :
+    case Leaf::String :
+        return true;
+
+    case Leaf::Symbol :
+        return leaf->bound.kind != SymbolBinding::Unbound && leaf->bound.kind != SymbolBinding::Iteration &&
+               leaf->bound.kind != SymbolBinding::X && leaf->bound.series == RideFile::none &&
+               !assigned.contains(*(leaf->lvalue.n));
+
+    case Leaf::Operation :
+    case Leaf::BinaryOperation :
+        if (leaf->op == ASSIGN) return false;
+        break;
+
+    case Leaf::Conditional :
+        if (leaf->op != IF_ && leaf->op != 0) return false;
+        break;
+
+    case Leaf::Function :
+        if (!hoistable(df, leaf)) return false;
+        calls = true;
+        break;
+
+    case Leaf::Logical :
+    case Leaf::UnaryOperation :
+        break;
+
+    default:
+        return false;
+    }
+
+    foreach(Leaf *child, children(leaf)) if (!invariant(df, child, assigned, calls)) return false;
+    return true;
+}
+
+void
+DataFilterOptimizer::hoist(DataFilterRuntime *df, Leaf *leaf, const QStringList &assigned, QHash<QString,int> &ids, Stats &stats)
+{
+    if (!leaf) return;
+
+    // the largest expression that calls something, numbers and
+    // symbols on their own are no quicker to keep
+    bool calls = false;
+    if (leaf->type != Leaf::Compound && invariant(df, leaf, assigned, calls) && calls) {
+
+        QString signature = key(leaf);
+        if (ids.contains(signature)) stats.shared++;
+        else {
+            ids.insert(signature, ids.count() + 1);
+            stats.hoisted++;
+        }
+        leaf->invariant = ids.value(signature);
+        return;
+    }
+
+    foreach(Leaf *child, children(leaf)) hoist(df, child, assigned, ids, stats);
+}
+
+static QString opName(int op)
+{
+    switch (op) {
+    case ADD: return "+";
+    case SUBTRACT: return "-";
+    case MULTIPLY: return "*";
+    case DIVIDE: return "/";
+    case POW: return "^";
+    case EQ: return "==";
+    case NEQ: return "!=";
+    case LT: return "<";
+    case LTE: return "<=";
+    case GT: return ">";
+    case GTE: return ">=";
+    case ELVIS: return "?:";
+    case ASSIGN: return "<-";
+    case AND: return "&&";
+    case OR: return "||";
+    case MATCHES: return "matches";
+    case ENDSWITH: return "endsWith";
+    case BEGINSWITH: return "beginsWith";
+    case CONTAINS: return "contains";
+    default: return QString::number(op);
+    }
+}
+
+QString
+DataFilterOptimizer::dump(Leaf *root)
+{
+    QStringList lines;
+    dump(root, 0, lines);
+    return lines.join("\n");
+}
+
+void
+DataFilterOptimizer::dump(Leaf *leaf, int level, QStringList &lines)
+{
+    QString text;
+
+    switch (leaf->type) {
+    case Leaf::Script : text = "script"; break;
+    case Leaf::Compound : text = leaf->function == "" ? "{ }" : leaf->function + " { }"; break;
+    case Leaf::Float :
+    case Leaf::Integer : text = "number " + key(leaf); break;
+    case Leaf::String : text = "string " + key(leaf); break;
+    case Leaf::Symbol : text = "symbol " + key(leaf) + (leaf->bound.series != RideFile::none ? " (series)" : ""); break;
+    case Leaf::Logical : text = leaf->op ? opName(leaf->op) : "( )"; break;
+    case Leaf::Operation :
+    case Leaf::BinaryOperation : text = opName(leaf->op); break;
+    case Leaf::UnaryOperation : text = QChar(leaf->op); break;
+    case Leaf::Function : text = leaf->function + (leaf->series ? "(" + *(leaf->series->lvalue.n) + ")" : "()"); break;
+    case Leaf::Index : text = "[ ]"; break;
+    case Leaf::Select : text = "[ ] select"; break;
+    case Leaf::Conditional : text = leaf->op == WHILE ? "while" : "if"; break;
+    default: text = "?"; break;
+    }
+
+    if (leaf->invariant) text += QString("    [invariant %1, once per ride]").arg(leaf->invariant);
+    lines << QString(level * 4, ' ') + text;
+
+    foreach(Leaf *child, children(leaf)) dump(child, level + 1, lines);
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2026 The GoldenCheetah Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_DataFilterOptimizer_h
+#define _GC_DataFilterOptimizer_h 1
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+
+class Leaf;
+class DataFilterRuntime;
+
+//
+// Rewrites a validated and bound DataFilter tree before it is compiled
+//
+//  - arithmetic, comparisons, logical operators and math.h functions
+//    of numbers are folded into a number (when a float or an int can
+//    hold the result exactly, as the literals are stored that way)
+//  - if/else and ternaries with a constant condition are replaced by
+//    the branch taken, while loops that never run by zero and numbers
+//    on their own as a statement (other than the last) are dropped
+//  - in the per sample functions of user charts and metrics (sample,
+//    before and after) the expressions that only depend upon the ride,
+//    such as config(cp) or best(power, 60), are marked invariant and
+//    Leaf::eval computes them once per ride rather than for every
+//    sample. Identical ones share the value.
+//
+// The per activity functions have nothing to hoist, everything other
+// than the constants depends upon the activity.
+//
+class DataFilterOptimizer
+{
+    public:
+
+        struct Stats {
+            Stats() : folded(0), branches(0), statements(0), hoisted(0), shared(0) {}
+            int folded;         // expressions folded into a number
+            int branches;       // conditionals and loops removed
+            int statements;     // statements dropped
+            int hoisted;        // invariants computed once per ride
+            int shared;         // invariants sharing the value of another
+        };
+
+        static Stats optimize(DataFilterRuntime *df, Leaf *root);
+
+        // the tree as indented text, to see what was done
+        static QString dump(Leaf *root);
+
+        // off when checking against the tree as parsed
+        static bool enabled;
+
+    private:
+
+        static void fold(DataFilterRuntime *df, Leaf *leaf, Stats &stats);
+        static void assigned(DataFilterRuntime *df, Leaf *leaf, QStringList &symbols);
+        static bool invariant(DataFilterRuntime *df, Leaf *leaf, const QStringList &assigned, bool &calls);
+        static void hoist(DataFilterRuntime *df, Leaf *leaf, const QStringList &assigned, QHash<QString,int> &ids, Stats &stats);
+        static void dump(Leaf *leaf, int level, QStringList &lines);
+};
+
+#endif // _GC_DataFilterOptimizer_h
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2026 The GoldenCheetah Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "DataFilterProfile.h"
+#include "DataFilter.h"
+
+#include <QThread>
+#include <QFile>
+#include <QTextStream>
+#include <QMutexLocker>
+
+#include <algorithm>
+
+DataFilterProfile::DataFilterProfile()
+{
+    clock.start();
+}
+
+bool
+DataFilterProfile::profiled(Leaf *leaf)
+{
+    return leaf->type == Leaf::Function || (leaf->type == Leaf::Compound && leaf->function != "");
+}
+
+QString
+DataFilterProfile::name(Leaf *leaf)
+{
+    if (leaf->type == Leaf::Compound) return leaf->function + " { }";
+    return leaf->function + "()";
+}
+
+void
+DataFilterProfile::enter(const QString &name)
+{
+    QMutexLocker locker(&mutex);
+
+    Frame add;
+    add.name = name;
+    add.start = clock.nsecsElapsed();
+    add.children = 0;
+    add.allocations = Result::allocations;
+    add.childallocations = 0;
+    stacks[QThread::currentThreadId()] << add;
+}
+
+void
+DataFilterProfile::leave()
+{
+    QMutexLocker locker(&mutex);
+
+    QVector<Frame> &stack = stacks[QThread::currentThreadId()];
+    if (stack.isEmpty()) return;
+
+    Frame frame = stack.takeLast();
+    qint64 elapsed = clock.nsecsElapsed() - frame.start;
+    qint64 allocations = Result::allocations - frame.allocations;
+
+    Entry &entry = profile[frame.name];
+    entry.name = frame.name;
+    entry.calls++;
+    entry.self += elapsed - frame.children;
+    entry.allocations += allocations - frame.childallocations;
+
+    // a recursive call is already in the total of the outer one
+    bool recursive = false;
+    foreach(const Frame &outer, stack) if (outer.name == frame.name) recursive = true;
+    if (!recursive) entry.total += elapsed;
+
+    if (!stack.isEmpty()) {
+        stack.last().children += elapsed;
+        stack.last().childallocations += allocations;
+    }
+}
+
+void
+DataFilterProfile::clear()
+{
+    QMutexLocker locker(&mutex);
+    stacks.clear();
+    profile.clear();
+}
+
+bool
+DataFilterProfile::isEmpty() const
+{
+    QMutexLocker locker(&mutex);
+    return profile.isEmpty();
+}
+
+QList<DataFilterProfile::Entry>
+DataFilterProfile::entries() const
+{
+    QMutexLocker locker(&mutex);
+
+    QList<Entry> returning = profile.values();
+    std::sort(returning.begin(), returning.end(), [](const Entry &a, const Entry &b) { return a.self > b.self; });
+    return returning;
+}
+
+QString
+DataFilterProfile::report() const
+{
+    QString returning = QString("%1 %2 %3 %4 %5\n").arg("", -32).arg(QObject::tr("calls"), 10)
+                        .arg(QObject::tr("total ms"), 12).arg(QObject::tr("self ms"), 12).arg(QObject::tr("allocations"), 12);
+
+    foreach(const Entry &entry, entries()) {
+        returning += QString("%1 %2 %3 %4 %5\n").arg(entry.name, -32).arg(entry.calls, 10)
+                     .arg(entry.total / 1000000.0, 12, 'f', 3).arg(entry.self / 1000000.0, 12, 'f', 3)
+                     .arg(entry.allocations, 12);
+    }
+    return returning;
+}
+
+bool
+DataFilterProfile::save(const QString &filename) const
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) return false;
+
+    QTextStream out(&file);
+    out << "name,calls,total ms,self ms,allocations\n";
+    foreach(const Entry &entry, entries()) {
+        out << "\"" << entry.name << "\"," << entry.calls << ","
+            << QString::number(entry.total / 1000000.0, 'f', 3) << ","
+            << QString::number(entry.self / 1000000.0, 'f', 3) << ","
+            << entry.allocations << "\n";
+    }
+    file.close();
+    return true;
+}
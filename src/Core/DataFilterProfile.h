@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2026 The GoldenCheetah Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_DataFilterProfile_h
+#define _GC_DataFilterProfile_h 1
+
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QVector>
+#include <QMutex>
+#include <QElapsedTimer>
+
+class Leaf;
+
+//
+// Where the time goes when a user chart or user metric program runs,
+// to find the slow part of it.
+//
+// Set as the runtime's profile and Leaf::eval records every call of a
+// function block (sample { } et al), a user function or a builtin: how
+// many times it was called, the time spent in it (total) and in it but
+// not in anything else recorded (self), and the values holding vectors
+// or strings it allocated (self). The builtins a compiled program runs
+// itself are in the self time of the function calling them, and samples
+// computed as a batch are a single call of "sample { } (batch)". Callers
+// can add their own entries, around each series of a chart for example.
+//
+// It is only set when asked for in the editors since timing every call
+// adds to the cost of it. Runtimes copied for other threads share the
+// profile so it is guarded by a mutex.
+//
+class DataFilterProfile
+{
+    public:
+
+        DataFilterProfile();
+
+        struct Entry {
+            Entry() : calls(0), total(0), self(0), allocations(0) {}
+            QString name;
+            qint64 calls;
+            qint64 total, self;         // nanoseconds
+            qint64 allocations;
+        };
+
+        // function blocks and calls, as named in the profile
+        static bool profiled(Leaf *leaf);
+        static QString name(Leaf *leaf);
+
+        // calls nest, leave() ends the last one entered by the thread
+        void enter(const QString &name);
+        void leave();
+
+        // enter() and leave() for a block of code
+        class Scope {
+            public:
+                Scope(DataFilterProfile *profile, const QString &name) : profile(profile) { if (profile) profile->enter(name); }
+                ~Scope() { if (profile) profile->leave(); }
+            private:
+                DataFilterProfile *profile;
+        };
+
+        void clear();
+        bool isEmpty() const;
+
+        QList<Entry> entries() const;               // most self time first
+        QString report() const;                     // as a table
+        bool save(const QString &filename) const;   // as csv
+
+    private:
+
+        struct Frame {
+            QString name;
+            qint64 start, children;
+            qint64 allocations, childallocations;
+        };
+
+        mutable QMutex mutex;
+        QElapsedTimer clock;
+        QHash<Qt::HANDLE, QVector<Frame> > stacks; // for each thread
+        QHash<QString, Entry> profile;
+};
+
+#endif // _GC_DataFilterProfile_h
@@ -0,0 +1,557 @@
+/*
+ * Copyright (c) 2026 The GoldenCheetah Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "DataFilterProgram.h"
+#include "RideItem.h"
+#include "RideFile.h"
+
+#include "DataFilter_yacc.h"
+
+#include <QDebug>
+#include <QVarLengthArray>
+#include <cmath>
+
+// same bound the tree interpreter puts on while loops
+static const int maxwhile = 1000000;
+
+DataFilterProgram *
+DataFilterProgram::compile(DataFilterRuntime *, Leaf *leaf)
+{
+    if (!leaf) return NULL;
+
+    // a lone symbol, literal or function call is just as
+    // quick to evaluate by walking the tree
+    switch (leaf->type) {
+    case Leaf::Logical :
+    case Leaf::Operation :
+    case Leaf::BinaryOperation :
+    case Leaf::UnaryOperation :
+    case Leaf::Conditional :
+    case Leaf::Compound :
+        break;
+    default:
+        return NULL;
+    }
+
+    DataFilterProgram *program = new DataFilterProgram(leaf);
+    Value v = program->compile(leaf);
+    program->result = v.reg;
+    program->isnum = v.num;
+
+    // handing the whole thing back to the tree would recurse
+    foreach(const Instruction &i, program->instructions) {
+        if (i.code == Eval && i.leaf == leaf) {
+            delete program;
+            return NULL;
+        }
+    }
+    return program;
+}
+
+int
+DataFilterProgram::evaluates() const
+{
+    int returning = 0;
+    foreach(const Instruction &i, instructions) if (i.code == Eval) returning++;
+    return returning;
+}
+
+bool
+DataFilterProgram::scalar(Leaf *leaf)
+{
+    // must match the types node() returns
+    if (!leaf) return true;
+    if (leaf->invariant) return false;
+
+    switch (leaf->type) {
+
+    case Leaf::Float :
+    case Leaf::Integer :
+    case Leaf::UnaryOperation :
+        return true;
+
+    case Leaf::Logical :
+        if (leaf->op == AND || leaf->op == OR) return true;
+        return scalar(leaf->lvalue.l);
+
+    case Leaf::BinaryOperation :
+    case Leaf::Operation :
+        switch (leaf->op) {
+        case ASSIGN: return leaf->lvalue.l->type == Leaf::Symbol && scalar(leaf->rvalue.l);
+        case ELVIS: return scalar(leaf->lvalue.l);
+        case ADD:
+        case SUBTRACT:
+        case DIVIDE:
+        case MULTIPLY:
+        case POW: return scalar(leaf->lvalue.l) && scalar(leaf->rvalue.l);
+        default: return true; // comparisons are always true or false
+        }
+
+    case Leaf::Conditional :
+        if (leaf->op == IF_ || leaf->op == 0) return scalar(leaf->lvalue.l) && (!leaf->rvalue.l || scalar(leaf->rvalue.l));
+        if (leaf->op == WHILE) return scalar(leaf->lvalue.l);
+        return true;
+
+    case Leaf::Compound :
+        return leaf->lvalue.b->isEmpty() || scalar(leaf->lvalue.b->last());
+
+    case Leaf::Function :
+        return Leaf::mathFunction(leaf) && scalar(leaf->fparms[0]);
+
+    default:
+        return false;
+    }
+}
+
+DataFilterProgram::Value
+DataFilterProgram::compile(Leaf *leaf)
+{
+    int nmark = nums, rmark = results;
+    Value v = node(leaf);
+
+    // free the temporaries, but not the value
+    if (v.num) {
+        if (v.reg != nmark) emit(NumMove, nmark, v.reg);
+        v.reg = nmark;
+        nums = nmark + 1;
+        results = rmark;
+    } else {
+        if (v.reg != rmark) emit(Move, rmark, v.reg);
+        v.reg = rmark;
+        results = rmark + 1;
+        nums = nmark;
+    }
+    return v;
+}
+
+DataFilterProgram::Value
+DataFilterProgram::node(Leaf *leaf)
+{
+    Value returning = { true, 0 };
+
+    // NULL evaluates to zero
+    if (!leaf) return constant(0);
+
+    // the tree keeps the value for the ride
+    if (leaf->invariant) return fallback(leaf);
+
+    switch (leaf->type) {
+
+    case Leaf::Float :
+        return constant(leaf->lvalue.f);
+
+    case Leaf::Integer :
+        return constant(leaf->lvalue.i);
+
+    case Leaf::Logical :
+    {
+        // parenthesis
+        if (leaf->op != AND && leaf->op != OR) return compile(leaf->lvalue.l);
+
+        // short circuit, the rhs is only evaluated if needed
+        bool isand = (leaf->op == AND);
+        OpCode test = isand ? JumpZero : JumpNotZero;
+
+        returning.reg = num();
+        int first = emit(test, 0, compileTruth(leaf->lvalue.l));
+        int second = emit(test, 0, compileTruth(leaf->rvalue.l));
+        emit(NumConst, returning.reg);
+        instructions.last().k = isand ? 1 : 0;
+        int done = emit(Jump);
+        patch(first);
+        patch(second);
+        emit(NumConst, returning.reg);
+        instructions.last().k = isand ? 0 : 1;
+        patch(done);
+        return returning;
+    }
+
+    case Leaf::UnaryOperation :
+    {
+        returning.reg = num();
+        int a = compileNum(leaf->lvalue.l);
+        if (leaf->op == '-') emit(NumNeg, returning.reg, a);
+        else if (leaf->op == '!') emit(NumNot, returning.reg, a);
+        else emit(NumConst, returning.reg); // k is zero
+        return returning;
+    }
+
+    case Leaf::BinaryOperation :
+    case Leaf::Operation :
+    {
+        switch (leaf->op) {
+
+        case ASSIGN:
+        {
+            // assigning to an element is left to the tree
+            if (leaf->lvalue.l->type != Leaf::Symbol) return fallback(leaf);
+
+            returning = compile(leaf->rvalue.l);
+            emit(returning.num ? AssignNum : Assign, 0, returning.reg);
+            instructions.last().leaf = leaf->lvalue.l;
+            return returning;
+        }
+
+        case ELVIS:
+        {
+            // only when lhs is a number, it is odd with a string
+            if (!scalar(leaf->lvalue.l)) return fallback(leaf);
+
+            returning.reg = num();
+            int a = compile(leaf->lvalue.l).reg;
+            emit(NumMove, returning.reg, a);
+            int done = emit(JumpNotZero, 0, a);
+            emit(NumMove, returning.reg, compileNum(leaf->rvalue.l));
+            patch(done);
+            return returning;
+        }
+
+        case ADD:
+        case SUBTRACT:
+        case DIVIDE:
+        case MULTIPLY:
+        case POW:
+        {
+            if (scalar(leaf->lvalue.l) && scalar(leaf->rvalue.l)) {
+
+                OpCode code = NumAdd;
+                switch (leaf->op) {
+                case SUBTRACT: code = NumSub; break;
+                case DIVIDE: code = NumDiv; break;
+                case MULTIPLY: code = NumMul; break;
+                case POW: code = NumPow; break;
+                }
+
+                returning.reg = num();
+                int a = compile(leaf->lvalue.l).reg;
+                int b = compile(leaf->rvalue.l).reg;
+                emit(code, returning.reg, a, b);
+                return returning;
+            }
+
+            // vectors and strings
+            returning.num = false;
+            returning.reg = res();
+            int a = box(compile(leaf->lvalue.l));
+            int b = box(compile(leaf->rvalue.l));
+            emit(Operate, returning.reg, a, b);
+            instructions.last().op = leaf->op;
+            return returning;
+        }
+
+        case EQ:
+        case NEQ:
+        case LT:
+        case LTE:
+        case GT:
+        case GTE:
+            if (scalar(leaf->lvalue.l)) {
+
+                OpCode code = NumEq;
+                switch (leaf->op) {
+                case NEQ: code = NumNeq; break;
+                case LT: code = NumLt; break;
+                case LTE: code = NumLte; break;
+                case GT: code = NumGt; break;
+                case GTE: code = NumGte; break;
+                }
+
+                returning.reg = num();
+                int a = compile(leaf->lvalue.l).reg;
+                int b = compileNum(leaf->rvalue.l);
+                emit(code, returning.reg, a, b);
+                return returning;
+            }
+            // fall through, string comparison
+
+        case MATCHES:
+        case ENDSWITH:
+        case BEGINSWITH:
+        case CONTAINS:
+        {
+            returning.reg = num();
+            int t = res();
+            int a = box(compile(leaf->lvalue.l));
+            int b = box(compile(leaf->rvalue.l));
+            emit(Operate, t, a, b);
+            instructions.last().op = leaf->op;
+            emit(ToNum, returning.reg, t);
+            return returning;
+        }
+
+        default:
+        {
+            // both sides are evaluated regardless
+            returning.reg = num();
+            compile(leaf->lvalue.l);
+            compile(leaf->rvalue.l);
+            emit(NumConst, returning.reg); // k is zero
+            return returning;
+        }
+        }
+    }
+    break;
+
+    case Leaf::Conditional :
+    {
+        returning.num = scalar(leaf);
+        returning.reg = returning.num ? num() : res();
+
+        if (leaf->op == IF_ || leaf->op == 0) {
+
+            int otherwise = emit(JumpZero, 0, compileTruth(leaf->cond.l));
+            store(returning.reg, returning.num, compile(leaf->lvalue.l));
+            int done = emit(Jump);
+            patch(otherwise);
+            store(returning.reg, returning.num, compile(leaf->rvalue.l)); // NULL is zero
+            patch(done);
+
+        } else if (leaf->op == WHILE) {
+
+            store(returning.reg, returning.num, constant(0));
+            int count = num();
+            emit(LoopInit, count);
+            int top = instructions.count();
+            int runaway = emit(LoopTest, count);
+            int finished = emit(JumpZero, 0, compileNum(leaf->cond.l));
+            store(returning.reg, returning.num, compile(leaf->lvalue.l));
+            emit(Jump);
+            instructions.last().target = top;
+            patch(runaway);
+            patch(finished);
+            emit(LoopEnd, count);
+
+        } else {
+            store(returning.reg, returning.num, constant(0));
+        }
+        return returning;
+    }
+
+    case Leaf::Symbol :
+    {
+        returning.num = false;
+        returning.reg = res();
+        emit(Load, returning.reg);
+        instructions.last().leaf = leaf;
+        return returning;
+    }
+
+    case Leaf::Compound :
+    {
+        QList<Leaf*> &statements = *(leaf->lvalue.b);
+        if (statements.isEmpty()) return constant(0);
+
+        // we only keep the value of the last statement
+        for (int i=0; i<statements.count()-1; i++) {
+            int nmark = nums, rmark = results;
+            compile(statements[i]);
+            nums = nmark;
+            results = rmark;
+        }
+        return compile(statements.last());
+    }
+
+    case Leaf::Function :
+    {
+        // the math.h functions, anything else is left to the tree
+        Leaf::MathFunction func = Leaf::mathFunction(leaf);
+        if (!func) break;
+
+        if (scalar(leaf->fparms[0])) {
+            returning.reg = num();
+            emit(NumCall, returning.reg, compile(leaf->fparms[0]).reg);
+        } else {
+            returning.num = false;
+            returning.reg = res();
+            emit(Call, returning.reg, box(compile(leaf->fparms[0])));
+        }
+        instructions.last().fn = func;
+        return returning;
+    }
+
+    case Leaf::Index :
+    {
+        // the index is evaluated first, as in the tree
+        returning.num = false;
+        returning.reg = res();
+        int b = box(compile(leaf->fparms[0]));
+        int a = box(compile(leaf->lvalue.l));
+        emit(Index, returning.reg, a, b);
+        return returning;
+    }
+
+    default:
+        break;
+    }
+
+    // strings, other functions, select and scripts
+    return fallback(leaf);
+}
+
+int
+DataFilterProgram::compileNum(Leaf *leaf)
+{
+    // sample values don't need to go through a Result
+    if (leaf && leaf->type == Leaf::Symbol) {
+        int returning = num();
+        emit(LoadNum, returning);
+        instructions.last().leaf = leaf;
+        return returning;
+    }
+
+    Value v = compile(leaf);
+    if (v.num) return v.reg;
+
+    int returning = num();
+    emit(ToNum, returning, v.reg);
+    return returning;
+}
+
+int
+DataFilterProgram::compileTruth(Leaf *leaf)
+{
+    // zero or non-zero is all that matters for a number
+    Value v = compile(leaf);
+    if (v.num) return v.reg;
+
+    int returning = num();
+    emit(Truth, returning, v.reg);
+    return returning;
+}
+
+int
+DataFilterProgram::box(Value v)
+{
+    if (!v.num) return v.reg;
+
+    int returning = res();
+    emit(Box, returning, v.reg);
+    return returning;
+}
+
+void
+DataFilterProgram::store(int dst, bool num, Value v)
+{
+    if (num) emit(NumMove, dst, v.reg);
+    else emit(Move, dst, box(v));
+}
+
+DataFilterProgram::Value
+DataFilterProgram::constant(double k)
+{
+    Value returning = { true, num() };
+    emit(NumConst, returning.reg);
+        instructions.last().k = k;
+    return returning;
+}
+
+DataFilterProgram::Value
+DataFilterProgram::fallback(Leaf *leaf)
+{
+    Value returning = { false, res() };
+    emit(Eval, returning.reg);
+    instructions.last().leaf = leaf;
+    return returning;
+}
+
+int
+DataFilterProgram::emit(OpCode code, int dst, int a, int b)
+{
+    Instruction add;
+    add.code = code;
+    add.dst = dst;
+    add.a = a;
+    add.b = b;
+    add.target = 0;
+    add.op = 0;
+    add.k = 0;
+    add.fn = NULL;
+    add.leaf = NULL;
+    instructions << add;
+    return instructions.count() - 1;
+}
+
+Result
+DataFilterProgram::run(DataFilterRuntime *df, const Result &x, long it, RideItem *m, RideFilePoint *p,
+                       const QHash<QString,RideMetric*> *c, const Specification &s, const DateRange &d) const
+{
+    QVarLengthArray<double, 32> n(numregs);
+    QVarLengthArray<Result, 8> r(resregs);
+
+    const Instruction *code = instructions.constData();
+    const int count = instructions.count();
+
+    for (int pc=0; pc<count; pc++) {
+
+        const Instruction &i = code[pc];
+        switch (i.code) {
+
+        case NumConst: n[i.dst] = i.k; break;
+        case NumMove: n[i.dst] = n[i.a]; break;
+        case NumNeg: n[i.dst] = n[i.a] * -1; break;
+        case NumNot: n[i.dst] = !n[i.a]; break;
+
+        case NumAdd: n[i.dst] = n[i.a] + n[i.b]; break;
+        case NumSub: n[i.dst] = n[i.a] - n[i.b]; break;
+        case NumMul: n[i.dst] = n[i.a] * n[i.b]; break;
+        case NumDiv: n[i.dst] = n[i.b] ? n[i.a] / n[i.b] : 0; break;
+        case NumPow: n[i.dst] = pow(n[i.a], n[i.b]); break;
+
+        case NumEq: n[i.dst] = n[i.a] == n[i.b]; break;
+        case NumNeq: n[i.dst] = n[i.a] != n[i.b]; break;
+        case NumLt: n[i.dst] = n[i.a] < n[i.b]; break;
+        case NumLte: n[i.dst] = n[i.a] <= n[i.b]; break;
+        case NumGt: n[i.dst] = n[i.a] > n[i.b]; break;
+        case NumGte: n[i.dst] = n[i.a] >= n[i.b]; break;
+
+        case Jump: pc = i.target - 1; break;
+        case JumpZero: if (n[i.a] == 0) pc = i.target - 1; break;
+        case JumpNotZero: if (n[i.a] != 0) pc = i.target - 1; break;
+
+        case LoopInit: n[i.dst] = 0; break;
+        case LoopTest: if (n[i.dst]++ >= maxwhile) pc = i.target - 1; break;
+        case LoopEnd:
+            if (n[i.dst] >= maxwhile)
+                qDebug()<<"WARNING: "<< "[ loops="<<n[i.dst]<<"] runaway while loop terminated, check formula/filter.";
+            break;
+
+        case NumCall: n[i.dst] = i.fn(n[i.a]); break;
+        case Call: r[i.dst] = Leaf::apply(i.fn, r[i.a]); break;
+        case Index: r[i.dst] = Leaf::index(r[i.a], r[i.b]); break;
+
+        case Eval: r[i.dst] = i.leaf->eval(df, i.leaf, x, it, m, p, c, s, d); break;
+        case Load: r[i.dst] = m ? Leaf::symbol(df, i.leaf, x, it, m, p, c) : Result(0); break;
+        case LoadNum:
+            if (!m) n[i.dst] = 0;
+            else if (p && i.leaf->bound.series != RideFile::none && i.leaf->bound.series != RideFile::index) n[i.dst] = p->value(i.leaf->bound.series);
+            else n[i.dst] = Leaf::symbol(df, i.leaf, x, it, m, p, c).number();
+            break;
+        case ToNum: n[i.dst] = r[i.a].number(); break;
+        case Truth: n[i.dst] = r[i.a].isNumber && r[i.a].number(); break;
+        case Box: r[i.dst] = Result(n[i.a]); break;
+        case Move: r[i.dst] = r[i.a]; break;
+        case Operate: r[i.dst] = Leaf::operate(i.op, r[i.a], r[i.b]); break;
+
+        case AssignNum: df->symbols.assign(i.leaf->bound.slot, *(i.leaf->lvalue.n), Result(n[i.a])); break;
+        case Assign: df->symbols.assign(i.leaf->bound.slot, *(i.leaf->lvalue.n), r[i.a]); break;
+        }
+    }
+
+    if (isnum) return Result(n[result]);
+    return r[result];
+}
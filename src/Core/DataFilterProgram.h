@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2026 The GoldenCheetah Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_DataFilterProgram_h
+#define _GC_DataFilterProgram_h 1
+
+#include "DataFilter.h"
+
+#include <QVector>
+
+//
+// A validated DataFilter expression, root or user function, compiled
+// into a flat list of register instructions and run without walking
+// the tree or building a Result for every node.
+//
+// Values known to be plain numbers (literals, arithmetic on numbers,
+// comparisons, logical operators) live in double registers, anything
+// else lives in Result registers. Symbols are loaded through the slot
+// they were bound to. Calls to the math.h functions and indexing are
+// compiled, using the same helpers as the tree. Nodes the compiler does
+// not handle (every other builtin, select, strings and scripts) are
+// evaluated by the tree interpreter and the value loaded into a Result
+// register, so the language semantics are exactly those of Leaf::eval.
+//
+// Programs are attached to their Leaf and run by Leaf::eval, they are
+// never changed once compiled and can be shared by runtimes in other
+// threads (e.g. cloned user metrics).
+//
+class DataFilterProgram
+{
+    public:
+
+        // returns NULL if there is nothing worth compiling
+        static DataFilterProgram *compile(DataFilterRuntime *df, Leaf *leaf);
+
+        Result run(DataFilterRuntime *df, const Result &x, long it, RideItem *m, RideFilePoint *p,
+                   const QHash<QString,RideMetric*> *c, const Specification &s, const DateRange &d) const;
+
+        // nodes left to the tree interpreter
+        int evaluates() const;
+
+    private:
+
+        DataFilterProgram(Leaf *root) : root(root), nums(0), results(0), numregs(0), resregs(0), result(0), isnum(true) {}
+
+        enum OpCode {
+            NumConst,           // n[dst] = k
+            NumMove,            // n[dst] = n[a]
+            NumNeg, NumNot,     // n[dst] = op n[a]
+            NumAdd, NumSub, NumMul, NumDiv, NumPow,             // n[dst] = n[a] op n[b]
+            NumEq, NumNeq, NumLt, NumLte, NumGt, NumGte,        // n[dst] = n[a] op n[b]
+            Jump,               // goto target
+            JumpZero,           // if (n[a] == 0) goto target
+            JumpNotZero,        // if (n[a] != 0) goto target
+            LoopInit,           // n[dst] = 0, while loop counter
+            LoopTest,           // if (n[dst]++ >= maxwhile) goto target
+            LoopEnd,            // warn if n[dst] hit maxwhile
+            NumCall,            // n[dst] = fn(n[a])
+            Call,               // r[dst] = Leaf::apply(fn, r[a])
+            Index,              // r[dst] = Leaf::index(r[a], r[b])
+            Eval,               // r[dst] = leaf->eval(...)
+            Load,               // r[dst] = symbol leaf, via its binding
+            LoadNum,            // n[dst] = symbol leaf as number(), samples directly
+            ToNum,              // n[dst] = r[a].number()
+            Truth,              // n[dst] = r[a].isNumber && r[a].number()
+            Box,                // r[dst] = Result(n[a])
+            Move,               // r[dst] = r[a]
+            Operate,            // r[dst] = Leaf::operate(op, r[a], r[b])
+            AssignNum,          // symbols[leaf] = Result(n[a])
+            Assign              // symbols[leaf] = r[a]
+        };
+
+        struct Instruction {
+            OpCode code;
+            int dst, a, b, target;
+            int op;             // grammar operator for Operate
+            double k;           // constant for NumConst
+            Leaf::MathFunction fn; // for NumCall and Call
+            Leaf *leaf;         // subtree for Eval, symbol for Load and Assign
+        };
+
+        // a compiled value lives in one or other register file
+        struct Value {
+            bool num;
+            int reg;
+        };
+
+        static bool scalar(Leaf *leaf); // compiles to a double register
+
+        Value compile(Leaf *leaf);      // value left in first free register
+        Value node(Leaf *leaf);
+        int compileNum(Leaf *leaf);     // as number(), coerced if needed
+        int compileTruth(Leaf *leaf);   // as isNumber && number()
+        int box(Value v);               // into a Result register
+        void store(int dst, bool num, Value v);
+        Value constant(double k);
+        Value fallback(Leaf *leaf);     // evaluate with the tree interpreter
+
+        int emit(OpCode code, int dst=0, int a=0, int b=0);
+        void patch(int at) { instructions[at].target = instructions.count(); }
+        int num() { if (nums == numregs) numregs++; return nums++; }
+        int res() { if (results == resregs) resregs++; return results++; }
+
+        Leaf *root;
+        QVector<Instruction> instructions;
+        int nums, results;      // registers in use whilst compiling
+        int numregs, resregs;   // registers needed to run
+        int result;             // register holding the result
+        bool isnum;             // .. and which file it is in
+};
+
+#endif // _GC_DataFilterProgram_h
@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2026 The GoldenCheetah Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "EffortSearch.h"
+
+#include <cmath>
+
+// 16, 64 and 256 second blocks
+const int EffortSearch::shift[EffortSearch::levels] = { 4, 6, 8 };
+
+EffortSearch::EffortSearch(const long *integrated, long secs, double CP, double WPRIME, double PMAX) :
+    evaluated(0), integrated(integrated), secs(secs), CP(CP), WPRIME(WPRIME), PMAX(PMAX)
+{
+    // the hulls only give the same answer when slopes compare exactly
+    exact = WPRIME == floor(WPRIME) && fabs(WPRIME) < 1e9;
+    if (!exact) return;
+
+    for (int l=0; l<levels; l++) {
+
+        int size = 1 << shift[l];
+        long blocks = secs >> shift[l]; // whole blocks only
+
+        lo[l].resize(blocks);
+        hullStart[l].resize(blocks+1);
+        hull[l].reserve(blocks * 4);
+
+        for (long b=0; b<blocks; b++) {
+
+            long first = b << shift[l];
+            hullStart[l][b] = hull[l].count();
+
+            lo[l][b] = integrated[first];
+            for (long j=first; j<first+size; j++) {
+
+                if (integrated[j] < lo[l][b]) lo[l][b] = integrated[j];
+
+                // upper hull, points on a line are kept as any of
+                // them may be the one the search would settle on
+                while (hull[l].count() - hullStart[l][b] >= 2) {
+                    long h0 = hull[l][hull[l].count()-2];
+                    long h1 = hull[l].last();
+                    qint64 below = qint64(integrated[h1]-integrated[h0]) * (j-h0)
+                                 - qint64(integrated[j]-integrated[h0]) * (h1-h0);
+                    if (below >= 0) break;
+                    hull[l].removeLast();
+                }
+                hull[l] << int(j);
+            }
+        }
+        hullStart[l][blocks] = hull[l].count();
+    }
+}
+
+bool
+EffortSearch::tte(long i, Effort &tte) const
+{
+    // start out at an hour and drop back to
+    // 2 minutes, anything shorter and we are done
+    int t = (secs-i-1) > 3600 ? 3600 : secs-i-1;
+
+    // if we find one lets record it
+    bool found = false;
+
+    while (t > 120) {
+
+        // all the durations in a block are within TTE so
+        // take its best in one go, the first must be found
+        // the long way as it is kept whatever its quality
+        if (found && exact && block(i, t, tte)) continue;
+
+        evaluated++;
+
+        // calculate the TTE for the joules in the interval
+        // starting at i seconds with duration t
+        // This takes the monod equation p(t) = W'/t + CP and
+        // solves for t, but the added complication of also
+        // accounting for the fact it is expressed in joules
+        // So take Joules = (W'/t + CP) * t and solving that
+        // for t gives t = (Joules - W') / CP
+        double tc = ((integrated[i+t]-integrated[i]) - WPRIME) / CP;
+        // NOTE FOR ABOVE: it is looking at accumulation AFTER this point
+        //                 not FROM this point, so we are looking 1s ahead of i
+        //                 which is why the interval is registered as starting
+        //                 at i+1 in the code below
+
+        // the TTE for this interval is greater or equal to
+        // the duration of the interval !
+        if (tc >= (t*0.85f)) {
+
+            double thisquality = tc / double(t);
+
+            // first one we found, or found one with a higher quality
+            if (found == false || tte.quality < thisquality) {
+                found = true;
+                tte.start = i + 1; // see NOTE above
+                tte.duration = t;
+                tte.joules = integrated[i+t]-integrated[i];
+                tte.quality = thisquality;
+            }
+
+            // look for smaller
+            t--;
+
+        } else {
+            t = tc;
+            if (t<120)
+                t=120;
+        }
+    }
+    return found;
+}
+
+bool
+EffortSearch::block(long i, int &t, Effort &tte) const
+{
+    // largest block that ends at duration t
+    for (int l=levels-1; l>=0; l--) {
+
+        long size = 1 << shift[l];
+        if ((i+t+1) % size) continue;
+
+        long b = (i+t) >> shift[l];
+        int from = (b << shift[l]) - i;
+        if (from <= 120) continue;
+
+        // the shortest TTE in the block is when the joules are least,
+        // when even that is long enough the search steps through all
+        // of them, if not a smaller block might still be
+        double tcmin = ((lo[l][b]-integrated[i]) - WPRIME) / CP;
+        if (!(tcmin >= (t*0.85f))) continue;
+
+        tangent(l, b, i, tte);
+        t = from - 1;
+        return true;
+    }
+    return false;
+}
+
+void
+EffortSearch::tangent(int l, long b, long i, Effort &tte) const
+{
+    const int *h = hull[l].constData() + hullStart[l][b];
+    int n = hullStart[l][b+1] - hullStart[l][b];
+
+    // joules less W' over duration, compared exactly, joules*duration
+    // is well within 64 bits for any realistic ride
+    const qint64 base = qint64(integrated[i]) + qint64(WPRIME);
+    auto compare = [&](int j, int k) {
+        qint64 lhs = (qint64(integrated[j]) - base) * (k-i);
+        qint64 rhs = (qint64(integrated[k]) - base) * (j-i);
+        return lhs < rhs ? -1 : (lhs > rhs ? 1 : 0);
+    };
+
+    // along an upper hull the slope from a point to its left rises to
+    // a maximum then falls, and is only ever flat at the maximum
+    int low=0, high=n-1;
+    while (low < high) {
+        int mid = (low+high) / 2;
+        if (compare(h[mid], h[mid+1]) < 0) low = mid+1;
+        else high = mid;
+    }
+    int last = low;
+    while (last+1 < n && compare(h[low], h[last+1]) == 0) last++;
+
+    // the points on the maximum, in the order the search would see them
+    for (int k=last; k>=low; k--) {
+
+        evaluated++;
+
+        int d = h[k] - i;
+        double tc = ((integrated[h[k]]-integrated[i]) - WPRIME) / CP;
+        double thisquality = tc / double(d);
+
+        if (tte.quality < thisquality) {
+            tte.start = i + 1;
+            tte.duration = d;
+            tte.joules = integrated[h[k]]-integrated[i];
+            tte.quality = thisquality;
+        }
+    }
+}
+
+bool
+EffortSearch::sprint(long i, Effort &sprint) const
+{
+    // from where the TTE search ends, 2 minutes or less
+    int t = (secs-i-1) > 120 ? 120 : secs-i-1;
+
+    // if we find one lets record it
+    bool found = false;
+
+    // Search sprint
+    while (t >= 5) {
+        // On Pmax only
+        // double tc = (integrated[i+t]-integrated[i]) / (PMAX);
+
+        // With the 3 components model
+        // t = W'/(P − CP) + W'/(CP − Pmax)
+        double p = (integrated[i+t]-integrated[i])/t;
+
+        if (p>0.5*(PMAX-CP)+CP) {
+            double tc = WPRIME / (p-CP) + WPRIME / ( CP - PMAX);
+
+            if (tc >= (t*0.85f)) {
+
+                double thisquality = double(t) + (integrated[i+t]-integrated[i])/t/1000.0;
+
+                // first one we found, or found one with a higher quality
+                if (found == false || sprint.quality < thisquality) {
+                    found = true;
+                    sprint.start = i + 1; // see NOTE above
+                    sprint.duration = t;
+                    sprint.joules = integrated[i+t]-integrated[i];
+                    sprint.quality = thisquality;
+                }
+            }
+        }
+        // look for smaller
+        t--;
+    }
+    return found;
+}
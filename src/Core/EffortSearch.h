@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2026 The GoldenCheetah Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_EffortSearch_h
+#define _GC_EffortSearch_h 1
+
+#include <QVector>
+
+//
+// The search for TTE efforts and sprints when discovering intervals,
+// over the 1s integrated (cumulative joules) power series.
+//
+// For each start second the TTE search walks the durations down from
+// an hour, jumping to the TTE of the joules when a duration is beyond
+// it and stepping down a second at a time while it isn't, keeping the
+// best quality seen. During a long hard effort that is a step for
+// every second of it, at every start second.
+//
+// Instead the durations are taken a block at a time, on blocks of 16,
+// 64 and 256 seconds aligned on the series, largest first. When the
+// minimum of the series over a block shows every duration in it is
+// within its TTE the walk would step through all of them, and the one
+// it would keep is on the upper convex hull of the block's points:
+// quality is the slope from (start, joules at start + W') to them.
+// The hulls are built once, and the best point on one is a binary
+// search, so a block costs a few steps rather than one for each
+// second of it. Slopes are compared exactly in integer arithmetic and
+// points on the same line are all tried, so the efforts found are
+// the same as a second at a time. A W' with a fraction falls back to
+// a second at a time.
+//
+class EffortSearch
+{
+    public:
+
+        struct Effort {
+            int start, duration, joules;
+            double quality;
+        };
+
+        EffortSearch(const long *integrated, long secs, double CP, double WPRIME, double PMAX);
+
+        // best TTE and sprint starting 1s after second i, false if none
+        bool tte(long i, Effort &effort) const;
+        bool sprint(long i, Effort &effort) const;
+
+        // durations evaluated, for profiling
+        mutable long evaluated;
+
+    private:
+
+        // take the block of durations ending at t in one go if we can
+        bool block(long i, int &t, Effort &tte) const;
+        void tangent(int l, long b, long i, Effort &tte) const;
+
+        const long *integrated;
+        long secs;
+        double CP, WPRIME, PMAX;
+        bool exact;                 // W' is whole joules
+
+        // minimum and upper hull of each aligned block for each block size
+        static const int levels = 3;
+        static const int shift[levels];
+        QVector<long> lo[levels];
+        QVector<int> hull[levels], hullStart[levels];
+};
+
+#endif // _GC_EffortSearch_h
@@ -65,7 +65,7 @@ Measure::getSourceDescription() const
 
 ///////////////////////////// MeasuresGroup class ///////////////////////////
 
-MeasuresGroup::MeasuresGroup(QString symbol, QString name, QStringList symbols, QStringList names, QStringList metricUnits, QStringList imperialUnits, QList<double>unitsFactors, QList<QStringList> headers,  QDir dir, bool withData) : dir(dir), withData(withData), symbol(symbol), name(name), symbols(symbols), names(names), metricUnits(metricUnits), imperialUnits(imperialUnits), unitsFactors(unitsFactors), headers(headers)
+MeasuresGroup::MeasuresGroup(QString symbol, QString name, QStringList symbols, QStringList names, QStringList metricUnits, QStringList imperialUnits, QList<double>unitsFactors, QList<QStringList> headers,  QDir dir, bool withData) : dir(dir), withData(withData), symbol(symbol), name(name), symbols(symbols), names(names), metricUnits(metricUnits), imperialUnits(imperialUnits), unitsFactors(unitsFactors), headers(headers), carryForward(false)
 {
     // don't load data if not requested
     if (!withData) return;
@@ -94,7 +94,29 @@ void
 MeasuresGroup::setMeasures(QList<Measure>&x)
 {
     measures_ = x;
-    std::sort(measures_.begin(), measures_.end()); // date order
+    std::stable_sort(measures_.begin(), measures_.end()); // date order
+    buildIndex();
+}
+
+void
+MeasuresGroup::buildIndex()
+{
+    carryForward = (symbol == "Body"); //TODO generalize
+
+    index.clear();
+    indexStart = QDate();
+    if (measures_.isEmpty()) return;
+
+    indexStart = measures_.first().when.date();
+    index.fill(-1, indexStart.daysTo(measures_.last().when.date()) + 1);
+
+    // mark the last measure on each day
+    for (int i=0; i<measures_.count(); i++)
+        index[indexStart.daysTo(measures_.at(i).when.date())] = i;
+
+    // and fill forward for the days in between
+    for (int d=1; d<index.count(); d++)
+        if (index[d] < 0) index[d] = index[d-1];
 }
 
 QDate
@@ -115,33 +137,37 @@ MeasuresGroup::getEndDate() const
         return QDate();
 }
 
-void
-MeasuresGroup::getMeasure(QDate date, Measure &here) const
+const Measure *
+MeasuresGroup::getMeasure(QDate date) const
 {
-    // always set to not found before searching
-    here = Measure();
+    if (index.isEmpty() || !date.isValid()) return NULL;
 
-    // loop
-    foreach(Measure x, measures_) {
+    // before the first, or after the last
+    qint64 day = indexStart.daysTo(date);
+    if (day < 0) return NULL;
+    const Measure *found = &measures_.at(day < index.count() ? index[day] : measures_.count()-1);
 
-        if (symbol == "Body" && x.when.date() < date) here = x;//TODO generalize
-        if (x.when.date() == date) here = x;
-        if (x.when.date() > date) break;
-    }
+    // only carry forward if we should
+    if (!carryForward && found->when.date() != date) return NULL;
+    return found;
+}
 
+void
+MeasuresGroup::getMeasure(QDate date, Measure &here) const
+{
     // will be empty if none found
-    return;
+    const Measure *found = getMeasure(date);
+    here = found ? *found : Measure();
 }
 
 double
 MeasuresGroup::getFieldValue(QDate date, int field, bool useMetricUnits) const
 {
-    Measure measure;
-    getMeasure(date, measure);
+    const Measure *measure = getMeasure(date);
 
     // return what was asked for!
-    if (field >= 0 && field < MAX_MEASURES)
-        return measure.values[field]*(useMetricUnits ? 1.0 : unitsFactors[field]);
+    if (measure && field >= 0 && field < MAX_MEASURES)
+        return measure->values[field]*(useMetricUnits ? 1.0 : unitsFactors[field]);
     else
         return 0.0;
 }
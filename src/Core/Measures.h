@@ -25,6 +25,7 @@
 #include <QDir>
 #include <QString>
 #include <QStringList>
+#include <QVector>
 
 #define MAX_MEASURES 16
 class Measure {
@@ -62,7 +63,7 @@ public:
     double values[MAX_MEASURES]; // field values for standard measures
 
     // used by std::sort
-    bool operator< (Measure right) const { return (when < right.when); }
+    bool operator< (const Measure &right) const { return (when < right.when); }
 
     // calculate a CRC for the Measure data - used to see if
     // data is changed in Configuration pages
@@ -88,12 +89,13 @@ public:
     // Default constructor intended to access metadata,
     // directory and withData must be provided to access data.
     MeasuresGroup(QString symbol, QString name, QStringList symbols, QStringList names, QStringList metricUnits, QStringList imperialUnits, QList<double> unitsFactors, QList<QStringList> headers,  QDir dir=QDir(), bool withData=false);
-    MeasuresGroup(QDir dir=QDir(), bool withData=false) : dir(dir), withData(withData) {}
+    MeasuresGroup(QDir dir=QDir(), bool withData=false) : dir(dir), withData(withData), carryForward(false) {}
     ~MeasuresGroup() {}
     void write();
-    QList<Measure>& measures() { return measures_; }
+    QList<Measure>& measures() { return measures_; } // use setMeasures() to change them
     void setMeasures(QList<Measure>&x);
     void getMeasure(QDate date, Measure&) const;
+    const Measure *getMeasure(QDate date) const; // NULL if none, no copying
 
     // Common access to Measures
     QString getSymbol() const { return symbol; }
@@ -112,7 +114,7 @@ public:
     QDate getEndDate() const;
 
     // Setters for config
-    void setSymbol(QString s) { symbol = s; }
+    void setSymbol(QString s) { symbol = s; buildIndex(); }
     void setName(QString n) { name = n; }
     void addField(MeasuresField &fieldSettings);
     void setField(int field, MeasuresField &fieldSettings);
@@ -129,6 +131,15 @@ private:
     QList<QStringList> headers;
     QList<Measure> measures_;
 
+    // measures_ are in date order, the index maps each day from the first
+    // to the last measure to the last measure taken on or before that day
+    // so lookups by date don't need to search; Body measures carry forward
+    // until the next one is taken, all others only apply on the day
+    void buildIndex();
+    QDate indexStart;
+    QVector<int> index;
+    bool carryForward;
+
     bool serialize(QString, QList<Measure> &);
     bool unserialize(QFile &, QList<Measure> &);
 };
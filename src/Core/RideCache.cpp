@@ -70,6 +70,9 @@ RideCache::RideCache(Context *context) : context(context)
 
     progress_ = 100;
     exiting = false;
+    loading = true;
+    loadCancelled = loadSignalled = false;
+    model_ = NULL;
     estimator = new Estimator(context);
 
     // initial load of user defined metrics - do once we have an initial context
@@ -141,18 +144,103 @@ RideCache::RideCache(Context *context) : context(context)
     // now sort it - we need to use find on it
     std::sort(rides_.begin(), rides_.end(), rideCacheLessThan);
 
-    // load the store - will unstale once cache restored
-    RideCacheLoader *rideCacheLoader = new RideCacheLoader(this);
-    connect(rideCacheLoader, SIGNAL(finished()), this, SLOT(postLoad()));
-    connect(rideCacheLoader, SIGNAL(finished()), this, SIGNAL(loadComplete()));
-    rideCacheLoader->start();
+    // load the store - will unstale once cache restored, the most
+    // recent rides arrive first via applyLoaded() and the rest
+    // follow in the background, postLoad() runs when its all done
+    loader = new RideCacheLoader(this);
+    connect(loader, SIGNAL(finished()), this, SLOT(postLoad()));
+    loader->start();
+}
+
+bool
+RideCache::loadBatch(QVector<RideItem*> &batch)
+{
+    // called from the loader thread
+    loadMutex.lock();
+    bool cancelled = loadCancelled;
+    if (!cancelled) loaded_ << batch;
+    loadMutex.unlock();
+
+    if (cancelled) {
+        foreach(RideItem *item, batch) {
+            item->context = NULL; // not one of ours
+            delete item;
+        }
+    } else {
+        QMetaObject::invokeMethod(this, "applyLoaded", Qt::QueuedConnection);
+    }
+    batch.clear();
+    return !cancelled;
+}
+
+void
+RideCache::applyLoaded()
+{
+    loadMutex.lock();
+    QVector<RideItem*> batch = loaded_;
+    loaded_.clear();
+    loadMutex.unlock();
+
+    if (batch.isEmpty()) return;
+
+    QDate oldest;
+    foreach(RideItem *item, batch) {
+
+        // find entry and update it
+        int index=find(item);
+        if (index==-1)  qDebug()<<"unable to load:"<<item->fileName<<item->dateTime<<item->weight;
+        else if (rides_.at(index)->ride_ != NULL || rides_.at(index)->isDirty()) {
+
+            // opened or edited while we were loading, setFrom() would drop
+            // the open ride and the edits, it stays stale and is refreshed
+            // once the load completes
+        } else {
+            rides_.at(index)->setFrom(*item);
+
+            // intervals now belong to the cache entry
+            item->clearIntervals();
+
+            // rideDB.json is only newest first once we've saved it
+            QDate date = item->dateTime.date();
+            if (!oldest.isValid() || date < oldest) oldest = date;
+        }
+
+        // intervals that weren't taken are ours to delete
+        qDeleteAll(item->intervals());
+        item->clearIntervals();
+        item->context = NULL; // not one of ours
+        delete item;
+    }
+
+    if (!loadSignalled) {
+
+        // first screenful is ready, let the athlete open while
+        // the older rides continue to load in the background
+        model_ = new RideCacheModel(context, this);
+        loadSignalled = true;
+        emit loadComplete();
+
+    } else if (oldest.isValid()) {
+
+        // older rides arriving, same as a refresh working back
+        context->notifyRefreshUpdate(oldest);
+    }
 }
 
 void
 RideCache::postLoad()
 {
-    // set model once we have the basics
-    model_ = new RideCacheModel(context, this);
+    // pick up any stragglers
+    applyLoaded();
+    loading = false;
+
+    // set model once we have the basics, if we didn't
+    // get any rides from the cache in the first place
+    if (!loadSignalled) {
+        model_ = new RideCacheModel(context, this);
+        loadSignalled = true;
+        emit loadComplete();
+    }
 
     // after the first ridecache refresh we set initial pd estimates
     first= true;
@@ -180,10 +268,41 @@ RideCache::find(RideItem *dt)
     return index;
 }
 
+struct compareridedate {
+    bool operator()(const RideItem *p, const QDate &d) const { return p->dateTime.date() < d; }
+    bool operator()(const QDate &d, const RideItem *p) const { return d < p->dateTime.date(); }
+};
+
+RideItemRange
+RideCache::ridesInRange(QDate from, QDate to) const
+{
+    RideItemRange::const_iterator b = rides_.constBegin();
+    RideItemRange::const_iterator e = rides_.constEnd();
+
+    if (from.isValid()) b = std::lower_bound(b, e, from, compareridedate());
+    if (to.isValid()) e = std::upper_bound(b, e, to, compareridedate());
+
+    return RideItemRange(b, e);
+}
+
 RideCache::~RideCache()
 {
     exiting = true;
 
+    // stop loading if we're still going
+    loadMutex.lock();
+    loadCancelled = true;
+    loadMutex.unlock();
+    loader->wait();
+    delete loader;
+    loadMutex.lock();
+    foreach(RideItem *item, loaded_) {
+        item->context = NULL; // not one of ours
+        delete item;
+    }
+    loaded_.clear();
+    loadMutex.unlock();
+
     // cancel any refresh that may be running
     cancel();
 
@@ -572,8 +691,8 @@ RideCache::cancel()
 void
 RideCache::refresh()
 {
-    // already on it !
-    if (refreshThreads.count()) return;
+    // already on it, or not loaded yet (postLoad will refresh) !
+    if (refreshThreads.count() || loading) return;
 
     // how many need refreshing ?
     int staleCount = 0;
@@ -635,7 +754,7 @@ RideCache::getAggregate(QString name, Specification spec, bool useMetricUnits, b
     double rcount = 0; // using double to avoid rounding issues with int when dividing
 
     // loop through and aggregate
-    foreach (RideItem *item, rides()) {
+    foreach (RideItem *item, ridesInRange(spec.dateRange())) {
 
         // skip filtered rides
         if (!spec.pass(item)) continue;
@@ -732,7 +851,7 @@ RideCache::getBests(QString symbol, int n, Specification specification, bool use
     if (!metric) return results;
 
     // loop through and aggregate
-    foreach (RideItem *ride, rides_) {
+    foreach (RideItem *ride, ridesInRange(specification.dateRange())) {
 
         // skip filtered rides
         if (!specification.pass(ride)) continue;
@@ -869,7 +988,7 @@ RideCache::getRideTypeCounts(Specification specification, int& nActivities,
     sport = "";
 
     // loop through and aggregate
-    foreach (RideItem *ride, rides_) {
+    foreach (RideItem *ride, ridesInRange(specification.dateRange())) {
 
         // skip filtered rides
         if (!specification.pass(ride)) continue;
@@ -891,7 +1010,7 @@ RideCache::isMetricRelevantForRides(Specification specification,
                                     SportRestriction sport)
 {
     // loop through and aggregate
-    foreach (RideItem *ride, rides_) {
+    foreach (RideItem *ride, ridesInRange(specification.dateRange())) {
 
         // skip filtered rides
         if (!specification.pass(ride)) continue;
@@ -35,12 +35,32 @@
 class Context;
 class LTMPlot;
 class RideCacheRefreshThread;
+class RideCacheLoader;
 class Specification;
 class AthleteBest;
 class RideCacheModel;
 class Estimator;
 class Banister;
 
+// a contiguous run of rides from the date sorted ride list,
+// only valid until the ride list is next changed
+class RideItemRange
+{
+    public:
+        typedef QVector<RideItem*>::const_iterator const_iterator;
+
+        RideItemRange() {}
+        RideItemRange(const_iterator b, const_iterator e) : b(b), e(e) {}
+
+        const_iterator begin() const { return b; }
+        const_iterator end() const { return e; }
+        int count() const { return int(e - b); }
+        bool isEmpty() const { return b == e; }
+
+    private:
+        const_iterator b, e;
+};
+
 class RideCache : public QObject
 {
     Q_OBJECT
@@ -83,6 +103,11 @@ class RideCache : public QObject
         // is running ?
         bool isRunning() { return refreshThreads.count() != 0; }
 
+        // progressive load, the loader thread hands over batches of
+        // rides as they are parsed (most recent first), returns false
+        // when the load has been cancelled and parsing should stop
+        bool loadBatch(QVector<RideItem*> &batch);
+
         // how is update going?
         QMutex updateMutex;
         int updates; // for watching progress
@@ -92,6 +117,13 @@ class RideCache : public QObject
         // the ride list
 	    QVector<RideItem*>&rides() { return rides_; } 
 
+        // the ride list is kept in date order whenever rides are
+        // added, deleted or moved, so the rides for a range of dates
+        // are found with a binary search rather than scanning every
+        // ride, invalid dates are open ended just like DateRange
+        RideItemRange ridesInRange(QDate from, QDate to) const;
+        RideItemRange ridesInRange(const DateRange &dr) const { return ridesInRange(dr.from, dr.to); }
+
         // add/remove a ride to the list
         void addRide(QString name, bool dosignal, bool select, bool useTempActivities, bool planned);
         bool removeCurrentRide();
@@ -178,6 +210,9 @@ class RideCache : public QObject
         // clear deleted objects
         void garbageCollect();
 
+        // apply rides handed over by the loader thread
+        void applyLoaded();
+
         // first run to initialise estimates
         void initEstimates();
 
@@ -214,6 +249,13 @@ class RideCache : public QObject
 
         QVector<RideCacheRefreshThread*> refreshThreads;
 
+        // progressive load state, loaded_ is the handover
+        // from the loader thread, guarded by loadMutex
+        RideCacheLoader *loader;
+        QMutex loadMutex;
+        QVector<RideItem*> loaded_;
+        bool loading, loadCancelled, loadSignalled;
+
         Estimator *estimator;
         bool first; // updated when estimates are marked stale
 
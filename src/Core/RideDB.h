@@ -28,6 +28,7 @@
 #include <stdio.h>
 #include <QDebug>
 #include <QString>
+#include <QElapsedTimer>
 #include "JsonRideFile.h" // for DATETIME_FORMAT
 
 // change history
@@ -46,6 +47,12 @@
 
 #define RIDEDB_VERSION "2.0"
 
+// rides are written most recent first, the first batch is handed to the
+// cache after RIDEDB_FIRSTMS so the athlete can open with the latest rides
+// while the rest follow every RIDEDB_BATCHMS
+#define RIDEDB_FIRSTMS 150
+#define RIDEDB_BATCHMS 250
+
 class APIWebService;
 class HttpResponse;
 class HttpRequest;
@@ -85,6 +92,13 @@ struct RideDBContext {
 
     // tracks the last progress update sent
     double lastProgressUpdate;
+
+    // progressive load, parsed rides are handed
+    // to the cache in batches as time passes
+    int total;
+    QVector<RideItem*> batch;
+    QElapsedTimer timer;
+    qint64 handover;
 };
 
 #endif
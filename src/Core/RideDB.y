@@ -21,6 +21,7 @@
 #include "RideFileCache.h"
 #include "SpecialFields.h"
 #include "Settings.h"
+#include <algorithm>
 #ifdef GC_WANT_HTTP
 #include "APIWebService.h"
 #endif
@@ -83,16 +84,23 @@ ride: '{' rideelement_list '}'                                  {
                                                                         jc->api->writeRideLine(jc->item, jc->request, jc->response);
                                                                     #endif
                                                                     } else {
-                                                                        double progress= round(double(jc->loading++) / double(jc->cache->rides().count()) * 100.0f);
+                                                                        double progress= round(double(jc->loading++) / double(jc->total) * 100.0f);
                                                                         if (progress > jc->lastProgressUpdate) {
                                                                             jc->context->notifyLoadProgress(jc->folder,progress);
                                                                             jc->lastProgressUpdate = progress;
                                                                         }
 
-                                                                        // find entry and update it
-                                                                        int index=jc->cache->find(&jc->item);
-                                                                        if (index==-1)  qDebug()<<"unable to load:"<<jc->item.fileName<<jc->item.dateTime<<jc->item.weight;
-                                                                        else  jc->cache->rides().at(index)->setFrom(jc->item);
+                                                                        // the ride list may be in use on the gui thread
+                                                                        // so we take a copy and hand them over in batches
+                                                                        RideItem *loaded = new RideItem();
+                                                                        loaded->setFrom(jc->item, true);
+                                                                        loaded->moveToThread(jc->cache->thread());
+                                                                        jc->batch << loaded;
+
+                                                                        if (jc->timer.elapsed() >= jc->handover) {
+                                                                            if (!jc->cache->loadBatch(jc->batch)) YYABORT;
+                                                                            jc->handover = jc->timer.elapsed() + RIDEDB_BATCHMS;
+                                                                        }
                                                                     }
 
                                                                     // now set our ride item clean again, so we don't
@@ -346,6 +354,9 @@ RideCache::load()
         jc->loading = 0;
         jc->lastProgressUpdate = 0.0;
         jc->folder = context->athlete->home->root().canonicalPath();
+        jc->total = rides_.count(); // before the gui starts changing it
+        jc->handover = RIDEDB_FIRSTMS;
+        jc->timer.start();
 
         // clean item
         jc->item.path = directory.canonicalPath(); // TODO use plannedDirectory for planned
@@ -368,6 +379,9 @@ RideCache::load()
         // parse it
         RideDBparse(jc);
 
+        // hand over the remainder
+        loadBatch(jc->batch);
+
         // clean up
         RideDBlex_destroy(scanner);
 
@@ -480,6 +494,8 @@ QString ConstructNameNumberNumberString(QString s0, QString name, QString s1, do
 //
 void RideCache::save(bool opendata, QString filename)
 {
+    // rides we haven't loaded yet would be lost
+    if (loading) return;
 
     // now save data away - use passed filename if set
     QFile rideDB(QString("%1/%2").arg(context->athlete->home->cache().canonicalPath()).arg("rideDB.json"));
@@ -509,8 +525,12 @@ void RideCache::save(bool opendata, QString filename)
 
         stream << "\n  \"RIDES\":[\n";
 
+        // most recent first, so they're loaded first next time
+        QVector<RideItem*> ordered = rides();
+        std::reverse(ordered.begin(), ordered.end());
+
         bool firstRide = true;
-        foreach(RideItem *item, rides()) {
+        foreach(RideItem *item, ordered) {
 
             // skip if not loaded/refreshed, a special case
             // if saving during an initial refresh
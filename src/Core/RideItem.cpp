@@ -33,6 +33,7 @@
 #include "AddIntervalDialog.h" // till we fixup ridefilecache to have offsets
 #include "TimeUtils.h" // time_to_string()
 #include "WPrime.h" // for matches
+#include "EffortSearch.h"
 
 #include <cmath>
 #include <QtAlgorithms>
@@ -501,12 +502,12 @@ RideItem::checkStale()
 
             // get the new zone configuration fingerprint that applies for the ride date
             unsigned long rfingerprint = static_cast<unsigned long>(context->athlete->zones(sport)->getFingerprint(dateTime.date()))
-                        + (appsettings->cvalue(context->athlete->cyclist, context->athlete->zones(sport)->useCPforFTPSetting(), 0).toInt() ? 1 : 0)
+                        + (context->athlete->settings()->useCPforFTP(sport) ? 1 : 0)
                         + static_cast<unsigned long>(context->athlete->paceZones(isSwim)->getFingerprint(dateTime.date()))
                         + static_cast<unsigned long>(context->athlete->hrZones(sport)->getFingerprint(dateTime.date()))
                         + static_cast<unsigned long>(context->athlete->routes->getFingerprint())
                         + static_cast<unsigned long>(getHrvFingerprint())
-                        + appsettings->cvalue(context->athlete->cyclist, GC_DISCOVERY, 57).toInt(); // 57 does not include search for PEAKS
+                        + context->athlete->settings()->value(SettingsSnapshot::Discovery); // 57 does not include search for PEAKS
 
             if (fingerprint != rfingerprint) {
 
@@ -689,12 +690,12 @@ RideItem::refresh()
 
         // update fingerprints etc, crc done above
         fingerprint = static_cast<unsigned long>(context->athlete->zones(sport)->getFingerprint(dateTime.date()))
-                    + (appsettings->cvalue(context->athlete->cyclist, context->athlete->zones(sport)->useCPforFTPSetting(), 0).toInt() ? 1 : 0)
+                    + (context->athlete->settings()->useCPforFTP(sport) ? 1 : 0)
                     + static_cast<unsigned long>(context->athlete->paceZones(isSwim)->getFingerprint(dateTime.date()))
                     + static_cast<unsigned long>(context->athlete->hrZones(sport)->getFingerprint(dateTime.date()))
                     + static_cast<unsigned long>(context->athlete->routes->getFingerprint()) +
                     + static_cast<unsigned long>(getHrvFingerprint())
-                    + appsettings->cvalue(context->athlete->cyclist, GC_DISCOVERY, 57).toInt(); // 57 does not include search for PEAKS
+                    + context->athlete->settings()->value(SettingsSnapshot::Discovery); // 57 does not include search for PEAKS
 
         dbversion = DBSchemaVersion;
         udbversion = UserMetricSchemaVersion;
@@ -734,18 +735,21 @@ RideItem::getWeight(int type)
     // return what was asked for!
     if (type == Measure::WeightKg) {
         // get weight from whatever we got
-        weight = m;
+        double w = m;
 
         // from metadata
-        if (weight <= 0.00) weight = metadata_.value("Weight", "0.0").toDouble();
+        if (w <= 0.00) w = metadata_.value("Weight", "0.0").toDouble();
 
         // global options and if not set default to 75 kg.
-        if (weight <= 0.00) weight = appsettings->cvalue(context->athlete->cyclist, GC_WEIGHT, "75.0").toString().toDouble();
+        if (w <= 0.00) w = context->athlete->settings()->value(SettingsSnapshot::Weight);
 
         // No weight default is weird, we'll set to 80kg
-        if (weight <= 0.00) weight = 80.00;
+        if (w <= 0.00) w = 80.00;
 
-        return weight;
+        // only stored when it changes, metrics computed alongside each
+        // other all ask for it (see RideMetric::computeMetrics)
+        if (w != weight) weight = w;
+        return w;
     } else {
         // all the other weight measures supported by BodyMetrics
         return m;
@@ -770,9 +774,8 @@ RideItem::getHrvFingerprint()
     // get HRV measure for the date of the ride
     MeasuresGroup* pHrvMeasures = context->athlete->measures->getGroup(Measures::Hrv);
     if (pHrvMeasures) {
-        Measure hrvMeasure;
-        pHrvMeasures->getMeasure(dateTime.date(), hrvMeasure);
-        return hrvMeasure.getFingerprint();
+        const Measure *hrvMeasure = pHrvMeasures->getMeasure(dateTime.date());
+        return hrvMeasure ? hrvMeasure->getFingerprint() : Measure().getFingerprint();
     } else {
         return 0;
     }
@@ -897,7 +900,7 @@ void
 RideItem::updateIntervals()
 {
     // what do we need ?
-    int discovery = appsettings->cvalue(context->athlete->cyclist, GC_DISCOVERY, 57).toInt(); // 57 does not include search for PEAKS
+    int discovery = context->athlete->settings()->value(SettingsSnapshot::Discovery); // 57 does not include search for PEAKS
 
     // DO NOT USE ride() since it will call a refresh !
     RideFile *f = ride_;
@@ -1017,11 +1020,15 @@ RideItem::updateIntervals()
                                 tr("1 minute"), tr("5 minutes"), tr("10 minutes"), tr("20 minutes"), tr("30 minutes"), tr("45 minutes"),
                                 tr("1 hour") };
     
+        // go hunting for best peaks, all durations in one pass
+        QVector<double> windows;
+        for(int i=0; durations[i] != 0; i++) windows << durations[i];
+        QVector<QList<AddIntervalDialog::AddedInterval> > peaks;
+        AddIntervalDialog::findPeaks(context, true, f, Specification(), RideFile::watts, RideFile::original, windows, 1, peaks, "", "");
+
         for(int i=0; durations[i] != 0; i++) {
 
-            // go hunting for best peak
-            QList<AddIntervalDialog::AddedInterval> results;
-            AddIntervalDialog::findPeaks(context, true, f, Specification(), RideFile::watts, RideFile::original, durations[i], 1, results, "", "");
+            const QList<AddIntervalDialog::AddedInterval> &results = peaks[i];
 
             // did we get one ?
             if (results.count() > 0 && results[0].avg > 0 && results[0].stop > 0) {
@@ -1052,11 +1059,16 @@ RideItem::updateIntervals()
                                 tr("1 hour") };
 
         bool metric = appsettings->value(this, context->athlete->paceZones(f->isSwim())->paceSetting(), GlobalContext::context()->useMetricUnits).toBool();
+
+        // go hunting for best peaks, all durations in one pass
+        QVector<double> windows;
+        for(int i=0; durations[i] != 0; i++) windows << durations[i];
+        QVector<QList<AddIntervalDialog::AddedInterval> > peaks;
+        AddIntervalDialog::findPeaks(context, true, f, Specification(), RideFile::kph, RideFile::original, windows, 1, peaks, "", "");
+
         for(int i=0; durations[i] != 0; i++) {
 
-            // go hunting for best peak
-            QList<AddIntervalDialog::AddedInterval> results;
-            AddIntervalDialog::findPeaks(context, true, f, Specification(), RideFile::kph, RideFile::original, durations[i], 1, results, "", "");
+            const QList<AddIntervalDialog::AddedInterval> &results = peaks[i];
 
             // did we get one ?
             if (results.count() > 0 && results[0].avg > 0 && results[0].stop > 0) {
@@ -1169,121 +1181,31 @@ RideItem::updateIntervals()
 
         // now the data is integrated we can look at the 
         // accumulated energy for each ride
+        EffortSearch search(integrated_series, secs, CP, WPRIME, PMAX);
         for (long i=0; i<secs; i++) {
 
-            // start out at 30 minutes and drop back to
-            // 2 minutes, anything shorter and we are done
-            int t = (secs-i-1) > 3600 ? 3600 : secs-i-1;
-
-            // if we find one lets record it
-            bool found = false;
-            bool foundSprint = false;
+            // the best TTE and sprint we can find starting here
+            EffortSearch::Effort best;
             effort tte;
             effort sprint;
 
-            while (t > 120) {
-
-                // calculate the TTE for the joules in the interval
-                // starting at i seconds with duration t
-                // This takes the monod equation p(t) = W'/t + CP and
-                // solves for t, but the added complication of also
-                // accounting for the fact it is expressed in joules
-                // So take Joules = (W'/t + CP) * t and solving that
-                // for t gives t = (Joules - W') / CP
-                double tc = ((integrated_series[i+t]-integrated_series[i]) - WPRIME) / CP;
-                // NOTE FOR ABOVE: it is looking at accumulation AFTER this point
-                //                 not FROM this point, so we are looking 1s ahead of i
-                //                 which is why the interval is registered as starting
-                //                 at i+1 in the code below
-
-                // the TTE for this interval is greater or equal to
-                // the duration of the interval !
-                if (tc >= (t*0.85f)) {
-
-                    if (found == false) {
-
-                        // first one we found
-                        found = true;
-
-                        // register a candidate
-                        tte.start = i + 1; // see NOTE above
-                        tte.duration = t;
-                        tte.joules = integrated_series[i+t]-integrated_series[i];
-                        tte.quality = tc / double(t);
-                        tte.zone = zoneok ? context->athlete->zones(sport)->whichZone(zoneRange, tte.joules/tte.duration) : 1;
-
-                    } else {
-
-                        double thisquality = tc / double(t);
-
-                        // found one with a higher quality
-                        if (tte.quality < thisquality) {
-                            tte.duration = t;
-                            tte.joules = integrated_series[i+t]-integrated_series[i];
-                            tte.quality = thisquality;
-                            tte.zone = zoneok ? context->athlete->zones(sport)->whichZone(zoneRange, tte.joules/tte.duration) : 1;
-                        }
-
-                    }
-
-                    // look for smaller
-                    t--;
-
-                } else {
-                    t = tc;
-                    if (t<120)
-                        t=120;
-                }
+            bool found = search.tte(i, best);
+            if (found) {
+                tte.start = best.start;
+                tte.duration = best.duration;
+                tte.joules = best.joules;
+                tte.quality = best.quality;
+                tte.zone = zoneok ? context->athlete->zones(sport)->whichZone(zoneRange, tte.joules/tte.duration) : 1;
             }
 
-            //if (t>60)
-            //    t=60;
-
-            // Search sprint
-            while (t >= 5) {
-                // On Pmax only
-                // double tc = (integrated_series[i+t]-integrated_series[i]) / (PMAX);
-
-                // With the 3 components model
-                // t = W'/(P − CP) + W'/(CP − Pmax)
-                double p = (integrated_series[i+t]-integrated_series[i])/t;
-
-                if (p>0.5*(PMAX-CP)+CP) {
-                    double tc = WPRIME / (p-CP) + WPRIME / ( CP - PMAX);
-
-                    if (tc >= (t*0.85f)) {
-
-                        if (foundSprint == false) {
-
-                            // first one we found
-                            foundSprint = true;
-
-                            // register a candidate
-                            sprint.start = i + 1; // see NOTE above
-                            sprint.duration = t;
-                            sprint.joules = integrated_series[i+t]-integrated_series[i];
-                            sprint.quality = double(t) + (sprint.joules/sprint.duration/1000.0);
-
-                        } else {
-
-                            double thisquality = double(t) + (integrated_series[i+t]-integrated_series[i])/t/1000.0;
-
-                            // found one with a higher quality
-                            if (sprint.quality < thisquality) {
-                                sprint.duration = t;
-                                sprint.joules = integrated_series[i+t]-integrated_series[i];
-                                sprint.quality = thisquality;
-                            }
-
-                        }
-                        //qDebug() << "sprint" << i << sprint.duration << sprint.joules/sprint.duration << "W" << sprint.quality;
-                    }
-                }
-                // look for smaller
-                t--;
+            bool foundSprint = search.sprint(i, best);
+            if (foundSprint) {
+                sprint.start = best.start;
+                sprint.duration = best.duration;
+                sprint.joules = best.joules;
+                sprint.quality = best.quality;
             }
 
-
             // add the best one we found here
             if (found && tte.zone >= 0) {
 
@@ -1406,23 +1328,29 @@ RideItem::updateIntervals()
         RideFilePoint *pstart = f->dataPoints().at(0);
         RideFilePoint *pstop = f->dataPoints().at(0);
 
-        foreach(RideFilePoint *p, f->dataPoints()) {
+        // and where they are, rather than looking them up for each candidate
+        int istart = 0, istop = 0;
+
+        const int points = f->dataPoints().count();
+        for (int n=0; n<points; n++) {
+            RideFilePoint *p = f->dataPoints().at(n);
+
             // new min altitude
             if (pstart->alt > p->alt) {
                 //update start
-                pstart = p;
+                pstart = p; istart = n;
                 // update stop
-                pstop = p;
+                pstop = p; istop = n;
             }
             // Update max altitude
             if (pstop->alt < p->alt) {
                 // update stop
-                pstop = p;
+                pstop = p; istop = n;
             }
 
             bool downhill = (pstop->alt > p->alt+0.2*(pstop->alt-pstart->alt));
             bool flat = (!downhill && (p->km - pstop->km)>1/3.0*(p->km - pstart->km));
-            bool end = (p == f->dataPoints().last() );
+            bool end = (n == points-1);
 
 
 
@@ -1434,8 +1362,8 @@ RideItem::updateIntervals()
                     // Candidat
 
                     // Check groundrise at end
-                    int start = f->dataPoints().indexOf(pstart);
-                    int stop = f->dataPoints().indexOf(pstop);
+                    int start = istart;
+                    int stop = istop;
 
                     for (int i=stop;i>start;i--) {
                         RideFilePoint *p2 = f->dataPoints().at(i);
@@ -1443,7 +1371,7 @@ RideItem::updateIntervals()
                         if (distance2>0.1) {
                             if ((pstop->alt-p2->alt)/distance2<20.0) {
                                 //qDebug() << "        correct stop " << (pstop->alt-p2->alt)/distance2;
-                                pstop = p2;
+                                pstop = p2; istop = i;
                             } else
                                 i = start;
                         }
@@ -1455,7 +1383,7 @@ RideItem::updateIntervals()
                         if (distance2>0.1) {
                             if ((p2->alt-pstart->alt)/distance2<20.0) {
                                 //qDebug() << "        correct start " << (p2->alt-pstart->alt)/distance2;
-                                pstart = p2;
+                                pstart = p2; istart = i;
                             } else
                                 i = stop;
                         }
@@ -1489,7 +1417,7 @@ RideItem::updateIntervals()
                     }
                 }
 
-                pstart = pstop;
+                pstart = pstop; istart = istop;
             }
         }
         //qDebug() << "STOP" << QDateTime::currentDateTime().toString() + "\r\n";
@@ -32,6 +32,9 @@
 #include <QXmlSimpleReader>
 #include <QDebug>
 
+#include <algorithm>
+#include <cmath>
+
 Q_DECLARE_LOGGING_CATEGORY(gcRoutes)
 Q_LOGGING_CATEGORY(gcRoutes, "gc.routes")
 
@@ -128,10 +131,14 @@ RouteSegment::addPoint(RoutePoint _point)
 }
 
 void 
-RouteSegment::search(RideItem *item, RideFile*ride, QList<IntervalItem*>&here)
+RouteSegment::search(RideItem *item, RideFile*ride, const RouteIndex &index, QList<IntervalItem*>&here)
 {
     qCDebug(gcRoutes) << "Opening ride: " << item->fileName << " for " << name;
 
+    // the only samples that can start the route, everything
+    // else is more than 1km from its first point
+    const QVector<int> starts = points.count() ? index.near(points.first().lat, points.first().lon, 1) : QVector<int>();
+
 
     double minimumprecision = 0.100; //100m
     double maximumprecision = 0.001; //1m , was 10m but changed to 1m for small segment.
@@ -163,6 +170,16 @@ RouteSegment::search(RideItem *item, RideFile*ride, QList<IntervalItem*>&here)
                 // Valid GPS value
                 if (start == -1) {
                     diverge = 0;
+
+                    // far away from reference point, as below, and
+                    // when nothing else is close never going to start
+                    QVector<int>::const_iterator next = std::lower_bound(starts.begin(), starts.end(), i);
+                    if (next == starts.end()) break;
+                    if (*next != i) {
+                        i += 50;
+                        continue;
+                    }
+
                     // Calculate distance to route point
                     double _dist = distance(routepoint.lat, routepoint.lon, point->lat, point->lon) ;
                     minimumdistance = _dist;
@@ -311,6 +328,64 @@ RouteSegment::distance(double lat1, double lon1, double lat2, double lon2) {
 }
 
 
+/*
+ * RouteIndex
+ *
+ */
+
+// 0.01 degree cells, about 1.1km north to south
+static const double cellsPerDegree = 100;
+static const int lonCells = 360 * cellsPerDegree;
+
+static qint64 cellKey(int latCell, int lonCell)
+{
+    // wrap around at 180 degrees
+    lonCell %= lonCells;
+    if (lonCell < 0) lonCell += lonCells;
+    return qint64(latCell) * lonCells + lonCell;
+}
+
+RouteIndex::RouteIndex(RideFile *ride)
+{
+    for (int i=0; i<ride->dataPoints().count(); i++) {
+        RideFilePoint *point = ride->dataPoints().at(i);
+
+        // same check for valid GPS as RouteSegment::search
+        if (point->lat != 0 && point->lon !=0 &&
+            ceil(point->lat) != 180 && ceil(point->lon) != 180 &&
+            ceil(point->lat) != 540 && ceil(point->lon) != 540) {
+
+            cells[cellKey(floor(point->lat * cellsPerDegree), floor(point->lon * cellsPerDegree))] << i;
+            all << i;
+        }
+    }
+}
+
+QVector<int>
+RouteIndex::near(double lat, double lon, double km) const
+{
+    // a degree of latitude is 111.2km on the sphere RouteSegment::distance
+    // uses, a degree of longitude that times the cosine of the latitude
+    // at most, both rounded down so as to never miss a sample
+    double dlat = km / 111.0;
+    double maxlat = (fabs(lat) + dlat) * pi / 180;
+    if (maxlat >= pi / 2.1) return all; // near the poles, anywhere could be
+    double dlon = km / (100.0 * cos(maxlat));
+
+    int lat0 = floor((lat - dlat) * cellsPerDegree), lat1 = floor((lat + dlat) * cellsPerDegree);
+    int lon0 = floor((lon - dlon) * cellsPerDegree), lon1 = floor((lon + dlon) * cellsPerDegree);
+    if (lon1 - lon0 >= lonCells) return all;
+
+    QVector<int> returning;
+    for (int y=lat0; y<=lat1; y++) {
+        for (int x=lon0; x<=lon1; x++) {
+            QHash<qint64, QVector<int> >::const_iterator cell = cells.find(cellKey(y, x));
+            if (cell != cells.end()) returning += cell.value();
+        }
+    }
+    std::sort(returning.begin(), returning.end());
+    return returning;
+}
 
 /*
  * Routes (list of RouteSegment)
@@ -414,18 +489,29 @@ Routes::search(RideItem *item, RideFile*ride, QList<IntervalItem*>&here)
 {
     if (ride) {
 
+        const double minLat = ride->getMinPoint(RideFile::lat).toDouble();
+        const double maxLat = ride->getMaxPoint(RideFile::lat).toDouble();
+        const double minLon = ride->getMinPoint(RideFile::lon).toDouble();
+        const double maxLon = ride->getMaxPoint(RideFile::lon).toDouble();
+
+        // built the first time a segment might be in the ride
+        RouteIndex *index = NULL;
+
         // search all segments
         for (int routecount=0;routecount<routes.count();routecount++) {
             RouteSegment *segment = &routes[routecount];
 
             // The third decimal place is worth up to 110 m
-            if (ride->getMinPoint(RideFile::lat).toDouble()<segment->getMinLat()+0.001 &&
-                ride->getMaxPoint(RideFile::lat).toDouble()>segment->getMaxLat()-0.001 &&
-                ride->getMinPoint(RideFile::lon).toDouble()<segment->getMinLon()+0.001 &&
-                ride->getMaxPoint(RideFile::lon).toDouble()>segment->getMaxLon()-0.001   )
+            if (minLat<segment->getMinLat()+0.001 &&
+                maxLat>segment->getMaxLat()-0.001 &&
+                minLon<segment->getMinLon()+0.001 &&
+                maxLon>segment->getMaxLon()-0.001   ) {
 
-            segment->search(item, ride, here);
+                if (index == NULL) index = new RouteIndex(ride);
+                segment->search(item, ride, *index, here);
+            }
         }
+        delete index;
     }
 }
 
@@ -25,11 +25,14 @@
 #include <QString>
 #include <QDate>
 #include <QFile>
+#include <QHash>
+#include <QVector>
 
 #include "Context.h"
 
 class  RideFile;
 class  Routes;
+class  RouteIndex;
 struct RoutePoint;
 
 class RouteSegment // represents a segment we match against
@@ -60,7 +63,7 @@ class RouteSegment // represents a segment we match against
         double distance(double lat1, double lon1, double lat2, double lon2);
 
         // find segments in ridefiles
-        void search(RideItem *, RideFile*, QList<IntervalItem*>&);
+        void search(RideItem *, RideFile*, const RouteIndex &, QList<IntervalItem*>&);
 
     private:
 
@@ -82,6 +85,22 @@ struct RoutePoint // represents a point within a segment
     double lon, lat;
 };
 
+class RouteIndex // grid of a ride's GPS samples, built once for all the segments
+{
+    public:
+
+        RouteIndex(RideFile *ride);
+
+        // the samples that may be within km of a point, in ride order,
+        // any sample with valid GPS that isn't is further away
+        QVector<int> near(double lat, double lon, double km) const;
+
+    private:
+
+        QHash<qint64, QVector<int> > cells; // samples in each 0.01 degree cell
+        QVector<int> all;                   // every sample with valid GPS
+};
+
 
 class Routes : public QObject { // top-level object with API and map of segments/rides
 
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2026 The GoldenCheetah Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "SeriesAlignment.h"
+
+#include <cmath>
+#include <complex>
+#include <algorithm>
+#include <limits>
+
+// how many of the best offsets from the FFT are checked directly
+static const int CHECKED = 8;
+
+typedef std::complex<double> complex;
+
+// in place radix 2 FFT, size a power of 2
+static void
+fft(QVector<complex> &a, bool inverse)
+{
+    const int n = a.count();
+    complex *x = a.data();
+
+    // bit reversed order
+    for (int i=1, j=0; i<n; i++) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(x[i], x[j]);
+    }
+
+    for (int len=2; len<=n; len <<= 1) {
+        double angle = 2 * M_PI / len * (inverse ? 1 : -1);
+        complex w(cos(angle), sin(angle));
+        for (int i=0; i<n; i+=len) {
+            complex wn(1);
+            for (int k=0; k<len/2; k++) {
+                complex u = x[i+k], v = x[i+k+len/2] * wn;
+                x[i+k] = u + v;
+                x[i+k+len/2] = u - v;
+                wn *= w;
+            }
+        }
+    }
+    if (inverse) for (int i=0; i<n; i++) x[i] /= n;
+}
+
+double
+SeriesAlignment::direct(const QVector<double> &base, const QVector<double> &fit, int offset)
+{
+    // as MergeActivityWizard has always worked it out, the mean
+    // is over the rest of the base and the first sample is skipped
+    double SStot=0.0f, SSres=0.0f;
+    double mean =0.0f;
+    int count=0;
+
+    for(int i=0; (i+offset)<base.count(); i++) {
+        if ((i+offset)>0) {
+            mean += base[i+offset];
+        }
+        count++;
+    }
+    mean /= double(count);
+
+    for(int i=0; (i+offset)<base.count() && i<fit.count(); i++) {
+        if((i+offset)>0) {
+            SSres += pow(base[i+offset] - fit[i], 2);
+            SStot += pow(base[i+offset] - mean, 2);
+        }
+    }
+
+    return 1.0f - (SSres/SStot);
+}
+
+int
+SeriesAlignment::add(const QVector<double> &base, const QVector<double> &fit)
+{
+    const int nb = base.count(), nf = fit.count();
+    const double NaN = std::numeric_limits<double>::quiet_NaN();
+
+    // centred on the mean of the base so the sums of squares
+    // below don't lose the fit to rounding, the residuals
+    // don't change and the spread is corrected for it
+    double c = 0;
+    foreach(double v, base) c += v;
+    if (nb) c /= nb;
+
+    // running totals, of the base from its second sample as it is skipped
+    QVector<double> b1(nb+1, 0), b2(nb+1, 0), f2(nf+1, 0);
+    for (int j=0; j<nb; j++) {
+        double v = j ? base[j] - c : 0;
+        b1[j+1] = b1[j] + v;
+        b2[j+1] = b2[j] + v*v;
+    }
+    for (int i=0; i<nf; i++) f2[i+1] = f2[i] + (fit[i]-c) * (fit[i]-c);
+
+    // the cross-correlation of base at i+offset against fit at i for
+    // every offset, with room for the negative ones to wrap around
+    int n = 1;
+    while (n < nb + nf) n <<= 1;
+    QVector<complex> B(n), F(n);
+    for (int j=1; j<nb; j++) B[j] = base[j] - c;
+    for (int i=0; i<nf; i++) F[i] = fit[i] - c;
+    fft(B, false);
+    fft(F, false);
+    for (int k=0; k<n; k++) B[k] *= std::conj(F[k]);
+    fft(B, true);
+
+    QVector<double> fits(2*range, NaN);
+    for (int offset=-range; offset<range; offset++) {
+
+        // base samples j=i+offset that overlap the fit, skipping the first
+        int from = std::max(offset, 1), to = std::min(nb, nf+offset);
+        if (to <= from) continue;
+
+        // the mean is over the rest of the base and divided by a count
+        // that includes fit samples before it starts, see direct()
+        int count = nb - offset;
+        double mean = (b1[nb] - b1[from] - c * (from - offset)) / count;
+
+        double S1 = b1[to] - b1[from];
+        double S2 = b2[to] - b2[from];
+        double cross = B[offset < 0 ? n + offset : offset].real();
+
+        double SSres = S2 + (f2[to-offset] - f2[from-offset]) - 2 * cross;
+        double SStot = S2 - 2 * mean * S1 + (to - from) * mean * mean;
+
+        // a flat base fits nothing, direct() divides by zero
+        if (SStot <= S2 * 1e-12) continue;
+        fits[offset+range] = 1.0 - SSres / SStot;
+    }
+
+    // check the best few directly, ties go to the earliest
+    // offset and only a fit better than 0 is any good
+    QVector<int> order;
+    for (int k=0; k<fits.count(); k++) if (!std::isnan(fits[k])) order << k;
+    int checked = std::min(CHECKED, order.count());
+    std::partial_sort(order.begin(), order.begin() + checked, order.end(),
+                      [&fits](int a, int b) { return fits[a] > fits[b] || (fits[a] == fits[b] && a < b); });
+
+    double bestR2 = 0.0f;
+    int bestOffset = 0;
+    for (int k=0; k<checked; k++) {
+        int offset = order[k] - range;
+        double R2 = direct(base, fit, offset);
+        fits[order[k]] = R2;
+        if (R2 > bestR2 || (R2 == bestR2 && R2 > 0 && offset < bestOffset)) {
+            bestR2 = R2;
+            bestOffset = offset;
+        }
+    }
+
+    fits_ << fits;
+    best << bestR2;
+    at << bestOffset;
+    return fits_.count() - 1;
+}
+
+QVector<double>
+SeriesAlignment::joint() const
+{
+    const double NaN = std::numeric_limits<double>::quiet_NaN();
+
+    QVector<double> returning(2*range, 0);
+    if (fits_.isEmpty()) return returning;
+
+    // a fit worse than none is no fit, rather than a large negative
+    // dragging the others down, and series that don't overlap at an
+    // offset have no say in it at all
+    QVector<int> counts(2*range, 0);
+    foreach(const QVector<double> &fits, fits_) {
+        for (int k=0; k<returning.count(); k++) {
+            if (std::isnan(fits[k])) continue;
+            returning[k] += std::min(1.0, std::max(0.0, fits[k]));
+            counts[k]++;
+        }
+    }
+    for (int k=0; k<returning.count(); k++) returning[k] = counts[k] ? returning[k] / counts[k] : NaN;
+    return returning;
+}
+
+double
+SeriesAlignment::confidence(int offset, int apart) const
+{
+    QVector<double> fits = joint();
+    if (offset < -range || offset >= range || std::isnan(fits[offset+range])) return 0;
+
+    // the best fit anywhere else, or nothing to beat
+    double other = 0;
+    for (int k=0; k<fits.count(); k++)
+        if (abs(k-range-offset) > apart && fits[k] > other) other = fits[k];
+
+    return std::max(0.0, fits[offset+range] - other);
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2026 The GoldenCheetah Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_SeriesAlignment_h
+#define _GC_SeriesAlignment_h 1
+
+#include <QVector>
+
+//
+// Find the offset that best aligns two recordings of the same series,
+// as used when merging rides on a shared series.
+//
+// The R2 fit of the base at sample i+offset against the fit at sample i
+// is found for every offset from -range to range-1. Summing the squares
+// for each offset is quadratic in the length of the ride, but the
+// residuals are the sums of squares of each series, which come from
+// running totals, less twice their cross-correlation, and that comes
+// from an FFT for all the offsets at once. The best few offsets are
+// then worked out again directly so the rounding of the FFT can't
+// change which is chosen.
+//
+// Several series can be added, the fit of each is found separately and
+// their average is used to say how clearly an offset stands out.
+//
+class SeriesAlignment
+{
+    public:
+
+        SeriesAlignment(int range) : range(range) {}
+
+        // a series recorded in both, returns its index
+        int add(const QVector<double> &base, const QVector<double> &fit);
+        int count() const { return fits_.count(); }
+
+        // best R2 fit for a series and the offset it is at, 0 at 0 when no fit is better than 0
+        double fit(int series) const { return best[series]; }
+        int offset(int series) const { return at[series]; }
+
+        // R2 fit at each offset from -range, for one series and averaged over all of
+        // them, each clamped to 0..1 and NaN where none of them overlap at the offset
+        const QVector<double> &fits(int series) const { return fits_[series]; }
+        QVector<double> joint() const;
+
+        // how far the average fit at offset is above the best
+        // fit at any offset more than apart samples from it
+        double confidence(int offset, int apart = 60) const;
+
+        // the R2 fit at one offset, a sample at a time
+        static double direct(const QVector<double> &base, const QVector<double> &fit, int offset);
+
+    private:
+
+        int range;
+        QVector<QVector<double> > fits_;
+        QVector<double> best;
+        QVector<int> at;
+};
+
+#endif // _GC_SeriesAlignment_h
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2026 The GoldenCheetah Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "SettingsSnapshot.h"
+
+#include "Athlete.h"
+#include "Settings.h"
+#include "Zones.h"
+
+SettingsSnapshot::SettingsSnapshot(const Athlete *athlete)
+{
+    const QString &name = athlete->cyclist;
+
+    ints[Discovery] = appsettings->cvalue(name, GC_DISCOVERY, 57).toInt(); // 57 does not include search for PEAKS
+    ints[WbalTau] = appsettings->cvalue(name, GC_WBALTAU, 300).toInt();
+    ints[WbalIntegral] = appsettings->value(NULL, GC_WBALFORM, "int").toString() == "int" ? 1 : 0;
+    ints[Sex] = appsettings->cvalue(name, GC_SEX).toInt();
+    ints[YearOfBirth] = appsettings->cvalue(name, GC_DOB).toDate().year();
+
+    doubles[Weight] = appsettings->cvalue(name, GC_WEIGHT, "75.0").toString().toDouble();
+    doubles[Height] = appsettings->cvalue(name, GC_HEIGHT, 0.0f).toString().toDouble();
+    doubles[ElevationHysteresis] = appsettings->value(NULL, GC_ELEVATION_HYSTERESIS).toDouble();
+
+    QHashIterator<QString, Zones*> i(athlete->zones_);
+    while (i.hasNext()) {
+        i.next();
+        useCPforFTP_.insert(i.key(), appsettings->cvalue(name, i.value()->useCPforFTPSetting(), 0).toInt() ? true : false);
+    }
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2026 The GoldenCheetah Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_SettingsSnapshot_h
+#define _GC_SettingsSnapshot_h 1
+
+#include <QHash>
+#include <QString>
+
+class Athlete;
+
+//
+// A typed, read-only copy of the settings that are read in hot loops
+// (staleness checks, metric computation, interval discovery) where
+// going through appsettings->cvalue() for every ride is expensive.
+//
+// A new snapshot is taken by the Athlete whenever the config changes
+// and published with an atomic pointer swap, so readers on any thread
+// just call context->athlete->settings() and never lock. Snapshots are
+// never changed once published and live until the athlete is closed.
+//
+class SettingsSnapshot
+{
+    public:
+
+        enum IntKey {
+            Discovery,          // GC_DISCOVERY, intervals to discover
+            WbalTau,            // GC_WBALTAU
+            WbalIntegral,       // GC_WBALFORM == "int"
+            Sex,                // GC_SEX, 0 = male
+            YearOfBirth,        // GC_DOB
+            IntKeys
+        };
+
+        enum DoubleKey {
+            Weight,             // GC_WEIGHT, kg
+            Height,             // GC_HEIGHT, m
+            ElevationHysteresis,// GC_ELEVATION_HYSTERESIS
+            DoubleKeys
+        };
+
+        // read them all in for the athlete
+        SettingsSnapshot(const Athlete *athlete);
+
+        int value(IntKey key) const { return ints[key]; }
+        double value(DoubleKey key) const { return doubles[key]; }
+
+        // GC_USE_CP_FOR_FTP is held per sport
+        bool useCPforFTP(const QString &sport) const { return useCPforFTP_.value(sport, useCPforFTP_.value("Bike", false)); }
+
+    private:
+
+        int ints[IntKeys];
+        double doubles[DoubleKeys];
+        QHash<QString, bool> useCPforFTP_;
+};
+
+#endif // _GC_SettingsSnapshot_h
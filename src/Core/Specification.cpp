@@ -39,6 +39,13 @@ Specification::pass(RideItem*item) const
     return (dr.pass(item->dateTime.date()) && fs.pass(item->fileName));
 }
 
+QString
+Specification::fingerprint() const
+{
+    // only what selects rides, the interval and ride item are per ride
+    return QString("%1:%2:%3").arg(dr.from.toJulianDay()).arg(dr.to.toJulianDay()).arg(fs.fingerprint());
+}
+
 bool
 Specification::pass(RideFilePoint *p) const
 {
@@ -72,6 +72,13 @@ class FilterSet
         }
 
         int count() { return filters_.count(); }
+
+        // the same for the same filters, whatever order the names are in
+        uint fingerprint() const {
+            uint returning = filters_.count();
+            foreach(const QSet<QString> &set, filters_) returning = (returning * 31) + qHash(set);
+            return returning;
+        }
 };
 
 class RideFileIterator;
@@ -110,6 +117,9 @@ class Specification
         FilterSet filterSet() { return fs; }
         bool isFiltered() { return (fs.count() > 0); }
 
+        // the same for specifications that select the same rides
+        QString fingerprint() const;
+
         // just start/stop and item for now
         // when working with samples
         void print();
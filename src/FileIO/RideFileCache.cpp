@@ -321,10 +321,8 @@ QVector<float> RideFileCache::meanMaxPowerFor(Context *context, QVector<float> &
     QVector<float> returningwpk;
     bool first = true;
 
-    // look at all the rides
-    foreach (RideItem *item, context->athlete->rideCache->rides()) {
-
-        if (item->dateTime.date() < from || item->dateTime.date() > to) continue; // not one we want
+    // look at the rides in the date range
+    foreach (RideItem *item, context->athlete->rideCache->ridesInRange(from, to)) {
 
         if (item->sport != sport) continue; // they don't want these
 
@@ -1794,12 +1792,11 @@ RideFileCache::RideFileCache(Context *context, QDate start, QDate end, bool filt
 
     // Iterate over the ride files (not the cpx files since they /might/ not
     // exist, or /might/ be out of date.
-    foreach (RideItem *item, context->athlete->rideCache->rides()) {
+    foreach (RideItem *item, context->athlete->rideCache->ridesInRange(start, end)) {
 
         QDate rideDate = item->dateTime.date();
 
-        if (((filter == true && files.contains(item->fileName)) || filter == false) &&
-            rideDate >= start && rideDate <= end) {
+        if ((filter == true && files.contains(item->fileName)) || filter == false) {
 
             // skip globally filtered values
             if (context->isfiltered && !context->filters.contains(item->fileName)) continue;
@@ -1889,12 +1886,9 @@ QVector<float> &RideFileCache::heatMeanMaxArray()
 
     // ok, we need to iterate again and compute heat based upon
     // how close to the absolute best we've got
-    foreach(RideItem *item, context->athlete->rideCache->rides()) {
-
-        QDate rideDate = item->dateTime.date();
+    foreach(RideItem *item, context->athlete->rideCache->ridesInRange(start, end)) {
 
-        if (((filter == true && files.contains(item->fileName)) || filter == false) &&
-            rideDate >= start && rideDate <= end) {
+        if ((filter == true && files.contains(item->fileName)) || filter == false) {
 
             // skip globally filtered values
             if (context->isfiltered && !context->filters.contains(item->fileName)) continue;
@@ -29,6 +29,7 @@
 #include "HelpWhatsThis.h"
 #include <QMap>
 #include <cmath>
+#include <algorithm>
 
 // helper function
 static void clearResultsTable(QTableWidget *);
@@ -493,6 +494,14 @@ struct CompareBests {
     }
 };
 
+struct WorseBests {
+    // The reverse, so the best is at the top of a heap.
+    bool operator()(const AddIntervalDialog::AddedInterval &a,
+                    const AddIntervalDialog::AddedInterval &b) const {
+        return CompareBests()(b, a);
+    }
+};
+
 void
 AddIntervalDialog::createClicked()
 {
@@ -830,17 +839,12 @@ AddIntervalDialog::findPeakPowerStandard(Context *context, const RideFile *ride,
 {
     QString prefix = tr("Peak");
 
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 5, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 10, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 20, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 30, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 60, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 120, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 300, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 600, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 1200, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 1800, 1, results, prefix, "");
-    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, 3600, 1, results, prefix, "");
+    QVector<double> windowSizes;
+    windowSizes << 5 << 10 << 20 << 30 << 60 << 120 << 300 << 600 << 1200 << 1800 << 3600;
+
+    QVector<QList<AddedInterval> > peaks;
+    findPeaks(context, true, ride, Specification(), RideFile::watts, RideFile::original, windowSizes, 1, peaks, prefix, "");
+    foreach(const QList<AddedInterval> &peak, peaks) results.append(peak);
 }
 
 void
@@ -848,47 +852,90 @@ AddIntervalDialog::findPeaks(Context *context, bool typeTime, const RideFile *ri
                              RideFile::SeriesType series, RideFile::Conversion conversion, double windowSize,
                               int maxIntervals, QList<AddedInterval> &results, QString prefixe, QString overideName)
 {
-    QList<AddedInterval> bests;
-    QList<AddedInterval> _results;
+    QVector<QList<AddedInterval> > peaks;
+    findPeaks(context, typeTime, ride, spec, series, conversion, QVector<double>() << windowSize, maxIntervals, peaks, prefixe, overideName);
+    results.append(peaks[0]);
+}
+
+void
+AddIntervalDialog::findPeaks(Context *context, bool typeTime, const RideFile *ride, Specification spec,
+                             RideFile::SeriesType series, RideFile::Conversion conversion, const QVector<double> &windowSizes,
+                             int maxIntervals, QVector<QList<AddedInterval> > &results, QString prefixe, QString overideName)
+{
+    const int n = windowSizes.count();
+    results.resize(n);
+    if (ride->dataPoints().isEmpty()) return;
 
     double secsDelta = ride->recIntSecs();
-    double total = 0.0;
-    QList<const RideFilePoint*> window;
+
+    // a window for each size, as the first point in it and its total
+    QVector<QList<AddedInterval> > bests(n);
+    QVector<int> first(n, 0);
+    QVector<double> total(n, 0.0);
+    QVector<bool> fits(n);
 
     // ride is shorter than the window size!
-    if (typeTime && windowSize > ride->dataPoints().last()->secs + secsDelta) return;
-    if (!typeTime && windowSize > ride->dataPoints().last()->km*1000) return;
+    for (int k=0; k<n; k++) {
+        fits[k] = (typeTime && windowSizes[k] <= ride->dataPoints().last()->secs + secsDelta) ||
+                  (!typeTime && windowSizes[k] <= ride->dataPoints().last()->km*1000);
+    }
+
+    // the points and their values, read once for all the windows
+    QVector<const RideFilePoint*> points;
+    QVector<double> values;
 
     // We're looking for intervals with durations in [windowSizeSecs, windowSizeSecs + secsDelta).
     RideFileIterator it(const_cast<RideFile*>(ride), spec);
     while (it.hasNext()) {
         struct RideFilePoint *point = it.next();
+        const int i = points.count();
+        points << point;
+        values << point->value(series);
 
-        // Discard points until interval duration is < windowSizeSecs + secsDelta.
-        while ((typeTime && !window.empty() && intervalDuration(window.first(), point, ride) >= windowSize + secsDelta) ||
-               (!typeTime && window.length()>1 && intervalDistance(window.at(1), point, ride) >= windowSize)) {
-            total -= window.first()->value(series);
-            window.takeFirst();
-        }
-        // Add points until interval duration or distance is >= windowSize.
-        total += point->value(series);
-        window.append(point);
-        double duration = intervalDuration(window.first(), window.last(), ride);
-        double distance = intervalDistance(window.first(), window.last(), ride);
+        for (int k=0; k<n; k++) {
 
-        if ((typeTime && duration >= windowSize) ||
-            (!typeTime && distance >= windowSize)) {
-            double start = window.first()->secs;
-            double stop = window.last()->secs; //start + duration;
-            double avg = total * secsDelta / duration;
-            bests.append(AddedInterval(start, stop, avg));
+            if (!fits[k]) continue;
+            const double windowSize = windowSizes[k];
+
+            // Discard points until interval duration is < windowSizeSecs + secsDelta.
+            while ((typeTime && first[k] < i && intervalDuration(points[first[k]], point, ride) >= windowSize + secsDelta) ||
+                   (!typeTime && i - first[k] > 1 && intervalDistance(points[first[k]+1], point, ride) >= windowSize)) {
+                total[k] -= values[first[k]];
+                first[k]++;
+            }
+            // Add points until interval duration or distance is >= windowSize.
+            total[k] += values[i];
+            double duration = intervalDuration(points[first[k]], point, ride);
+            double distance = intervalDistance(points[first[k]], point, ride);
+
+            if ((typeTime && duration >= windowSize) ||
+                (!typeTime && distance >= windowSize)) {
+                double start = points[first[k]]->secs;
+                double stop = point->secs; //start + duration;
+                double avg = total[k] * secsDelta / duration;
+                bests[k].append(AddedInterval(start, stop, avg));
+            }
         }
     }
 
-    std::sort(bests.begin(), bests.end(), CompareBests());
+    for (int k=0; k<n; k++) {
+        findBests(context, typeTime, ride, series, conversion, windowSizes[k], maxIntervals, bests[k], results[k], prefixe, overideName);
+    }
+}
+
+void
+AddIntervalDialog::findBests(Context *context, bool typeTime, const RideFile *ride,
+                             RideFile::SeriesType series, RideFile::Conversion conversion, double windowSize,
+                             int maxIntervals, QList<AddedInterval> &bests, QList<AddedInterval> &_results,
+                             QString prefixe, QString overideName)
+{
+    // the best first, only taking as many off the heap as it takes to
+    // find maxIntervals that don't overlap rather than sorting them all
+    std::make_heap(bests.begin(), bests.end(), WorseBests());
 
     while (!bests.empty() && (_results.size() < maxIntervals)) {
-        AddedInterval candidate = bests.takeFirst();
+        std::pop_heap(bests.begin(), bests.end(), WorseBests());
+        AddedInterval candidate = bests.takeLast();
         bool overlaps = false;
         foreach (const AddedInterval &existing, _results) {
             if (intervalsOverlap(candidate, existing)) {
@@ -966,7 +1013,6 @@ AddIntervalDialog::findPeaks(Context *context, bool typeTime, const RideFile *ri
             _results.append(candidate);
         }
     }
-    results.append(_results);
 }
 
 void
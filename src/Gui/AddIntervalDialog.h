@@ -56,6 +56,11 @@ class AddIntervalDialog : public QDialog
                               RideFile::Conversion conversion, double windowSizeSecs,
                               int maxIntervals, QList<AddedInterval> &results, QString prefixe, QString overideName);
 
+        // as above for several window sizes in one pass over the ride, a list of results for each
+        static void findPeaks(Context *context, bool typeTime, const RideFile *ride, Specification spec, RideFile::SeriesType series,
+                              RideFile::Conversion conversion, const QVector<double> &windowSizes,
+                              int maxIntervals, QVector<QList<AddedInterval> > &results, QString prefixe, QString overideName);
+
         static void findFirsts(bool typeTime, const RideFile *ride, double windowSizeSecs,
                                int maxIntervals, QList<AddedInterval> &results);
 
@@ -78,6 +83,11 @@ class AddIntervalDialog : public QDialog
 
     private:
 
+        // the best maxIntervals of the windows found that don't overlap, named
+        static void findBests(Context *context, bool typeTime, const RideFile *ride, RideFile::SeriesType series,
+                              RideFile::Conversion conversion, double windowSize, int maxIntervals,
+                              QList<AddedInterval> &bests, QList<AddedInterval> &results, QString prefixe, QString overideName);
+
         Context *context;
         QWidget *intervalMethodWidget, *intervalPeakPowerWidget, *intervalTypeWidget, 
                 *intervalTimeWidget, *intervalDistanceWidget, *intervalClimbWidget,
@@ -25,6 +25,7 @@
 #include "AthleteTab.h"
 #include "RideNavigator.h"
 #include "DataFilter.h"
+#include "DataFilterProfile.h"
 #include "Zones.h"
 #include "HrZones.h"
 #include "RideMetric.h"
@@ -34,6 +35,9 @@
 #include <QFont>
 #include <QFontMetrics>
 #include <QMessageBox>
+#include <QPlainTextEdit>
+#include <QFontDatabase>
+#include <QFileDialog>
 
 // although we edit global user metrics we do so in the current
 // context, using the current ride as a basis for the computation
@@ -129,6 +133,7 @@ EditUserMetricDialog::EditUserMetricDialog(QWidget *parent, Context *context, Us
     okButton = new QPushButton(tr("OK"));
     cancelButton = new QPushButton(tr("Cancel"));
     test = new QPushButton(tr("Test"));
+    profile = new QPushButton(tr("Profile"));
 
     QGridLayout *head = new QGridLayout;
 
@@ -175,6 +180,7 @@ EditUserMetricDialog::EditUserMetricDialog(QWidget *parent, Context *context, Us
     head->addWidget(test, 16, 0);
     head->addWidget(metric, 16, 1);
     head->addWidget(imperial, 16, 2);
+    head->addWidget(profile, 16, 4);
 
     // 18th row; eval values and pushbuttons
     head->addWidget(eval, 17,0);
@@ -196,6 +202,7 @@ EditUserMetricDialog::EditUserMetricDialog(QWidget *parent, Context *context, Us
     connect(name, SIGNAL(textChanged(const QString &)), SLOT(enableOk()));
 
     connect(test, SIGNAL(clicked()), this, SLOT(refreshStats()));
+    connect(profile, SIGNAL(clicked()), this, SLOT(profileProgram()));
     connect(context, SIGNAL(rideSelected(RideItem*)), this, SLOT(refreshStats()));
     connect (cancelButton, SIGNAL(clicked()), this, SLOT(reject()));
     connect (okButton, SIGNAL(clicked()), this, SLOT(okClicked()));
@@ -283,3 +290,52 @@ EditUserMetricDialog::refreshStats()
     mValue->setText(test.toString(true));
     iValue->setText(test.toString(false));
 }
+
+void
+EditUserMetricDialog::profileProgram()
+{
+    // profile against currently selected ride
+    if (context->rideItem() == NULL || context->rideItem()->ride() == NULL) return;
+
+    UserMetricSettings here;
+    setSettings(here);
+    UserMetric test(context, here);
+
+    // compute as the test does, recording the calls
+    DataFilterProfile profile;
+    test.setProfile(&profile);
+    profile.enter(tr("compute"));
+    test.compute(context->rideItem(), Specification(), QHash<QString,RideMetric*>());
+    profile.leave();
+    test.setProfile(NULL);
+
+    mValue->setText(test.toString(true));
+    iValue->setText(test.toString(false));
+
+    QDialog dialog(this);
+    dialog.setWindowTitle(tr("Profile of %1 for %2").arg(here.symbol).arg(context->rideItem()->fileName));
+    QVBoxLayout *layout = new QVBoxLayout(&dialog);
+    QPlainTextEdit *report = new QPlainTextEdit(&dialog);
+    report->setReadOnly(true);
+    report->setLineWrapMode(QPlainTextEdit::NoWrap);
+    report->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    report->setPlainText(profile.report());
+    layout->addWidget(report);
+
+    QHBoxLayout *buttons = new QHBoxLayout;
+    QPushButton *save = new QPushButton(tr("&Save..."), &dialog);
+    QPushButton *close = new QPushButton(tr("&Close"), &dialog);
+    buttons->addWidget(save);
+    buttons->addStretch();
+    buttons->addWidget(close);
+    layout->addLayout(buttons);
+
+    connect(save, &QPushButton::clicked, &dialog, [&]() {
+        QString filename = QFileDialog::getSaveFileName(&dialog, tr("Save Profile"), QString(), tr("CSV files (*.csv)"));
+        if (filename != "" && !profile.save(filename))
+            QMessageBox::warning(&dialog, tr("Save Profile"), tr("Unable to write %1").arg(filename));
+    });
+    connect(close, SIGNAL(clicked()), &dialog, SLOT(accept()));
+    dialog.resize(600 * dpiXFactor, 400 * dpiXFactor);
+    dialog.exec();
+}
@@ -24,6 +24,7 @@
 #include "MainWindow.h"
 #include "HelpWhatsThis.h"
 #include "LocationInterpolation.h"
+#include "SeriesAlignment.h"
 
 // minimum R-squared fit when trying to find offsets to
 // merge ride files. Lower numbers mean happier to take
@@ -84,6 +85,7 @@ MergeActivityWizard::MergeActivityWizard(Context *context) : QWizard(context->ma
     // and merge on device clocks
     mode = 0;
     strategy = 0;
+    fitR2 = fitConfidence = 0;
 
     // 5 step process, although Conflict may be skipped
     setPage(10, new MergeWelcome(this));
@@ -124,6 +126,7 @@ MergeActivityWizard::analyse()
     // looking at the parameters determine the offset
     // default to align left if all else fails !
     offset1 = offset2 = 0;
+    fitR2 = fitConfidence = 0;
 
     switch(strategy) {
 
@@ -155,7 +158,7 @@ MergeActivityWizard::analyse()
             break;
 
     case 1: // align on shared series
-            // using a shotgun algorithm
+            // using the best R2 fit at any offset
     {
             // calculate the R2 fit using the current offset
             // for the first shared series
@@ -176,6 +179,9 @@ MergeActivityWizard::analyse()
             int offsetFit=0;
             RideFile::SeriesType bestSeries=RideFile::none;
 
+            // no more than shifting by a third of the ride backwards or forwards
+            SeriesAlignment alignment(base->dataPoints().count()/3);
+
             QMapIterator<RideFile::SeriesType, QCheckBox *> i(rightSeries);
             while(i.hasNext()) {
                 i.next();
@@ -184,39 +190,13 @@ MergeActivityWizard::analyse()
                     // for each shared series look for best fit
                     RideFile::SeriesType shared = i.key();
 
-                    double bestR2 = 0.0f;
-                    int bestOffset = 0;
-
-                    // no more than shifting by a third of the ride backwards or forwards
-                    for(int offset=-1 * (base->dataPoints().count()/3); 
-                            offset<base->dataPoints().count()/3; 
-                            offset++) {
-
-                        double SStot=0.0f, SSres=0.0f;
-                        double mean =0.0f;
-                        int count=0;
-
-                        for(int i=0; (i+offset)<base->dataPoints().count(); i++) {
-                            if ((i+offset)>0) {
-                                mean += base->dataPoints()[i+offset]->value(shared);
-                            }
-                            count++;
-                        }
-                        mean /= double(count);
-                
-                        for(int i=0; (i+offset)<base->dataPoints().count() && i<fit->dataPoints().count(); i++) {
-                            if((i+offset)>0) {
-                                SSres += pow(base->dataPoints()[i+offset]->value(shared) - fit->dataPoints()[i]->value(shared), 2);
-                                SStot += pow(base->dataPoints()[i+offset]->value(shared) - mean, 2);
-                            }
-                        }
-
-                        double R2= 1.0f - (SSres/SStot);
-                        if (R2 > bestR2) {
-                            bestR2= R2;
-                            bestOffset=offset;
-                        }
-                    }
+                    QVector<double> baseSeries, fitSeries;
+                    foreach(RideFilePoint *p, base->dataPoints()) baseSeries << p->value(shared);
+                    foreach(RideFilePoint *p, fit->dataPoints()) fitSeries << p->value(shared);
+
+                    int index = alignment.add(baseSeries, fitSeries);
+                    double bestR2 = alignment.fit(index);
+                    int bestOffset = alignment.offset(index);
 
                     // is this a better fit ?
                     if (bestR2 > bestFit) {
@@ -230,6 +210,10 @@ MergeActivityWizard::analyse()
             }
             //qDebug()<<"THEREFORE: best R2="<<bestFit<<"at best offset"<<offsetFit<<"with series"<<ride1->seriesName(bestSeries);
 
+            // how well all the shared series agree on it
+            fitR2 = bestFit;
+            fitConfidence = alignment.confidence(offsetFit);
+
             // so lets turn that into an offset for ride1 and ride2
             if (bestFit > MINIMUM_R2_FIT) {
                 if (diff <0) { // ride2 was the base
@@ -1127,6 +1111,9 @@ MergeAdjust::MergeAdjust(MergeActivityWizard *parent) : QWizardPage(parent), wiz
     layout->addWidget(fullPlot);
     layout->addStretch();
 
+    fitLabel = new QLabel("");
+    layout->addWidget(fitLabel);
+
     QLabel *adjust = new QLabel(tr("Adjust:"));
     offsetLabel = new QLabel("--");
     adjustSlider = new QSlider(Qt::Horizontal, this);
@@ -1179,6 +1166,15 @@ MergeAdjust::initializePage()
             fullPlot->setShow(j.key(), true);
     }
 
+    // how sure we are of the alignment found
+    if (wizard->strategy == 1 && wizard->fitR2 > MINIMUM_R2_FIT)
+        fitLabel->setText(QString(tr("Aligned on shared data with a fit of %1, %2 better than any other alignment"))
+                          .arg(wizard->fitR2, 0, 'f', 3).arg(wizard->fitConfidence, 0, 'f', 3));
+    else if (wizard->strategy == 1)
+        fitLabel->setText(tr("Shared data did not fit well enough to align on, aligned at the start"));
+    else
+        fitLabel->setText("");
+
     // setup adjuster 
     adjustSlider->setMinimum(-1 * wizard->combined->dataPoints().count());
     adjustSlider->setMaximum(wizard->combined->dataPoints().count());
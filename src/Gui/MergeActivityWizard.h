@@ -90,6 +90,10 @@ class MergeActivityWizard : public QWizard
         // offset from start in samples for each ride
         int offset1, offset2;
 
+        // when aligned on shared series, the best R2 fit found and
+        // how far it stands out from aligning them any other way
+        double fitR2, fitConfidence;
+
         // which series are we going to merge ?
         QMap<RideFile::SeriesType, QCheckBox *> leftSeries, rightSeries;
 
@@ -261,7 +265,7 @@ class MergeAdjust : public QWizardPage
         QxtSpanSlider *spanSlider;
 
         QSlider *adjustSlider;
-        QLabel *offsetLabel;
+        QLabel *offsetLabel, *fitLabel;
         QPushButton *reset;
 
         int offset1, offset2;
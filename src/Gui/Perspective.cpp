@@ -1711,12 +1711,17 @@ Perspective::filterlist(DateRange dr, bool isfiltered, QStringList files)
     spec.setDateRange(dr);
     spec.setFilterSet(FilterSet(isfiltered, files)); // typically chart level filter
 
+    QVector<RideItem*> rides;
     foreach(RideItem *item, context->athlete->rideCache->rides()) {
-        if (!spec.pass(item)) continue;
+        if (spec.pass(item)) rides << item;
+    }
 
-        // if no filter, or the filter passes add to count
-        if (!isFiltered() || df->evaluate(item, NULL).number() != 0)
-            returning << item->fileName;
+    // if no filter, or the filter passes add to count
+    QVector<Result> results;
+    if (isFiltered()) results = df->evaluate(rides);
+    for (int i=0; i<rides.count(); i++) {
+        if (!isFiltered() || results[i].number() != 0)
+            returning << rides[i]->fileName;
     }
 
     return returning;
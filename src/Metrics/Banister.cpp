@@ -51,7 +51,7 @@
 #include <QVector>
 #include <QMutex>
 #include <QApplication>
-#include "lmcurve.h"
+#include "lmcurve_data.h"
 
 // the mean athlete from opendata analysis
 const double typical_CP = 261,
@@ -498,10 +498,10 @@ banisterFit::combine(banisterFit other)
     }
 }
 
-// used to wrap a function call when deriving parameters
-static banisterFit *calllmfitm = NULL;
-static double calllmfitb(double t, const double *p) {
-return static_cast<banisterFit*>(calllmfitm)->f(t, p);
+// used to wrap a function call when deriving parameters, the window
+// being fitted is passed through by lmcurve_data()
+static double calllmfitb(double t, const double *p, void *window) {
+return static_cast<banisterFit*>(window)->f(t, p);
 }
 
 void Banister::setDecay(double one, double two)
@@ -526,16 +526,10 @@ void Banister::fit()
 
         printd("fitting window %d start=%s [k1=%g k2=%g p0=%g]\n", i, windows[i].startDate.toString().toStdString().c_str(), prior[0], prior[1], prior[2]);
 
-        // use forwarder via global variable, so mutex around this !
-        calllmfit.lock();
-        calllmfitm=&windows[i];
-
+        // the windows update our data as they're fitted, so one at a time
         //fprintf(stderr, "Fitting ...\n" ); fflush(stderr);
-        lmcurve(3, prior, windows[i].tests, performanceDay.constData()+windows[i].testoffset, performanceScore.constData()+windows[i].testoffset,
-                calllmfitb, &control, &status);
-
-        // release for others
-        calllmfit.unlock();
+        lmcurve_data(3, prior, windows[i].tests, performanceDay.constData()+windows[i].testoffset, performanceScore.constData()+windows[i].testoffset,
+                     calllmfitb, &windows[i], &control, &status);
 
         if (status.outcome >= 0) {
             int n=0;
@@ -350,7 +350,7 @@ class TimeCarrying : public RideMetric {
         if (item->ride()->areDataPresent()->kph) {
 
             // hysteresis can be configured, we default to 3.0
-            double hysteresis = appsettings->value(NULL, GC_ELEVATION_HYSTERESIS).toDouble();
+            double hysteresis = item->context->athlete->settings()->value(SettingsSnapshot::ElevationHysteresis);
             if (hysteresis <= 0.1) hysteresis = 3.00;
 
             RideFileIterator it(item->ride(), spec);
@@ -427,7 +427,7 @@ class ElevationGainCarrying : public RideMetric {
         }
 
         // hysteresis can be configured, we default to 3.0
-        double hysteresis = appsettings->value(NULL, GC_ELEVATION_HYSTERESIS).toDouble();
+        double hysteresis = item->context->athlete->settings()->value(SettingsSnapshot::ElevationHysteresis);
         if (hysteresis <= 0.1) hysteresis = 3.00;
 
         bool first = true;
@@ -617,7 +617,7 @@ class AthleteWeight : public RideMetric {
         if (!weight) weight = item->getText("Weight", "0.0").toDouble();
 
         // global options
-        if (!weight) weight = appsettings->cvalue(item->context->athlete->cyclist, GC_WEIGHT, "75.0").toString().toDouble(); // default to 75kg
+        if (!weight) weight = item->context->athlete->settings()->value(SettingsSnapshot::Weight); // default to 75kg
 
         // No weight default is weird, we'll set to 80kg
         if (weight <= 0.00) weight = 80.00;
@@ -862,7 +862,7 @@ class ElevationGain : public RideMetric {
         }
 
         // hysteresis can be configured, we default to 3.0
-        double hysteresis = appsettings->value(NULL, GC_ELEVATION_HYSTERESIS).toDouble();
+        double hysteresis = item->context->athlete->settings()->value(SettingsSnapshot::ElevationHysteresis);
         if (hysteresis <= 0.1) hysteresis = 3.00;
 
         bool first = true;
@@ -930,7 +930,7 @@ class ElevationLoss : public RideMetric {
         }
 
         // hysteresis can be configured, we default to 3.0
-        double hysteresis = appsettings->value(NULL, GC_ELEVATION_HYSTERESIS).toDouble();
+        double hysteresis = item->context->athlete->settings()->value(SettingsSnapshot::ElevationHysteresis);
         if (hysteresis <= 0.1) hysteresis = 3.00;
 
         bool first = true;
@@ -1079,7 +1079,7 @@ static bool avgSpeedAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-struct AvgPower : public RideMetric {
+struct AvgPower : public AccumulatingRideMetric {
     Q_DECLARE_TR_FUNCTIONS(AvgPower)
 
     double count, total;
@@ -1100,26 +1100,27 @@ struct AvgPower : public RideMetric {
         setDescription(tr("Average Power from all samples with power greater than or equal to zero"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    bool begin(RideItem *item, const Specification &) {
 
         // no ride or no samples
         if (item->ride() == NULL || !item->ride()->areDataPresent()->watts || item->ride()->dataPoints().count() == 0) {
             setValue(RideFile::NIL);
             setCount(0);
-            return;
+            return false;
         }
 
         total = count = 0;
-    
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
+        return true;
+    }
 
-            if (point->watts >= 0.0) {
-                total += point->watts;
-                ++count;
-            }
+    void accumulate(const RideFilePoint *point) {
+        if (point->watts >= 0.0) {
+            total += point->watts;
+            ++count;
         }
+    }
+
+    void finalize(RideItem *, const Specification &, const QHash<QString,RideMetric*> &) {
         setValue(count > 0 ? total / count : 0);
         setCount(count);
     }
@@ -1135,7 +1136,7 @@ static bool avgPowerAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-struct AvgSmO2 : public RideMetric {
+struct AvgSmO2 : public AccumulatingRideMetric {
     Q_DECLARE_TR_FUNCTIONS(AvgSmO2)
 
     double count, total;
@@ -1156,26 +1157,27 @@ struct AvgSmO2 : public RideMetric {
         setDescription(tr("Average Muscle Oxygen Saturation, the percentage of hemoglobin that is carrying oxygen."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    bool begin(RideItem *item, const Specification &) {
 
         // no ride or no samples
         if (item->ride() == NULL || !item->ride()->areDataPresent()->smo2 || item->ride()->dataPoints().count() == 0) {
             setValue(RideFile::NIL);
             setCount(0);
-            return;
+            return false;
         }
 
         total = count = 0;
+        return true;
+    }
 
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-
-            if (point->smo2 > 0.0f) {  // SmO2 should always be > 0.0f
-                total += point->smo2;
-                ++count;
-            }
+    void accumulate(const RideFilePoint *point) {
+        if (point->smo2 > 0.0f) {  // SmO2 should always be > 0.0f
+            total += point->smo2;
+            ++count;
         }
+    }
+
+    void finalize(RideItem *, const Specification &, const QHash<QString,RideMetric*> &) {
         setValue(count > 0 ? total / count : 0);
         setCount(count);
     }
@@ -1247,7 +1249,7 @@ static bool avgtHbAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-struct AAvgPower : public RideMetric {
+struct AAvgPower : public AccumulatingRideMetric {
     Q_DECLARE_TR_FUNCTIONS(AAvgPower)
 
     double count, total;
@@ -1268,25 +1270,27 @@ struct AAvgPower : public RideMetric {
         setDescription(tr("Average altitude power. Recorded power adjusted to take into account the effect of altitude on vo2max and thus power output."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    bool begin(RideItem *item, const Specification &spec) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
             setValue(RideFile::NIL);
             setCount(0);
-            return;
+            return false;
         }
 
         total = count = 0;
+        return true;
+    }
 
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->apower >= 0.0) {
-                total += point->apower;
-                ++count;
-            }
+    void accumulate(const RideFilePoint *point) {
+        if (point->apower >= 0.0) {
+            total += point->apower;
+            ++count;
         }
+    }
+
+    void finalize(RideItem *, const Specification &, const QHash<QString,RideMetric*> &) {
         setValue(count > 0 ? total / count : 0);
         setCount(count);
     }
@@ -1301,7 +1305,7 @@ static bool aavgPowerAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-struct NonZeroPower : public RideMetric {
+struct NonZeroPower : public AccumulatingRideMetric {
     Q_DECLARE_TR_FUNCTIONS(NonZeroPower)
 
     double count, total;
@@ -1322,25 +1326,27 @@ struct NonZeroPower : public RideMetric {
         setDescription(tr("Average Power without zero values, it gives inflated values when frequent coasting is present"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    bool begin(RideItem *item, const Specification &) {
 
         // no ride or no samples
         if (item->ride() == NULL || !item->ride()->areDataPresent()->watts || item->ride()->dataPoints().count() == 0) {
             setValue(RideFile::NIL);
             setCount(0);
-            return;
+            return false;
         }
 
         total = count = 0;
+        return true;
+    }
 
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->watts > 0.0) {
-                total += point->watts;
-                ++count;
-            }
+    void accumulate(const RideFilePoint *point) {
+        if (point->watts > 0.0) {
+            total += point->watts;
+            ++count;
         }
+    }
+
+    void finalize(RideItem *, const Specification &, const QHash<QString,RideMetric*> &) {
         setValue(count > 0 ? total / count : 0);
         setCount(count);
     }
@@ -1356,7 +1362,7 @@ static bool nonZeroPowerAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-struct AvgHeartRate : public RideMetric {
+struct AvgHeartRate : public AccumulatingRideMetric {
     Q_DECLARE_TR_FUNCTIONS(AvgHeartRate)
 
     double total, count;
@@ -1377,24 +1383,27 @@ struct AvgHeartRate : public RideMetric {
         setDescription(tr("Average Heart Rate computed for samples when hr is greater than zero"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    bool begin(RideItem *item, const Specification &) {
 
         // no ride or no samples
         if (item->ride() == NULL || !item->ride()->areDataPresent()->hr || item->ride()->dataPoints().count() == 0) {
             setValue(RideFile::NIL);
             setCount(0);
-            return;
+            return false;
         }
 
         total = count = 0;
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->hr > 0) {
-                total += point->hr;
-                ++count;
-            }
+        return true;
+    }
+
+    void accumulate(const RideFilePoint *point) {
+        if (point->hr > 0) {
+            total += point->hr;
+            ++count;
         }
+    }
+
+    void finalize(RideItem *, const Specification &, const QHash<QString,RideMetric*> &) {
         setValue(count > 0 ? total / count : 0);
         setCount(count);
     }
@@ -1409,7 +1418,7 @@ struct AvgHeartRate : public RideMetric {
 static bool avgHeartRateAdded =
     RideMetricFactory::instance().addMetric(AvgHeartRate());
 
-struct AvgCoreTemp : public RideMetric {
+struct AvgCoreTemp : public AccumulatingRideMetric {
     Q_DECLARE_TR_FUNCTIONS(AvgCoreTemp)
 
     double total, count;
@@ -1431,26 +1440,27 @@ struct AvgCoreTemp : public RideMetric {
         setDescription(tr("Average Core Temperature. The core body temperature estimate is based on HR data"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    bool begin(RideItem *item, const Specification &spec) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
             setValue(RideFile::NIL);
             setCount(0);
-            return;
+            return false;
         }
 
         total = count = 0;
+        return true;
+    }
 
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-
-            if (point->tcore > 0) {
-                total += point->tcore;
-                ++count;
-            }
+    void accumulate(const RideFilePoint *point) {
+        if (point->tcore > 0) {
+            total += point->tcore;
+            ++count;
         }
+    }
+
+    void finalize(RideItem *, const Specification &, const QHash<QString,RideMetric*> &) {
         setValue(count > 0 ? total / count : 0);
         setCount(count);
     }
@@ -1888,7 +1898,7 @@ static bool avgTempAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class MaxPower : public RideMetric {
+class MaxPower : public AccumulatingRideMetric {
     Q_DECLARE_TR_FUNCTIONS(MaxPower)
     double max;
     public:
@@ -1906,21 +1916,25 @@ class MaxPower : public RideMetric {
         setDescription(tr("Maximum Power"));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    bool begin(RideItem *item, const Specification &spec) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
             setValue(RideFile::NIL);
             setCount(0);
-            return;
+            return false;
         }
 
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->watts >= max)
-                max = point->watts;
-        }
+        max = 0.0;
+        return true;
+    }
+
+    void accumulate(const RideFilePoint *point) {
+        if (point->watts >= max)
+            max = point->watts;
+    }
+
+    void finalize(RideItem *, const Specification &, const QHash<QString,RideMetric*> &) {
         setValue(max);
     }
     bool isRelevantForRide(const RideItem *ride) const { return ride->present.contains("P") || (!ride->isSwim && !ride->isRun); }
@@ -1934,7 +1948,7 @@ static bool maxPowerAdded =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class MaxSmO2 : public RideMetric {
+class MaxSmO2 : public AccumulatingRideMetric {
     Q_DECLARE_TR_FUNCTIONS(MaxSmO2)
     double max;
     public:
@@ -1952,21 +1966,25 @@ class MaxSmO2 : public RideMetric {
         setDescription(tr("Maximum Muscle Oxygen Saturation, the percentage of hemoglobin that is carrying oxygen."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    bool begin(RideItem *item, const Specification &spec) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
             setValue(RideFile::NIL);
             setCount(0);
-            return;
+            return false;
         }
 
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->smo2 >= max)
-                max = point->smo2;
-        }
+        max = 0.0;
+        return true;
+    }
+
+    void accumulate(const RideFilePoint *point) {
+        if (point->smo2 >= max)
+            max = point->smo2;
+    }
+
+    void finalize(RideItem *, const Specification &, const QHash<QString,RideMetric*> &) {
         setValue(max);
     }
 
@@ -1980,7 +1998,7 @@ class MaxSmO2 : public RideMetric {
 static bool maxSmO2Added =
     RideMetricFactory::instance().addMetric(MaxSmO2());
 
-class MaxtHb : public RideMetric {
+class MaxtHb : public AccumulatingRideMetric {
     Q_DECLARE_TR_FUNCTIONS(MaxtHb)
     double max;
     public:
@@ -1999,22 +2017,25 @@ class MaxtHb : public RideMetric {
         setDescription(tr("Maximum total hemoglobin concentration. The total grams of hemoglobin per deciliter."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    bool begin(RideItem *item, const Specification &spec) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
             setValue(RideFile::NIL);
             setCount(0);
-            return;
+            return false;
         }
 
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
+        max = 0.0;
+        return true;
+    }
 
-            if (point->thb >= max)
-                max = point->thb;
-        }
+    void accumulate(const RideFilePoint *point) {
+        if (point->thb >= max)
+            max = point->thb;
+    }
+
+    void finalize(RideItem *, const Specification &, const QHash<QString,RideMetric*> &) {
         setValue(max);
     }
 
@@ -2129,7 +2150,7 @@ static bool mintHb =
 
 //////////////////////////////////////////////////////////////////////////////
 
-class MaxHr : public RideMetric {
+class MaxHr : public AccumulatingRideMetric {
     Q_DECLARE_TR_FUNCTIONS(MaxHr)
     double max;
     public:
@@ -2147,21 +2168,25 @@ class MaxHr : public RideMetric {
         setDescription(tr("Maximum Heart Rate."));
     }
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    bool begin(RideItem *item, const Specification &spec) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
             setValue(RideFile::NIL);
             setCount(0);
-            return;
+            return false;
         }
 
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            if (point->hr >= max)
-                max = point->hr;
-        }
+        max = 0.0;
+        return true;
+    }
+
+    void accumulate(const RideFilePoint *point) {
+        if (point->hr >= max)
+            max = point->hr;
+    }
+
+    void finalize(RideItem *, const Specification &, const QHash<QString,RideMetric*> &) {
         setValue(max);
     }
 
@@ -3805,8 +3830,8 @@ struct TotalCalories : public RideMetric {
         athlete_weight = deps.value("athlete_weight")->value(true);
         duration = deps.value("time_riding")->value(true); // time_riding or workout_time ?
 
-        athlete_age = item->dateTime.date().year() - appsettings->cvalue(item->context->athlete->cyclist, GC_DOB).toDate().year();
-        bool male = appsettings->cvalue(item->context->athlete->cyclist, GC_SEX).toInt() == 0;
+        athlete_age = item->dateTime.date().year() - item->context->athlete->settings()->value(SettingsSnapshot::YearOfBirth);
+        bool male = item->context->athlete->settings()->value(SettingsSnapshot::Sex) == 0;
 
         double kcalories = 0.0;
 
@@ -18,12 +18,31 @@
 
 
 #include "CPSolver.h"
-#include <ctime>
+#include "WPrimeBalance.h"
+
+#include <QtConcurrent>
+
+// chains run together on each thread, and iterations of each
+static const int CPSolverChains = 4;
+static const int CPSolverIterations = 25000;
+
+// iterations between progress updates
+static const int CPSolverProgress = 100;
 
 CPSolver::CPSolver(Context *context)
-   : context(context)
+   : context(context), halt(0), reporter(0)
 {
     integral = (appsettings->value(NULL, GC_WBALFORM, "int").toString() == "int");
+
+    // signalled from the solver threads
+    qRegisterMetaType<WBParms>("WBParms");
+    connect(&watcher, SIGNAL(finished()), this, SLOT(finished()));
+}
+
+CPSolver::~CPSolver()
+{
+    halt.storeRelease(1);
+    watcher.waitForFinished();
 }
 
 // set the data to solve
@@ -73,56 +92,42 @@ CPSolver::power1s(RideFile *f, double secs)
 double
 CPSolver::cost(WBParms parms)
 {
-    // returning sum(W'bal ^ 2)
-
-    // loop through each ride for now, but avoid foreach()
-    // since it will make a copy of the contents which has
-    // a significant performance impact
-    double sumwb2=0;
-    for(int i=0; i<data.count();i++)  sumwb2 += pow(compute(data[i], parms),2);
-
-    //qDebug()<<"cost="<<QString("%1").arg(sumwb2, 0, 'g', 7);
-
-    // what we got - normalise to number of fits
-    return (sumwb2/data.count()) /1000.0f;
+    return cost(QVector<WBParms>() << parms)[0];
 }
 
-double
-CPSolver::compute(QVector<int> &ride, WBParms parms)
+QVector<double>
+CPSolver::cost(const QVector<WBParms> &parms)
 {
-    // compute w'bal for the ride using the paramters
-    // XXX for now we use the integral model
-    double I=0.00f;
-    int t=0;
-    double wpbal=parms.W;
-    foreach(int watts, ride) {
-
-        if (integral) {
-
-            // INTEGRAL
-            I += exp(((double)(t) / parms.TAU)) * (watts > parms.CP ? watts-parms.CP : 0);
-            wpbal = parms.W - (exp(-((double)(t) / parms.TAU)) * I);
-
-        } else {
+    // returning sum(W'bal ^ 2) for each of the parameter sets
+    // with a single pass over each ride for all of them
+    WPrimeBalance wbal(integral ? WPrimeBalance::Integral : WPrimeBalance::Differential);
+    foreach(const WBParms &p, parms) {
+        if (integral) wbal.add(p.CP, p.W, p.TAU);
+        else wbal.add(p.CP, p.W, 0, double(p.TAU)/100.0f); // TAU is R x 100 in the differential model
+    }
 
+    QVector<double> sumwb2(parms.count(), 0);
+    for(int i=0; i<data.count(); i++) {
 
-            // DIFFERENTIAL
-            wpbal  += watts < parms.CP ? ((double(parms.TAU)/100.0f) * (parms.W - wpbal)/parms.W * (parms.CP - watts) ) : (parms.CP-watts);
-        }
+        const QVector<int> &ride = data[i];
+        wbal.reset();
+        for (int t=0; t<ride.count(); t++) wbal.step(ride[t]);
 
-        t++;
+        // we solve for W'bal=500 as it is not possible to completely
+        // exhaust W', 500 is the point at which most athletes will
+        // fail to continue, on average.
+        // See: http://www.ncbi.nlm.nih.gov/pubmed/24509723
+        for (int j=0; j<parms.count(); j++) sumwb2[j] += pow(wbal.wbal(j) - 500, 2);
     }
 
-    // we solve for W'bal=500 as it is not possible to completely
-    // exhaust W', 500 is the point at which most athletes will
-    // fail to continue, on average.
-    // See: http://www.ncbi.nlm.nih.gov/pubmed/24509723
-    return wpbal - 500;
+    // what we got - normalise to number of fits
+    for (int j=0; j<parms.count(); j++) sumwb2[j] = (sumwb2[j]/data.count()) /1000.0f;
+    return sumwb2;
 }
 
 // get us a neighbour
 WBParms
-CPSolver::neighbour(WBParms p, int k, int kmax)
+CPSolver::neighbour(WBParms p, int k, int kmax, QRandomGenerator &random)
 {
     WBParms returning;
 
@@ -142,13 +147,10 @@ CPSolver::neighbour(WBParms p, int k, int kmax)
     int TAUrange = 3 + ((constraints.tto - constraints.tf) * factor);
     int it=0;
 
-    // scale rand() to our range (32767 is typical for RAND_MAX)
-    double f = double(Wrange) / double(RAND_MAX);
-
     do {
-        returning.CP = p.CP + (rand()%CPrange - (CPrange/2));
-        returning.W = p.W + (int(double(rand())*f)%Wrange - (Wrange/2));
-        returning.TAU = p.TAU + (rand()%TAUrange - (TAUrange/2));
+        returning.CP = p.CP + (random.bounded(CPrange) - (CPrange/2));
+        returning.W = p.W + (random.bounded(Wrange) - (Wrange/2));
+        returning.TAU = p.TAU + (random.bounded(TAUrange) - (TAUrange/2));
 
     } while (it++ < 3 && (returning.CP < constraints.cpf || returning.CP > constraints.cpto ||
                           returning.W > constraints.cpto || returning.W < constraints.cpf ||
@@ -168,6 +170,10 @@ CPSolver::neighbour(WBParms p, int k, int kmax)
 void
 CPSolver::reset()
 {
+    // the solver threads read the data
+    halt.storeRelease(1);
+    watcher.waitForFinished();
+
     rides.clear();
     data.clear();
 }
@@ -176,67 +182,96 @@ void
 CPSolver::start()
 {
     // set starting conditions from first ride
-    if (data.count() == 0 || rides.count() == 0) return;
+    if (data.count() == 0 || rides.count() == 0 || watcher.isRunning()) return;
 
     // to flag when to stop
-    halt = false;
+    halt.storeRelease(0);
+    reporter.storeRelease(0);
 
     // set starting conditions at maximals
     s0.CP =   constraints.cpto;
     s0.W =    constraints.wto;
     s0.TAU =  constraints.tto;
+    s0.wpbal = 0;
+
+    sbest = s0;
+    Ebest = cost(s0);
 
-    QElapsedTimer p;
-    p.start();
+    // chains on every core, we return straight away and
+    // finished() signals the end when they are all done
+    threads.fill(CPSolverChains, qMax(1, QThread::idealThreadCount()));
+    watcher.setFuture(QtConcurrent::map(threads, [this](int &chains) { anneal(chains); }));
+}
+
+void
+CPSolver::anneal(int chains)
+{
+    // each thread has its own generator, seeded differently
+    QRandomGenerator random(QRandomGenerator::global()->generate());
 
     // initial conditions
-    srand((unsigned int) time (NULL)); // seed ONCE!
-    double E = cost(s0);
-    double Ebest = E;
-    WBParms s = s0;
-    WBParms sbest = s;
+    QVector<WBParms> s(chains, s0), snew(chains);
+    QVector<double> E = cost(s), Enew;
+
+    int kmax = CPSolverIterations;
 
-    // 10,000 iterations at most
-    int k=0;
-    int kmax = 100000;
+    // progress is from the first chain of the first thread to get
+    // here, every so often or when it improves, to not swamp the display
+    bool reporting = reporter.testAndSetOrdered(0, 1);
+    double Ereported = E[0];
 
     // give up when we're on it or run out of loops
-    while (halt == false && k < kmax) {
+    for (int k=0; halt.loadAcquire() == 0 && k < kmax; k++) {
 
-        WBParms snew = neighbour(s, k, kmax);
-        double Enew = cost(snew);
+        for (int i=0; i<chains; i++) snew[i] = neighbour(s[i], k, kmax, random);
+        Enew = cost(snew);
 
         // progress update k=0 means stop so we offset by one
-        emit current(k+1, snew,Enew);
+        if (reporting && (k % CPSolverProgress == 0 || Enew[0] < Ereported)) {
+            Ereported = Enew[0];
+            emit current(k+1, snew[0], Enew[0]);
+        }
 
-        // probability - always 1 if better, but randomly accept higher
-        double random = double(rand()%101)/100.00f;
         double temp = temperature(double(k)/double(kmax));
-        double prob = probability(E,Enew,temp);
+        for (int i=0; i<chains; i++) {
 
-        if (prob > random) {
-            s = snew;
-            E = Enew;
-        }
+            // probability - always 1 if better, but randomly accept higher
+            double random01 = double(random.bounded(101))/100.00f;
+            double prob = probability(E[i],Enew[i],temp);
 
-        // is it better than our very best?
-        if (E < Ebest) {
-            Ebest = E;
-            sbest = s;
+            if (prob > random01) {
+                s[i] = snew[i];
+                E[i] = Enew[i];
+            }
 
-            // k of zero means stop so we offset by one
-            emit newBest(k+1, sbest, Ebest);
-            //qDebug()<<k<<"new best"<<Ebest <<s.CP<<s.W<<s.TAU;
+            // is it better than our very best?
+            best(k+1, s[i], E[i]);
         }
+    }
+}
+
+void
+CPSolver::best(int k, WBParms s, double E)
+{
+    QMutexLocker locker(&bestLock);
 
-        // don't run forever
-        k++;
+    if (E < Ebest) {
+        Ebest = E;
+        sbest = s;
 
+        // k of zero means stop so we offset by one
+        emit newBest(k, sbest, Ebest);
     }
+}
+
+void
+CPSolver::finished()
+{
+    // restarted since
+    if (watcher.isRunning()) return;
 
     // k of zero means stop
     emit newBest(0, sbest,Ebest);
-    //qDebug()<<"TOOK"<<p.elapsed();
 }
 
 double
@@ -260,7 +295,7 @@ CPSolver::pause()
 void
 CPSolver::stop()
 {
-    halt = true;
+    halt.storeRelease(1);
 }
 
 // Metric of best 'R' for first exhaustion point in a ride
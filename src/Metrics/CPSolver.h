@@ -29,6 +29,10 @@
 #include <QList>
 #include <QVector>
 #include <QObject>
+#include <QMutex>
+#include <QAtomicInt>
+#include <QFutureWatcher>
+#include <QRandomGenerator>
 
 class Context;
 
@@ -40,6 +44,7 @@ public:
     double CP, W, TAU; // the parameters
     double wpbal; // the result (used to pass back)
 };
+Q_DECLARE_METATYPE(WBParms)
 
 class CPSolverConstraints {
     public:
@@ -72,18 +77,22 @@ class CPSolver : public QObject {
 
         // as simulated annealing algorithm to solve W', CP and tau
         // from a collection of exhaustion points within a ride
+        //
+        // independent chains are run in lockstep a few to a thread on
+        // all the cores, so the chains on a thread are costed together
+        // in a single pass over the data. progress and new bests are
+        // signalled from the solver threads as they go.
         CPSolver(Context *);
+        ~CPSolver();
 
         // set the data to solve
         void setData(CPSolverConstraints constraints, QList<RideItem*>);
 
         // compute the cost, using the settings passed
         double cost(WBParms parms);
+        QVector<double> cost(const QVector<WBParms> &parms);
 
-        // compute ending W'bal for the exhaustion series
-        double compute(QVector<int> &ride, WBParms parms);
-
-        WBParms neighbour(WBParms, int k, int kmax);
+        WBParms neighbour(WBParms, int k, int kmax, QRandomGenerator &random);
         double probability(double,double,double);
         double temperature(double);
 
@@ -103,8 +112,17 @@ class CPSolver : public QObject {
         void pause();
         void stop();
 
+    private slots:
+
+        // all the chains are done
+        void finished();
+
     private:
 
+        // run a thread's chains from start to end
+        void anneal(int chains);
+        void best(int k, WBParms s, double E);
+
         // who we for ?
         Context *context;
         CPSolverConstraints constraints;
@@ -116,9 +134,19 @@ class CPSolver : public QObject {
 
         // annealling parms
         WBParms s0, sbest;
+        double Ebest;
+        QMutex bestLock;
+
+        // the chains running on each thread
+        QVector<int> threads;
+        QFutureWatcher<void> watcher;
+
+        // to signal we need to stop, set by the gui thread
+        // and polled by the solver threads
+        QAtomicInt halt;
 
-        // to signal we need to stop
-        bool halt;
+        // the one thread reporting progress
+        QAtomicInt reporter;
 };
 
 #endif
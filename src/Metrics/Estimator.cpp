@@ -26,6 +26,8 @@
 
 #include "Banister.h"
 
+#include <QtConcurrent>
+
 Q_DECLARE_LOGGING_CATEGORY(gcEstimator)
 Q_LOGGING_CATEGORY(gcEstimator, "gc.estimator")
 
@@ -200,26 +202,9 @@ Estimator::run()
         continue;
     }
 
-    // set up the models we support
-    CP2Model p2model(context);
-    CP3Model p3model(context);
-    ExtendedModel extmodel(context);
-#if 0 // disable until model fitting errors are fixed (!!!)
-    WSModel wsmodel(context);
-    MultiModel multimodel(context);
-#endif
-
-    QList <PDModel *> models;
-    models << &p2model;
-    models << &p3model;
-    models << &extmodel;
-#if 0 // disable until model fitting errors are fixed (!!!)
-    models << &multimodel;
-    models << &wsmodel;
-#endif
-
     // from starts a week having first ride with Power data / looking at the next 7 days of data with Power
     // calculate Estimates for all data per week including the week of the last Power recording
+    QVector<Bests> weeks;
     QDate date = from.addDays((1-from.dayOfWeek())); // Weeks start on monday in GC
     while (date <= to) {
 
@@ -267,19 +252,98 @@ Estimator::run()
         bests.addBests(week);
         bestsWPK.addBests(wpk);
 
-        // we now have the data
+        // the models are fitted for all the weeks at once below
+        Bests add;
+        add.from = begin;
+        add.to = end;
+        add.watts = bests.aggregate();
+        add.wpk = bestsWPK.aggregate();
+        weeks << add;
+
+        // go forward a week
+        date = date.addDays(7);
+    }
+
+    // we now have the data
+    est = fitModels(context, sport, weeks, &abort);
+    if (abort == true) {
+        printd("Model estimator aborted.\n");
+        abort = false;
+        return;
+    }
+
+    // filter performances
+    perfs = filter(perfs);
+
+    // now update them
+    lock.lock();
+    if (first) {
+        first = false;
+        estimates = est;
+        performances = perfs;
+    } else {
+        estimates.append(est);
+        performances.append(perfs);
+    }
+    lock.unlock();
+
+    // debug dump peak performances
+    foreach(Performance p, performances) {
+        printd("%s %f Peak: %f for %f secs on %s\n", sport.toStdString().c_str(), p.powerIndex, p.power, p.duration, p.when.toString().toStdString().c_str());
+    }
+    printd("%s Estimates end.\n", sport.toStdString().c_str());
+  }
+}
+
+// the fits for each week don't depend upon each other, so they're
+// spread across the thread pool, each with its own models (the models
+// are fitted with lmcurve_data which doesn't share any state)
+QList<PDEstimate>
+Estimator::fitModels(Context *context, QString sport, const QVector<Bests> &weeks, const bool *abort)
+{
+    QVector<QList<PDEstimate> > results(weeks.count());
+
+    QVector<int> worklist(weeks.count());
+    for (int i=0; i<weeks.count(); i++) worklist[i] = i;
+
+    QtConcurrent::blockingMap(worklist, [context, sport, &weeks, &results, abort] (int i) {
+
+        // check if we've been asked to stop
+        if (abort && *abort) return;
+
+        const Bests &week = weeks[i];
+        QList<PDEstimate> &fitted = results[i];
+
+        // set up the models we support
+        CP2Model p2model(context);
+        CP3Model p3model(context);
+        ExtendedModel extmodel(context);
+#if 0 // disable until model fitting errors are fixed (!!!)
+        WSModel wsmodel(context);
+        MultiModel multimodel(context);
+#endif
+
+        QList <PDModel *> models;
+        models << &p2model;
+        models << &p3model;
+        models << &extmodel;
+#if 0 // disable until model fitting errors are fixed (!!!)
+        models << &multimodel;
+        models << &wsmodel;
+#endif
+
         foreach(PDModel *model, models) {
 
             PDEstimate add;
 
             // set the data
-            model->setData(bests.aggregate());
+            model->setData(week.watts);
             model->saveParameters(add.parameters); // save the computed parms
 
             add.sport = sport;
             add.wpk = false;
-            add.from = begin;
-            add.to = end;
+            add.from = week.from;
+            add.to = week.to;
             add.model = model->code();
             add.WPrime = model->hasWPrime() ? model->WPrime() : 0;
             add.CP = model->hasCP() ? model->CP() : 0;
@@ -291,18 +355,18 @@ Estimator::run()
             // so long as the important model derived values are sensible ...
             if (add.WPrime > 1000 && add.CP > 100 && add.CP < 1000) {
                 printd("%s Estimates for %s - %s (%s): CP=%.f W'=%.f\n", sport.toStdString().c_str(), add.from.toString().toStdString().c_str(), add.to.toString().toStdString().c_str(), add.model.toStdString().c_str(), add.CP, add.WPrime);
-                est << add;
+                fitted << add;
             } else {
                 printd("%s Estimates for %s - %s (%s): Not available\n", sport.toStdString().c_str(), add.from.toString().toStdString().c_str(), add.to.toString().toStdString().c_str(), add.model.toStdString().c_str());
             }
 
             // set the wpk data
-            model->setData(bestsWPK.aggregate());
+            model->setData(week.wpk);
             model->saveParameters(add.parameters); // save the computed parms
 
             add.wpk = true;
-            add.from = begin;
-            add.to = end;
+            add.from = week.from;
+            add.to = week.to;
             add.model = model->code();
             add.WPrime = model->hasWPrime() ? model->WPrime() : 0;
             add.CP = model->hasCP() ? model->CP() : 0;
@@ -316,38 +380,18 @@ Estimator::run()
                 (!model->hasPMax() || add.PMax > 1.0f) &&
                 (!model->hasFTP() || add.FTP > 1.0f)) {
                 printd("%s WPK Estimates for %s - %s (%s): CP=%.1f W'=%.1f\n", sport.toStdString().c_str(), add.from.toString().toStdString().c_str(), add.to.toString().toStdString().c_str(), add.model.toStdString().c_str(), add.CP, add.WPrime);
-                est << add;
+                fitted << add;
             } else {
                 printd("%s WPK Estimates for %s - %s (%s): Not available\n", sport.toStdString().c_str(), add.from.toString().toStdString().c_str(), add.to.toString().toStdString().c_str(), add.model.toStdString().c_str());
             }
 
         }
+    });
 
-        // go forward a week
-        date = date.addDays(7);
-    }
-
-    // filter performances
-    perfs = filter(perfs);
-
-    // now update them
-    lock.lock();
-    if (first) {
-        first = false;
-        estimates = est;
-        performances = perfs;
-    } else {
-        estimates.append(est);
-        performances.append(perfs);
-    }
-    lock.unlock();
-
-    // debug dump peak performances
-    foreach(Performance p, performances) {
-        printd("%s %f Peak: %f for %f secs on %s\n", sport.toStdString().c_str(), p.powerIndex, p.power, p.duration, p.when.toString().toStdString().c_str());
-    }
-    printd("%s Estimates end.\n", sport.toStdString().c_str());
-  }
+    // in the order of the weeks, as they were computed one after another
+    QList<PDEstimate> returning;
+    foreach(const QList<PDEstimate> &fitted, results) returning.append(fitted);
+    return returning;
 }
 
 Performance Estimator::getPerformanceForDate(QDate date, QString sport)
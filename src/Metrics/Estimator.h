@@ -67,6 +67,16 @@ class Estimator : public QThread {
         // filter marks performances as submax
         QList<Performance> filter(QList<Performance>);
 
+        // the rolling 6 weeks of bests at the end of a week
+        struct Bests {
+            QDate from, to;
+            QVector<float> watts, wpk;
+        };
+
+        // fits every model to the bests for each week, across the thread
+        // pool, the sensible estimates are returned in the order of the weeks
+        static QList<PDEstimate> fitModels(Context *context, QString sport, const QVector<Bests> &weeks, const bool *abort=NULL);
+
     public slots:
 
         // setup and run estimators
@@ -27,14 +27,19 @@
 #include <assert.h>
 #include <QApplication>
 
-class HrZoneTime : public RideMetric {
+class HrZoneTime : public AccumulatingRideMetric {
     Q_DECLARE_TR_FUNCTIONS(HrZoneTime)
     int level;
     double seconds;
 
+    // set by begin() for the pass over the samples
+    const HrZones *zones;
+    int range;
+    double secs, totalSecs;
+
 public:
 
-    HrZoneTime() : level(0), seconds(0.0)
+    HrZoneTime() : level(0), seconds(0.0), zones(NULL), range(-1), secs(0.0), totalSecs(0.0)
     {
         setType(RideMetric::Total);
         setMetricUnits(tr("seconds"));
@@ -47,29 +52,37 @@ public:
 
     void setLevel(int level) { this->level=level-1; } // zones start from zero not 1
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    bool begin(RideItem *item, const Specification &spec) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride())) {
             setValue(RideFile::NIL);
             setCount(0);
-            return;
+            return false;
         }
 
-        double totalSecs = 0.0;
-        seconds = 0;
-
         // get zone ranges
-        if (item->context->athlete->hrZones(item->sport) && item->hrZoneRange >= 0 && item->ride()->areDataPresent()->hr) {
-            // iterate and compute
-            RideFileIterator it(item->ride(), spec);
-            while (it.hasNext()) {
-                struct RideFilePoint *point = it.next();
-                totalSecs += item->ride()->recIntSecs();
-                if (item->context->athlete->hrZones(item->sport)->whichZone(item->hrZoneRange, point->hr) == level)
-                    seconds += item->ride()->recIntSecs();
-            }
+        if (!item->context->athlete->hrZones(item->sport) || item->hrZoneRange < 0 || !item->ride()->areDataPresent()->hr) {
+            setValue(0);
+            setCount(0);
+            return false;
         }
+
+        zones = item->context->athlete->hrZones(item->sport);
+        range = item->hrZoneRange;
+        secs = item->ride()->recIntSecs();
+        totalSecs = 0.0;
+        seconds = 0;
+        return true;
+    }
+
+    void accumulate(const RideFilePoint *point) {
+        totalSecs += secs;
+        if (zones->whichZone(range, point->hr) == level)
+            seconds += secs;
+    }
+
+    void finalize(RideItem *, const Specification &, const QHash<QString,RideMetric*> &) {
         setValue(seconds);
         setCount(totalSecs);
     }
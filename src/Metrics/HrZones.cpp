@@ -79,7 +79,7 @@ void HrZones::initializeZoneParameters()
 }
 
 // read zone file, allowing for zones with or without end dates
-bool HrZones::read(QFile &file)
+bool HrZones::parse(QFile &file)
 {
 
     //
@@ -430,17 +430,18 @@ bool HrZones::read(QFile &file)
     return true;
 }
 
+bool HrZones::read(QFile &file)
+{
+    bool returning = parse(file);
+    index.build(ranges);
+    return returning;
+}
+
 // note empty dates are treated as automatic matches for begin or
 // end of range
 int HrZones::whichRange(const QDate &date) const
 {
-    for (int rnum = 0; rnum < ranges.size(); ++rnum) {
-        const HrZoneRange &range = ranges[rnum];
-        if (((date >= range.begin) || (range.begin.isNull())) &&
-            ((date < range.end) || (range.end.isNull())))
-            return rnum;
-    }
-    return -1;
+    return index.whichRange(date);
 }
 
 int HrZones::numZones(int rnum) const
@@ -452,16 +453,7 @@ int HrZones::numZones(int rnum) const
 int HrZones::whichZone(int rnum, double value) const
 {
     if (rnum < 0 || rnum > ranges.size()) return 0;
-    const HrZoneRange &range = ranges[rnum];
-    for (int j = 0; j < range.zones.size(); ++j) {
-        const HrZoneInfo &info = range.zones[j];
-    // note: the "end" of range is actually in the next zone
-        if ((value >= info.lo) && (value < info.hi))
-            return j;
-    }
-
-    // if we got here either it is negative, nan, inf or way high
-    return -1;
+    return index.whichZone(rnum, value);
 }
 
 void HrZones::zoneInfo(int rnum, int znum,
@@ -585,6 +577,7 @@ void HrZones::setHrZonesFromLT(HrZoneRange &range) {
 void HrZones::setHrZonesFromLT(int rnum) {
     assert((rnum >= 0) && (rnum < ranges.size()));
     setHrZonesFromLT(ranges[rnum]);
+    index.build(ranges);
 }
 
 // return the list of starting values of zones for a given range
@@ -744,6 +737,7 @@ void HrZones::write(QDir home)
 void HrZones::addHrZoneRange(QDate _start, QDate _end, int _lt, int _aet, int _restHr, int _maxHr)
 {
     ranges.append(HrZoneRange(_start, _end, _lt, _aet, _restHr, _maxHr));
+    index.build(ranges);
 }
 
 // insert a new zone range using the current scheme
@@ -768,23 +762,27 @@ int HrZones::addHrZoneRange(QDate _start, int _lt, int _aet, int _restHr, int _m
         setHrZonesFromLT(rnum);
     }
 
+    index.build(ranges);
     return rnum;
 }
 
 void HrZones::addHrZoneRange()
 {
     ranges.append(HrZoneRange(date_zero, date_infinity));
+    index.build(ranges);
 }
 
 void HrZones::setEndDate(int rnum, QDate endDate)
 {
     ranges[rnum].end = endDate;
     modificationTime = QDateTime::currentDateTime();
+    index.build(ranges);
 }
 void HrZones::setStartDate(int rnum, QDate startDate)
 {
     ranges[rnum].begin = startDate;
     modificationTime = QDateTime::currentDateTime();
+    index.build(ranges);
 }
 
 QDate HrZones::getStartDate(int rnum) const
@@ -851,6 +849,7 @@ int HrZones::deleteRange(int rnum) {
     // delete this range then
     ranges.removeAt(rnum);
 
+    index.build(ranges);
     return rnum-1;
 }
 
@@ -884,6 +883,7 @@ int HrZones::insertRangeAtDate(QDate date, int lt) {
         setHrZonesFromLT(rnum);
     }
 
+    index.build(ranges);
     return rnum;
 }
 
@@ -19,6 +19,7 @@
 #ifndef _HrZones_h
 #define _HrZones_h
 #include "GoldenCheetah.h"
+#include "ZoneIndex.h"
 
 #include <QtCore>
 
@@ -72,7 +73,7 @@ struct HrZoneRange {
         begin(b), end(e), lt(_lt), aet(_aet), restHr(_restHr), maxHr(_maxHr), hrZonesSetFromLT(false) {}
 
     // used by std::sort
-    bool operator< (HrZoneRange right) const {
+    bool operator< (const HrZoneRange &right) const {
         return (((! right.begin.isNull()) &&
                 (begin.isNull() || begin < right.begin )) ||
                 ((begin == right.begin) && (! end.isNull()) &&
@@ -98,6 +99,8 @@ class HrZones : public QObject
 
         // LT History
         QList<HrZoneRange> ranges;
+        ZoneIndex index; // rebuilt whenever ranges change
+        bool parse(QFile &file);
 
         // utility
         QString err, warning, fileName_;
@@ -143,7 +146,7 @@ class HrZones : public QObject
 
         // Get / Set ZoneRange details
         HrZoneRange getHrZoneRange(int rnum) { return ranges[rnum]; }
-        void setHrZoneRange(int rnum, HrZoneRange x) { ranges[rnum] = x; }
+        void setHrZoneRange(int rnum, HrZoneRange x) { ranges[rnum] = x; index.build(ranges); }
 
         // get and set LT for a given range
         int getLT(int rnum) const;
@@ -189,6 +192,9 @@ class HrZones : public QObject
         // will return -1 if not in any zone
         int whichZone(int range, double value) const;
 
+        // the lookup tables behind whichRange() and whichZone()
+        const ZoneIndex &zoneIndex() const { return index; }
+
         // how many zones are there for a given range
         int numZones(int range) const;
 
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2026 The GoldenCheetah Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "MetricDependencyGraph.h"
+
+#include <QDebug>
+
+void
+MetricDependencyGraph::compile(const QStringList &symbols, const QVector<QVector<QString> > &deps,
+                               const QVector<bool> &deferred)
+{
+    const int n = symbols.count();
+
+    ids_.clear();
+    ids_.reserve(n);
+    for (int i=0; i<n; i++) ids_.insert(symbols[i], i);
+
+    deferred_ = deferred;
+    deferred_.resize(n);
+
+    // resolve the dependencies by name, once
+    depends_.clear();
+    depends_.resize(n);
+    for (int i=0; i<n && i<deps.count(); i++) {
+        foreach(const QString &dep, deps[i]) {
+            int d = ids_.value(dep, -1);
+            if (d < 0) {
+                qDebug()<<"metric dep error:"<<symbols[i]<<"depends on unknown metric"<<dep;
+                continue;
+            }
+            if (d != i && !depends_[i].contains(d)) depends_[i] << d;
+        }
+    }
+
+    // anything depending on a deferred metric has to come after it
+    // so it is deferred too, otherwise levelling it would level the
+    // deferred metric before we know where they start from
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int i=0; i<n; i++) {
+            if (deferred_[i]) continue;
+            foreach(int dep, depends_[i]) {
+                if (deferred_[dep]) {
+                    deferred_[i] = true;
+                    changed = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    // builtins get levelled first so we know where
+    // the deferred metrics need to start from
+    QVector<char> state(n, 0);
+    level_.fill(-1, n);
+    deferredLevel_ = 0;
+
+    for (int i=0; i<n; i++) if (!deferred_[i]) assignLevel(i, state);
+    for (int i=0; i<n; i++) if (!deferred_[i] && level_[i] >= deferredLevel_) deferredLevel_ = level_[i] + 1;
+    for (int i=0; i<n; i++) if (deferred_[i]) assignLevel(i, state);
+
+    // and the worklist for each level
+    levels_.clear();
+    for (int i=0; i<n; i++) {
+        if (level_[i] >= levels_.count()) levels_.resize(level_[i] + 1);
+        levels_[level_[i]] << i;
+    }
+}
+
+int
+MetricDependencyGraph::assignLevel(int id, QVector<char> &state)
+{
+    if (state[id] == 2) return level_[id];
+    if (state[id] == 1) return -1; // cycle
+
+    state[id] = 1;
+
+    int level = deferred_[id] ? deferredLevel_ : 0;
+    QVector<int> resolved;
+    foreach(int dep, depends_[id]) {
+        int l = assignLevel(dep, state);
+        if (l < 0) {
+            qDebug()<<"metric dep error: cycle between"<<ids_.key(id)<<"and"<<ids_.key(dep);
+            continue;
+        }
+        if (l >= level) level = l + 1;
+        resolved << dep;
+    }
+    depends_[id] = resolved;
+
+    level_[id] = level;
+    state[id] = 2;
+    return level;
+}
+
+QVector<QVector<int> >
+MetricDependencyGraph::schedule(const QVector<int> &wanted) const
+{
+    QVector<char> needed(count(), 0);
+    foreach(int id, wanted) if (id >= 0 && id < count()) needed[id] = 1;
+
+    // dependencies always live on lower levels, so walking
+    // down the levels pulls them in before we get to them
+    QVector<QVector<int> > returning(levels_.count());
+    for (int l=levels_.count()-1; l>=0; l--) {
+        foreach(int id, levels_[l]) {
+            if (!needed[id]) continue;
+            returning[l] << id;
+            foreach(int dep, depends_[id]) needed[dep] = 1;
+        }
+    }
+
+    // drop empty levels
+    QVector<QVector<int> > worklist;
+    foreach(const QVector<int> &level, returning)
+        if (level.count()) worklist << level;
+    return worklist;
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2026 The GoldenCheetah Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_MetricDependencyGraph_h
+#define _GC_MetricDependencyGraph_h 1
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+//
+// The metric dependency DAG, compiled once by the RideMetricFactory
+// whenever metrics are added or removed, rather than resolved by name
+// every time a ride or interval is computed.
+//
+// Metrics are identified by their factory index, dependencies are
+// held as indexes and every metric is assigned a topological level;
+// all of the dependencies of a metric live on lower levels, so all
+// the metrics on the same level can be computed independently.
+//
+// Deferred metrics (user metrics whose dependencies can't be known,
+// see UserMetric::dependencies) are always placed on levels above
+// every non-deferred metric, along with anything that depends on them.
+//
+class MetricDependencyGraph
+{
+    public:
+
+        MetricDependencyGraph() : deferredLevel_(0) {}
+
+        // symbols are in factory index order, deps and deferred
+        // are indexed the same way; unknown dependencies and cycles
+        // are reported and ignored
+        void compile(const QStringList &symbols,
+                     const QVector<QVector<QString> > &deps,
+                     const QVector<bool> &deferred);
+
+        int count() const { return depends_.count(); }
+        int id(const QString &symbol) const { return ids_.value(symbol, -1); }
+        int level(int id) const { return level_[id]; }
+        int levels() const { return levels_.count(); }
+        bool isDeferred(int id) const { return deferred_[id]; }
+        const QVector<int> &dependencies(int id) const { return depends_[id]; }
+
+        // the wanted metrics along with everything they depend upon,
+        // returned as one worklist per level in the order they must
+        // be computed, empty levels are dropped
+        QVector<QVector<int> > schedule(const QVector<int> &wanted) const;
+
+    private:
+
+        int assignLevel(int id, QVector<char> &state);
+
+        QHash<QString, int> ids_;
+        QVector<QVector<int> > depends_;
+        QVector<bool> deferred_;
+        QVector<int> level_;
+        QVector<QVector<int> > levels_;
+        int deferredLevel_;
+};
+
+#endif // _GC_MetricDependencyGraph_h
@@ -18,7 +18,7 @@
 
 #include "PDModel.h"
 #include "LTMTrend.h"
-#include "lmcurve.h"
+#include "lmcurve_data.h"
 
 //extern ztable PD_ZTABLE;
 // base class for all models
@@ -127,10 +127,10 @@ PDModel::setIntervals(double sanI1, double sanI2, double anI1, double anI2,
 }
 
 // used to wrap a function call when deriving parameters
-QMutex calllmfit;
-PDModel *calllmfitmodel = NULL;
-double calllmfitf(double t, const double *p) {
-    return static_cast<PDModel*>(calllmfitmodel)->f(t, p);
+double
+PDModel::fitf(double t, const double *p, void *model)
+{
+    return static_cast<PDModel*>(model)->f(t, p);
 }
 
 // using the data and intervals from above, derive the
@@ -291,15 +291,8 @@ PDModel::deriveCPParameters(int model)
         lm_control_struct control = lm_control_double;
         lm_status_struct status;
 
-        // use forwarder via global variable, so mutex around this !
-        calllmfit.lock();
-        calllmfitmodel = this;
-
         //fprintf(stderr, "Fitting ...\n" ); fflush(stderr);
-        lmcurve(this->nparms(), par, p.count(), t.constData(), p.constData(), calllmfitf, &control, &status);
-
-        // release for others
-        calllmfit.unlock();
+        lmcurve_data(this->nparms(), par, p.count(), t.constData(), p.constData(), fitf, this, &control, &status);
 
         //fprintf(stderr, "Results:\n" );
         //fprintf(stderr, "status after %d function evaluations:\n  %s\n",
@@ -1008,8 +1001,6 @@ ExtendedModel::deriveExtCPParameters()
         p = data;
         t = tdata;
 
-        fprintf(stderr, "derive %d params using lmfit!\n", this->nparms()); fflush(stderr);
-
         // set starting values
         double par[8];
         par[0]= paa;
@@ -1024,24 +1015,7 @@ ExtendedModel::deriveExtCPParameters()
         lm_control_struct control = lm_control_double;
         lm_status_struct status;
 
-        // use forwarder via global variable, so mutex around this !
-        calllmfit.lock();
-        calllmfitmodel = this;
-
-        fprintf(stderr, "Fitting ...\n" ); fflush(stderr);
-        lmcurve(this->nparms(), par, p.count(), t.constData(), p.constData(), calllmfitf, &control, &status);
-
-        // release for others
-        calllmfit.unlock();
-
-        fprintf(stderr, "Results:\n" );
-        fprintf(stderr, "status after %d function evaluations:\n  %s\n",
-                status.nfev, lm_infmsg[status.outcome] ); fflush(stderr);
-
-        fprintf(stderr,"obtained parameters:\n"); fflush(stderr);
-        for (int i = 0; i < this->nparms(); ++i)
-            fprintf(stderr,"  par[%i] = %12g\n", i, par[i]);
-        fprintf(stderr,"obtained norm:\n  %12g\n", status.fnorm ); fflush(stderr);
+        lmcurve_data(this->nparms(), par, p.count(), t.constData(), p.constData(), fitf, this, &control, &status);
 
         // save away the values we fit to.
         this->setParms(par);
@@ -135,6 +135,10 @@ class PDModel : public QObject, public QwtSyntheticPointData
         virtual double f(double, const double *) { return -1; }
         virtual bool setParms(double *) { return false; }
 
+        // f() of the model passed as the user data to lmcurve_data(), which
+        // doesn't share state so different models can be fitted at once
+        static double fitf(double t, const double *p, void *model);
+
         // we identify peak efforts when modelling
         // lets make these available, currently only
         // available with the extended CP model
@@ -177,11 +181,6 @@ class PDModel : public QObject, public QwtSyntheticPointData
         bool minutes;
 };
 
-// control calling lmfit
-extern QMutex calllmfit;
-extern PDModel *calllmfitmodel;
-extern double calllmfitf(double t, const double *p);
-
 // estimates are recorded
 class PDEstimate
 {
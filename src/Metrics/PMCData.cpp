@@ -59,10 +59,14 @@ PMCData::PMCData(Context *context, Specification spec, QString metricName, int s
 
 
     refresh();
-    connect(context, SIGNAL(rideAdded(RideItem*)), this, SLOT(invalidate()));
-    connect(context, SIGNAL(rideDeleted(RideItem*)), this, SLOT(invalidate()));
-    connect(context, SIGNAL(refreshUpdate(QDate)), this, SLOT(invalidate()));
-    connect(context->athlete->rideCache, SIGNAL(itemChanged(RideItem*)), this, SLOT(invalidate()));
+    connect(context, SIGNAL(rideAdded(RideItem*)), this, SLOT(invalidate(RideItem*)));
+    connect(context, SIGNAL(rideDeleted(RideItem*)), this, SLOT(invalidate(RideItem*)));
+    connect(context, SIGNAL(refreshUpdate(QDate)), this, SLOT(invalidate(QDate)));
+    connect(context->athlete->rideCache, SIGNAL(itemChanged(RideItem*)), this, SLOT(invalidate(RideItem*)));
+
+    // refreshUpdate is only signalled every so often as the refresh works
+    // back through the rides, so not for all of the days that changed
+    connect(context, SIGNAL(refreshEnd()), this, SLOT(invalidate()));
     connect(context->athlete->seasons, SIGNAL(seasonsChanged()), this, SLOT(invalidate()));
 }
 
@@ -101,15 +105,46 @@ PMCData::PMCData(Context *context, Specification spec, Leaf *expr, DataFilterRun
 
 
     refresh();
-    connect(context, SIGNAL(rideAdded(RideItem*)), this, SLOT(invalidate()));
-    connect(context, SIGNAL(rideDeleted(RideItem*)), this, SLOT(invalidate()));
-    connect(context, SIGNAL(refreshUpdate(QDate)), this, SLOT(invalidate()));
-    connect(context->athlete->rideCache, SIGNAL(itemChanged(RideItem*)), this, SLOT(invalidate()));
+    connect(context, SIGNAL(rideAdded(RideItem*)), this, SLOT(invalidate(RideItem*)));
+    connect(context, SIGNAL(rideDeleted(RideItem*)), this, SLOT(invalidate(RideItem*)));
+    connect(context, SIGNAL(refreshUpdate(QDate)), this, SLOT(invalidate(QDate)));
+    connect(context->athlete->rideCache, SIGNAL(itemChanged(RideItem*)), this, SLOT(invalidate(RideItem*)));
+
+    // refreshUpdate is only signalled every so often as the refresh works
+    // back through the rides, so not for all of the days that changed
+    connect(context, SIGNAL(refreshEnd()), this, SLOT(invalidate()));
 }
 
 void PMCData::invalidate()
 {
     isstale=true;
+    stalefrom=QDate();
+}
+
+void PMCData::invalidate(QDate date)
+{
+    // the recurrences only look back, so days before
+    // the earliest that changed don't need recomputing
+    if (!isstale) stalefrom = date;
+    else if (stalefrom.isValid() && date < stalefrom) stalefrom = date;
+    isstale=true;
+}
+
+void PMCData::invalidate(RideItem *item)
+{
+    if (item) {
+        // a ride moved to another day changes the day it was on too
+        QDate date = item->dateTime.date();
+        QDate was = included_.value(item, date);
+        invalidate(was < date ? was : date);
+    } else invalidate();
+}
+
+// zero the days from a day onwards
+static void
+clearFrom(QVector<double> &series, int from)
+{
+    for (int i=from; i<series.count(); i++) series[i] = 0;
 }
 
 void PMCData::refresh()
@@ -117,6 +152,7 @@ void PMCData::refresh()
     if (!isstale) return;
 
     // we need to reread config if refreshing (it might have changed)
+    int wasSts = stsDays_, wasLts = ltsDays_;
     if (useDefaults) {
 
         QVariant lts = appsettings->cvalue(context->athlete->cyclist, GC_LTS_DAYS);
@@ -131,6 +167,8 @@ void PMCData::refresh()
     QElapsedTimer timer;
     timer.start();
 
+    QDate wasStart = start_;
+
     //
     // STEP ONE: What is the date range ?
     //
@@ -165,6 +203,15 @@ void PMCData::refresh()
     // back to null date if not set, just to get round date arithmetic
     if (start_ == QDate(9999,12,31)) start_ = QDate();
 
+    // if only rides changed since the last refresh we recompute from the
+    // earliest of them, carrying on from the day before. Everything is recomputed if the
+    // parameters changed, the range starts on a different day, or the day
+    // has changed since the expected series switches to actual on today
+    int from = 0;
+    if (stalefrom.isValid() && days_ > 0 && start_ == wasStart && refreshDay == QDate::currentDate()
+        && stsDays_ == wasSts && ltsDays_ == wasLts)
+        from = int(qBound(qint64(1), qMin(start_.daysTo(stalefrom), qint64(days_)), start_.daysTo(end_)+1));
+
     // We got a valid range ?
     if (start_ != QDate() && end_ != QDate() && start_ < end_) {
 
@@ -223,29 +270,32 @@ void PMCData::refresh()
     // const double lte = (double)exp(-1.0/ltsDays_);
     // const double ste = (double)exp(-1.0/stsDays_);
 
-    // clear what's there
-    stress_.fill(0);
-    lts_.fill(0);
-    sts_.fill(0);
-    sb_.fill(0);
-    rr_.fill(0);
-
-    planned_stress_.fill(0);
-    planned_lts_.fill(0);
-    planned_sts_.fill(0);
-    planned_sb_.fill(0);
-    planned_rr_.fill(0);
-
-    expected_stress_.fill(0);
-    expected_lts_.fill(0);
-    expected_sts_.fill(0);
-    expected_sb_.fill(0);
-    expected_rr_.fill(0);
+    // clear what's there from the day we start, sb on that day was set
+    // from the day before, unless shown on the day when it is rewritten
+    int sbfrom = from ? from+1 : 0;
+    clearFrom(stress_, from);
+    clearFrom(lts_, from);
+    clearFrom(sts_, from);
+    clearFrom(sb_, sbfrom);
+    clearFrom(rr_, from);
+
+    clearFrom(planned_stress_, from);
+    clearFrom(planned_lts_, from);
+    clearFrom(planned_sts_, from);
+    clearFrom(planned_sb_, sbfrom);
+    clearFrom(planned_rr_, from);
+
+    clearFrom(expected_stress_, from);
+    clearFrom(expected_lts_, from);
+    clearFrom(expected_sts_, from);
+    clearFrom(expected_sb_, sbfrom);
+    clearFrom(expected_rr_, from);
 
     // add the seeded values from seasons
     foreach(Season x, context->athlete->seasons->seasons) {
         if (x.getSeed()) {
             int offset = start_.daysTo(x.getStart());
+            if (offset < from) continue;
             lts_[offset] = x.getSeed() * -1;
             sts_[offset] = x.getSeed() * -1;
 
@@ -256,14 +306,18 @@ void PMCData::refresh()
 
     DataFilter* df = new DataFilter(this, context);
 
+    // which day each ride was added on, from the day we start
+    if (from == 0) included_.clear();
+
     int todayOffset = -1;
     double todayActualStress = 0;
     double todayPlannedStress = 0;
 
-    // add the stress scores
-    foreach(RideItem *item, context->athlete->rideCache->rides()) {
+    // add the stress scores, only offsets 1..n-1 are used below
+    foreach(RideItem *item, context->athlete->rideCache->ridesInRange(start_.addDays(qMax(1, from)), start_.addDays(stress_.count()-1))) {
 
         if (!specification_.pass(item)) continue;
+        included_.insert(item, item->dateTime.date());
 
         // seed with score for this one
         int offset = start_.daysTo(item->dateTime.date());
@@ -309,19 +363,21 @@ void PMCData::refresh()
 
     delete df;
 
-    calculateMetrics(days_, stress_, lts_, sts_, sb_, rr_);
-    calculateMetrics(days_, planned_stress_, planned_lts_, planned_sts_, planned_sb_, planned_rr_);
-    calculateMetrics(days_, expected_stress_, expected_lts_, expected_sts_, expected_sb_, expected_rr_);
+    calculateMetrics(from, days_, stress_, lts_, sts_, sb_, rr_);
+    calculateMetrics(from, days_, planned_stress_, planned_lts_, planned_sts_, planned_sb_, planned_rr_);
+    calculateMetrics(from, days_, expected_stress_, expected_lts_, expected_sts_, expected_sb_, expected_rr_);
 
-    //qDebug()<<"refresh PMC in="<<timer.elapsed()<<"ms";
+    //qDebug()<<"refresh PMC from day"<<from<<"of"<<days_<<"in="<<timer.elapsed()<<"ms";
 
     isstale=false;
+    stalefrom=QDate();
+    refreshDay=QDate::currentDate();
 }
 
 
 void
 PMCData::calculateMetrics
-(int days, const QVector<double> &stress, QVector<double> &lts, QVector<double> &sts, QVector<double> &sb, QVector<double> &rr) const
+(int from, int days, const QVector<double> &stress, QVector<double> &lts, QVector<double> &sts, QVector<double> &sb, QVector<double> &rr) const
 {
     const bool sbToday = appsettings->cvalue(context->athlete->cyclist, GC_SB_TODAY).toInt();
     const double lte = (double)exp(-1.0/ltsDays_);
@@ -329,9 +385,11 @@ PMCData::calculateMetrics
 
     double lastLTS=0.0f;
     double lastSTS=0.0f;
-    double rollingStress=0;
 
-    for(int day=0; day < days; day++) {
+    // the rolling stress for the day before we start
+    double rollingStress = from ? rr[from-1] : 0;
+
+    for(int day=from; day < days; day++) {
 
         // not seeded
         if (lts[day] >=0 || sts[day]>=0) {
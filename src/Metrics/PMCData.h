@@ -117,8 +117,11 @@ class PMCData : public QObject {
     public slots:
 
         // as underlying ride data changes the
-        // contents are invalidated and refreshed
+        // contents are invalidated and refreshed, from
+        // the day of the change when it is just rides
         void invalidate();
+        void invalidate(QDate from);
+        void invalidate(RideItem *item);
         void refresh();
 
     private:
@@ -144,8 +147,11 @@ class PMCData : public QObject {
         QVector<double> expected_stress_, expected_lts_, expected_sts_, expected_sb_, expected_rr_;
 
         bool isstale; // needs refreshing
+        QDate stalefrom; // earliest day changed, null for all of it
+        QDate refreshDay; // when last refreshed
+        QHash<RideItem*, QDate> included_; // day each ride's stress was added to
 
-        void calculateMetrics(int days, const QVector<double> &stress, QVector<double> &lts, QVector<double> &sts, QVector<double> &sb, QVector<double> &rr) const;
+        void calculateMetrics(int from, int days, const QVector<double> &stress, QVector<double> &lts, QVector<double> &sts, QVector<double> &sb, QVector<double> &rr) const;
 };
 
 #endif // _GC_StressCalculator_h
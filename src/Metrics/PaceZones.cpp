@@ -116,7 +116,7 @@ void PaceZones::initializeZoneParameters()
 }
 
 // read zone file, allowing for zones with or without end dates
-bool PaceZones::read(QFile &file)
+bool PaceZones::parse(QFile &file)
 {
     defaults_from_user = false;
     scheme.zone_default.clear();
@@ -515,19 +515,18 @@ next_line: {}
     return true;
 }
 
+bool PaceZones::read(QFile &file)
+{
+    bool returning = parse(file);
+    index.build(ranges);
+    return returning;
+}
+
 // note empty dates are treated as automatic matches for begin or
 // end of range
 int PaceZones::whichRange(const QDate &date) const
 {
-    for (int rnum = 0; rnum < ranges.size(); ++rnum) {
-
-        const PaceZoneRange &range = ranges[rnum];
-        if (((date >= range.begin) || (range.begin.isNull())) &&
-            ((date < range.end) || (range.end.isNull())))
-            return rnum;
-
-    }
-    return -1;
+    return index.whichRange(date);
 }
 
 int PaceZones::numZones(int rnum) const
@@ -539,20 +538,7 @@ int PaceZones::numZones(int rnum) const
 int PaceZones::whichZone(int rnum, double value) const
 {
     assert(rnum < ranges.size());
-    const PaceZoneRange &range = ranges[rnum];
-
-    for (int j = 0; j < range.zones.size(); ++j) {
-
-        const PaceZoneInfo &info = range.zones[j];
-
-        // note: the "end" of range is actually in the next zone
-        if ((value >= info.lo) && (value < info.hi))
-            return j;
-
-    }
-
-    // if we got here either it is negative, nan, inf or way high
-    return -1;
+    return index.whichZone(rnum, value);
 }
 
 void PaceZones::zoneInfo(int rnum, int znum, QString &name, QString &description, double &low, double &high) const
@@ -653,6 +639,7 @@ void PaceZones::setZonesFromCV(int rnum)
 {
     assert((rnum >= 0) && (rnum < ranges.size()));
     setZonesFromCV(ranges[rnum]);
+    index.build(ranges);
 }
 
 // return the list of starting values of zones for a given range
@@ -863,6 +850,7 @@ void PaceZones::write(QDir home)
 void PaceZones::addZoneRange(QDate _start, QDate _end, double _cv, double _aet)
 {
     ranges.append(PaceZoneRange(_start, _end, _cv, _aet));
+    index.build(ranges);
 }
 
 // insert a new zone range using the current scheme
@@ -887,24 +875,28 @@ int PaceZones::addZoneRange(QDate _start, double _cv, double _aet)
         setZonesFromCV(rnum);
     }
 
+    index.build(ranges);
     return rnum;
 }
 
 void PaceZones::addZoneRange()
 {
     ranges.append(PaceZoneRange(date_zero, date_infinity));
+    index.build(ranges);
 }
 
 void PaceZones::setEndDate(int rnum, QDate endDate)
 {
     ranges[rnum].end = endDate;
     modificationTime = QDateTime::currentDateTime();
+    index.build(ranges);
 }
 
 void PaceZones::setStartDate(int rnum, QDate startDate)
 {
     ranges[rnum].begin = startDate;
     modificationTime = QDateTime::currentDateTime();
+    index.build(ranges);
 }
 
 QDate PaceZones::getStartDate(int rnum) const
@@ -969,6 +961,7 @@ int PaceZones::deleteRange(int rnum) {
     // delete this range then
     ranges.removeAt(rnum);
 
+    index.build(ranges);
     return rnum-1;
 }
 
@@ -22,6 +22,7 @@
 #ifndef _PaceZones_h
 #define _PaceZones_h
 #include "GoldenCheetah.h"
+#include "ZoneIndex.h"
 #include "Context.h"
 #include "Athlete.h"
 
@@ -72,7 +73,7 @@ struct PaceZoneRange {
         begin(b), end(e), cv(_cv), aet(_aet), zonesSetFromCV(false) {}
 
     // used by std::sort
-    bool operator< (PaceZoneRange right) const {
+    bool operator< (const PaceZoneRange &right) const {
         return (((! right.begin.isNull()) &&
                 (begin.isNull() || begin < right.begin )) ||
                 ((begin == right.begin) && (! end.isNull()) &&
@@ -98,6 +99,8 @@ class PaceZones : public QObject
 
         // CV History
         QList<PaceZoneRange> ranges;
+        ZoneIndex index; // rebuilt whenever ranges change
+        bool parse(QFile &file);
 
         // utility
         QString err, warning, fileName_;
@@ -139,7 +142,7 @@ class PaceZones : public QObject
 
         // Get / Set ZoneRange details
         PaceZoneRange getZoneRange(int rnum) { return ranges[rnum]; }
-        void setZoneRange(int rnum, PaceZoneRange x) { ranges[rnum] = x; }
+        void setZoneRange(int rnum, PaceZoneRange x) { ranges[rnum] = x; index.build(ranges); }
 
         // get and set CV for a given range
         double getCV(int rnum) const;
@@ -177,6 +180,9 @@ class PaceZones : public QObject
         // will return -1 if not in any zone
         int whichZone(int range, double value) const;
 
+        // the lookup tables behind whichRange() and whichZone()
+        const ZoneIndex &zoneIndex() const { return index; }
+
         // how many zones are there for a given range
         int numZones(int range) const;
 
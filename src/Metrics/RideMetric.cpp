@@ -25,6 +25,8 @@
 #include "Zones.h"
 #include "HrZones.h"
 
+#include <QtConcurrent>
+
 // DB Schema Version - YOU MUST UPDATE THIS IF THE SCHEMA VERSION CHANGES!!!
 // Schema version will change if a) the default metadata.xml is updated
 //                            or b) new metrics are added / old changed
@@ -191,28 +193,43 @@ RideMetric::userMetricFingerprint(QList<UserMetricSettings> these)
     return qChecksum(fingers);
 }
 
+// metrics on the same dependency level are computed concurrently, but for
+// short rides and intervals the handoff to the thread pool costs more than
+// it saves, so we only bother when there are enough samples to go round
+static const int concurrentComputeSamples = 1800;
+
+static void
+computeMetric(RideMetric *m, RideItem *item, const Specification &spec, const QHash<QString,RideMetric*> &done)
+{
+    // accumulators have already seen the samples
+    if (m->isAccumulator()) static_cast<AccumulatingRideMetric*>(m)->finish(item, spec, done);
+    else m->compute(item, spec, done);
+
+    // override the computed value if set by user, but not for intervals
+    if (!spec.interval() && item->ride() && item->ride()->metricOverrides.contains(m->symbol()))
+        m->override(item->ride()->metricOverrides.value(m->symbol()));
+}
+
 QHash<QString,RideMetricPtr>
 RideMetric::computeMetrics(RideItem *item, Specification spec, const QStringList &metrics)
 {
     const RideMetricFactory &factory = RideMetricFactory::instance();
 
-    // generate worklist from metrics we know
-    // bear in mind this can change as users add
-    // and remove user metrics
-    // builtin User metrics are computed after builtins
-    // since they don't have explicit dependencies set, yet.
-    QStringList builtin;
-    QStringList user;
-    foreach(QString metric, metrics)
-        if (factory.haveMetric(metric)) {
-            if (factory.rideMetric(metric)->isUser())
-                user << metric;
-            else
-                builtin << metric;
-        }
+    // the dependency graph is compiled by the factory and only
+    // changes as users add and remove user metrics, their
+    // dependencies are the metrics their program reads, those
+    // that can't tell are deferred till after all the others
+    const MetricDependencyGraph graph = factory.dependencyGraph();
+
+    QVector<int> wanted;
+    wanted.reserve(metrics.count());
+    foreach(const QString &metric, metrics) {
+        int id = graph.id(metric);
+        if (id >= 0) wanted << id;
+    }
 
-    // this is what we've completed as we go
-    QHash<QString,RideMetric*> done;
+    // worklist for each level, dependencies included
+    const QVector<QVector<int> > worklist = graph.schedule(wanted);
 
     // resize the metric array in the interval if needed
     if (spec.interval() && spec.interval()->metrics().size() < factory.metricCount()) 
@@ -222,84 +239,114 @@ RideMetric::computeMetrics(RideItem *item, Specification spec, const QStringList
     if (!spec.interval() && item->metrics().size() < factory.metricCount())
         item->metrics().resize(factory.metricCount());
 
-    // working through the todo list...
-    while (!builtin.isEmpty() || !user.isEmpty()) {
+    // this is what we've completed as we go, indexed by metric
+    // and as a hash for compute() which looks up dependencies by
+    // symbol, only updated between levels so it can be shared
+    QVector<RideMetric*> done(graph.count(), NULL);
+    QHash<QString,RideMetric*> deps;
+
+    bool concurrent = !spec.interval() && item->ride() && item->ride()->dataPoints().count() >= concurrentComputeSamples;
+
+    // the item caches the weight when asked for it, so that is
+    // done before metrics ask for it alongside each other, the
+    // ride was loaded above (see RideMetric::isConcurrent)
+    if (concurrent) item->getWeight();
+
+    // we clone so we can remain thread safe
+    // do not be tempted to change this (!)
+    QVector<AccumulatingRideMetric*> accumulators;
+    bool user = false;
+    foreach(const QVector<int> &level, worklist) {
+        foreach(int id, level) {
+            RideMetric *m = factory.newMetric(id);
+            m->setValue(0.0);
+            m->setCount(0);
+            done[id] = m;
+            if (m->isUser()) user = true;
 
-        // next one to do, builtins first then user defined
-        QString symbol = builtin.isEmpty() ? user.takeFirst() :
-                                             builtin.takeFirst();
+            if (m->isAccumulator()) {
+                AccumulatingRideMetric *a = static_cast<AccumulatingRideMetric*>(m);
+                if (a->start(item, spec)) accumulators << a;
+            }
+        }
+    }
 
-        // doesn't exist !
-        if (!factory.haveMetric(symbol)) continue;
+    // one pass over the samples for all the accumulators
+    if (accumulators.count()) {
+        const int n = accumulators.count();
+        AccumulatingRideMetric **a = accumulators.data();
 
-        // does this one have any dependencies?
-        const QVector<QString> &deps = factory.dependencies(symbol);
+        RideFileIterator it(item->ride(), spec);
+        while (it.hasNext()) {
+            const RideFilePoint *point = it.next();
+            for (int i=0; i<n; i++) a[i]->accumulate(point);
+        }
+    }
 
-        bool ready = true;
+    // working through the levels...
+    foreach(const QVector<int> &level, worklist) {
 
-        // if the dependencies aren't done yet add to the end of the list
-        foreach (QString dep, deps) {
-            if (!done.contains(dep)) {
-                ready = false;
-                if (!builtin.contains(dep))
-                    builtin.append(dep);
-            }
+        QVector<RideMetric*> parallel, serial;
+        foreach(int id, level) {
+            RideMetric *m = done[id];
+            if (concurrent && m->isConcurrent() && !m->isAccumulator()) parallel << m;
+            else serial << m;
         }
 
-        // if all our depencies are computed we can do this one
-        if (ready) {
-
-            // we clone so we can remain thread safe
-            // do not be tempted to change this (!)
-            RideMetric *m = factory.newMetric(symbol);
-            m->setValue(0.0);
-            m->setCount(0);
-            m->compute(item, spec, done);
+        // independent of each other, so can run alongside each other
+        if (parallel.count() > 1) {
+            QtConcurrent::blockingMap(parallel, [item, &spec, &deps] (RideMetric *m) {
+                computeMetric(m, item, spec, deps);
+            });
+        } else serial = parallel + serial;
 
-            // override the computed value if set by user, but not for intervals
-            if (!spec.interval() && item->ride() && item->ride()->metricOverrides.contains(symbol))
-                m->override(item->ride()->metricOverrides.value(symbol));
+        foreach(RideMetric *m, serial) computeMetric(m, item, spec, deps);
 
-            // all computed add to the return list
-            done.insert(symbol, m);
+        // all computed, make available to the next level
+        foreach(int id, level) {
+            RideMetric *m = done[id];
+            deps.insert(m->symbol(), m);
 
             // put into value array too. user metrics will interrogate
             // this for symbol values, rather than the metric pointer
             // this is crucial, even though RideItem and IntervalItem both
             // update their values directly. But only need to bother if the
             // user has defined any local metrics.
-            if (user.count()) {
+            if (user) {
                 if (spec.interval()) spec.interval()->metrics()[m->index()] = m->value();
                 else item->metrics()[m->index()] = m->value();
             }
-
-        } else {
-
-            // we need to wait for our dependencies so add
-            // to the back of the list 
-            if (!builtin.contains(symbol))
-                builtin.append(symbol);
         }
     }
 
     // lets prepate the results using a shared pointer
     // which is deleted when reference count 0 and goes out of scope
     QHash<QString,RideMetricPtr> result;
-    foreach (QString symbol, metrics) {
-        if (factory.haveMetric(symbol)) {
-            result.insert(symbol, QSharedPointer<RideMetric>(done.value(symbol)));
-            done.remove(symbol);
+    foreach (int id, wanted) {
+        if (done[id]) {
+            result.insert(done[id]->symbol(), QSharedPointer<RideMetric>(done[id]));
+            done[id] = NULL;
         }
     }
 
     // delete the cloned metrics, no memory leak here :)
-    foreach (QString symbol, done.keys())
-        delete done.value(symbol);
+    foreach (RideMetric *m, done)
+        delete m;
 
     // and we're done
     return result;
 }
 
+void
+AccumulatingRideMetric::compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &deps)
+{
+    if (start(item, spec)) {
+        RideFileIterator it(item->ride(), spec);
+        while (it.hasNext()) accumulate(it.next());
+        finish(item, spec, deps);
+    }
+}
+
 double 
 RideMetric::getForSymbol(QString symbol, const QHash<QString,RideMetric*> *p)
 {
@@ -31,6 +31,7 @@
 
 #include "RideFile.h"
 #include "UserMetricSettings.h"
+#include "MetricDependencyGraph.h"
 
 class Zones;
 class HrZones;
@@ -40,6 +41,7 @@ class RideFile;
 class RideItem;
 class DataFilter;
 class DataFilterRuntime;
+class DataFilterProfile;
 class Leaf;
 
 // keep track of schema changes
@@ -165,6 +167,18 @@ public:
     // Compute the ride metric from a file.
     virtual void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &deps) = 0;
 
+    // can compute() run alongside the other metrics on the same dependency
+    // level? Only if it reads nothing the RideItem or RideFile builds or
+    // caches on first use, other than the ride itself and getWeight()
+    // which computeMetrics() resolves before the levels run. Metrics that
+    // do (e.g. wprimeData() or fileCache()) must say no and are computed
+    // serially. Zones, measures, metadata and xdata are only read.
+    virtual bool isConcurrent() const { return true; }
+
+    // does this metric take part in the fused pass over the samples?
+    // see AccumulatingRideMetric below
+    virtual bool isAccumulator() const { return false; }
+
     // is a time value, ie. render as hh:mm:ss
     virtual bool isTime() const { return false; }
 
@@ -257,6 +271,45 @@ public:
 };
 
 
+//
+// Fused single pass metrics
+//
+// Most metrics just need one pass over the samples, when they are
+// computed separately a ride is traversed dozens of times. Metrics
+// that derive from this class declare a per-sample accumulator and a
+// finalizer instead of implementing compute(); computeMetrics() feeds
+// the samples to all of them in a single sweep over the ride or
+// interval and calls finalize() once their dependencies are computed.
+//
+// begin() resets the accumulator and returns false when there is nothing
+// to accumulate (e.g. the data is not present), in which case it sets the
+// value itself and neither accumulate() nor finalize() are called.
+//
+class AccumulatingRideMetric : public RideMetric {
+
+public:
+
+    AccumulatingRideMetric() : active_(false) {}
+
+    bool isAccumulator() const { return true; }
+
+    virtual bool begin(RideItem *item, const Specification &spec) = 0;
+    virtual void accumulate(const RideFilePoint *point) = 0;
+    virtual void finalize(RideItem *item, const Specification &spec, const QHash<QString,RideMetric*> &deps) = 0;
+
+    // called by the engine
+    bool start(RideItem *item, const Specification &spec) { return (active_ = begin(item, spec)); }
+    void finish(RideItem *item, const Specification &spec, const QHash<QString,RideMetric*> &deps) {
+        if (active_) finalize(item, spec, deps);
+    }
+
+    // when computed on its own we run our own pass
+    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &deps);
+
+private:
+    bool active_;
+};
+
 //
 // The interface between a UserMetric and the codebase
 // for working with ride metrics.
@@ -317,6 +370,18 @@ public:
     // Compute the ride metric from a file.
     void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &deps);
 
+    // the program is shared by the clones but each has its own runtime, so
+    // unless it runs python or builtins that load or cache data in the ride
+    // or athlete it can be computed alongside other metrics
+    bool isConcurrent() const { return concurrent_; }
+
+    // the metrics it reads, false if there's no telling (it runs python)
+    // and it must be computed after all the others
+    bool dependencies(QVector<QString> &deps) const;
+
+    // record the calls made when computed, NULL to stop (see DataFilterProfile)
+    void setProfile(DataFilterProfile *profile);
+
     // is a time value, ie. render as hh:mm:ss
     bool isTime() const;
 
@@ -350,6 +415,9 @@ public:
         // true if we are a clone
         bool clone_;
 
+        // see isConcurrent()
+        bool concurrent_;
+
 };
 
 class RideMetricFactory {
@@ -364,10 +432,17 @@ private:
     QStringList metricNames;
     QVector<RideMetric::MetricType> metricTypes;
     QHash<QString,RideMetric*> metrics;
+    QVector<RideMetric*> metricList; // by index
     QHash<QString,QVector<QString>*> dependencyMap;
     bool dependenciesChecked;
 
-    RideMetricFactory() : dependenciesChecked(false) {}
+    // compiled from the dependencyMap when first needed
+    // and recompiled after metrics are added or removed
+    MetricDependencyGraph graph;
+    bool graphCompiled;
+    QMutex graphMutex;
+
+    RideMetricFactory() : dependenciesChecked(false), graphCompiled(false) {}
     RideMetricFactory(const RideMetricFactory &other);
     RideMetricFactory &operator=(const RideMetricFactory &other);
 
@@ -413,8 +488,33 @@ private:
         return metrics.value(symbol)->clone();
     }
 
+    RideMetric *newMetric(int index) const {
+        return metricList[index]->clone();
+    }
+
+    // the compiled dependency graph, the vectors in the
+    // graph are implicitly shared so returning a copy is cheap
+    MetricDependencyGraph dependencyGraph() const {
+        RideMetricFactory *self = const_cast<RideMetricFactory*>(this);
+        QMutexLocker locker(&self->graphMutex);
+        if (!graphCompiled) {
+            QVector<QVector<QString> > deps(metricNames.count());
+            QVector<bool> deferred(metricNames.count());
+            for (int i=0; i<metricNames.count(); i++) {
+                deps[i] = dependencies(metricNames[i]);
+                deferred[i] = metricList[i]->isUser() && !static_cast<UserMetric*>(metricList[i])->dependencies(deps[i]);
+            }
+            self->graph.compile(metricNames, deps, deferred);
+            self->graphCompiled = true;
+        }
+        return graph;
+    }
+
     // clear out user metrics, we're readding them
     void removeUserMetrics() {
+        // the graph is compiled from these, on whichever thread wants it
+        QMutexLocker locker(&graphMutex);
+
         int firstUser=-1;
         for(int i=0; i<metricNames.count(); i++) {
             RideMetric *m = metrics.value(metricNames[i], NULL);
@@ -433,18 +533,23 @@ private:
                 dependencyMap.remove(current);
                 metricNames.takeAt(firstUser);
                 metricTypes.remove(firstUser);
+                metricList.remove(firstUser);
             }
+            graphCompiled = false;
         }
     }
 
     bool addMetric(const RideMetric &metric,
                    const QVector<QString> *deps = NULL) {
+        QMutexLocker locker(&graphMutex);
         if(metrics.contains(metric.symbol())) return false;
         RideMetric *newMetric = metric.clone();
         newMetric->setIndex(metrics.count());
         metrics.insert(metric.symbol(), newMetric);
+        metricList.append(newMetric);
         metricNames.append(metric.symbol());
         metricTypes.append(metric.type());
+        graphCompiled = false;
         if (deps) {
             QVector<QString> *copy = new QVector<QString>;
             for (int i = 0; i < deps->size(); ++i)
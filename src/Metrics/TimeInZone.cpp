@@ -27,14 +27,19 @@
 #include <assert.h>
 #include <QApplication>
 
-class ZoneTime : public RideMetric {
+class ZoneTime : public AccumulatingRideMetric {
     Q_DECLARE_TR_FUNCTIONS(ZoneTime)
     int level;
     double seconds;
 
+    // set by begin() for the pass over the samples
+    const Zones *zones;
+    int range;
+    double secs, totalSecs;
+
     public:
 
-    ZoneTime() : level(0), seconds(0.0)
+    ZoneTime() : level(0), seconds(0.0), zones(NULL), range(-1), secs(0.0), totalSecs(0.0)
     {
         setType(RideMetric::Total);
         setMetricUnits(tr("seconds"));
@@ -46,7 +51,7 @@ class ZoneTime : public RideMetric {
     bool isTime() const { return true; }
     void setLevel(int level) { this->level=level-1; } // zones start from zero not 1
 
-    void compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &) {
+    bool begin(RideItem *item, const Specification &spec) {
 
         // no ride or no samples
         if (spec.isEmpty(item->ride()) ||
@@ -54,20 +59,24 @@ class ZoneTime : public RideMetric {
             !item->ride()->areDataPresent()->watts) {
             setValue(RideFile::NIL);
             setCount(0);
-            return;
+            return false;
         }
 
-        double totalSecs = 0.0;
+        zones = item->context->athlete->zones(item->sport);
+        range = item->zoneRange;
+        secs = item->ride()->recIntSecs();
+        totalSecs = 0.0;
         seconds = 0;
+        return true;
+    }
 
-        // iterate and compute
-        RideFileIterator it(item->ride(), spec);
-        while (it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            totalSecs += item->ride()->recIntSecs();
-            if (item->context->athlete->zones(item->sport)->whichZone(item->zoneRange, point->watts) == level)
-                seconds += item->ride()->recIntSecs();
-        }
+    void accumulate(const RideFilePoint *point) {
+        totalSecs += secs;
+        if (zones->whichZone(range, point->watts) == level)
+            seconds += secs;
+    }
+
+    void finalize(RideItem *, const Specification &, const QHash<QString,RideMetric*> &) {
         setValue(seconds);
         setCount(totalSecs);
     }
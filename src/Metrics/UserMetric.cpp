@@ -19,6 +19,112 @@
 #include "RideMetric.h"
 #include "UserMetricSettings.h"
 #include "DataFilter.h"
+#include "DataFilterBatch.h"
+
+#include <QSet>
+
+// builtins that only compute with their parameters and the symbols of the
+// runtime, the others may load or cache data in the ride item or athlete
+// (e.g. best(), xdata() or pmc()) which isn't safe while other metrics for
+// the same ride are being computed
+static const char *UserMetricConcurrentFunctions[] = {
+    "round", "sum", "mean", "max", "min", "count", "which", "c", "seq", "rep",
+    "length", "append", "remove", "mid", "argsort", "multisort", "head", "tail",
+    "sapply", "sqrt", "bool", "arguniq", "multiuniq", "variance", "stddev",
+    "cumsum", "match", "nonzero", "median", "mode", "quantile", "bin", "rev",
+    "rank", "sort", "uniq", "isNumber", "isString", "metadata", "tolower",
+    "toupper", "join", "split", "trim", "replace", "filename", "datestring",
+    "timestring", "string", "double", "normalize", "pdfnormal", "cdfnormal",
+    "pdfbeta", "cdfbeta", "pdfgamma", "cdfgamma",
+    NULL
+};
+
+static bool concurrent(DataFilterRuntime *rt, Leaf *leaf, QSet<Leaf*> &visited)
+{
+    static const QSet<QString> functions = [] () {
+        QSet<QString> returning;
+        for (int i=0; UserMetricConcurrentFunctions[i]; i++) returning.insert(UserMetricConcurrentFunctions[i]);
+        return returning;
+    } ();
+
+    if (leaf == NULL || visited.contains(leaf)) return true;
+    visited.insert(leaf);
+
+    switch(leaf->type) {
+
+    case Leaf::Float :
+    case Leaf::Integer :
+    case Leaf::String :
+        return true;
+
+    case Leaf::Symbol :
+        // the pmc is created on first use
+        return leaf->bound.kind != SymbolBinding::CTL && leaf->bound.kind != SymbolBinding::ATL &&
+               leaf->bound.kind != SymbolBinding::TSB;
+
+    case Leaf::Compound :
+        foreach(Leaf *p, *(leaf->lvalue.b)) if (!concurrent(rt, p, visited)) return false;
+        return true;
+
+    case Leaf::Operation:
+    case Leaf::BinaryOperation:
+    case Leaf::Logical :
+        return concurrent(rt, leaf->lvalue.l, visited) && (!leaf->op || concurrent(rt, leaf->rvalue.l, visited));
+
+    case Leaf::UnaryOperation:
+        return concurrent(rt, leaf->lvalue.l, visited);
+
+    case Leaf::Function:
+        if (rt->functions.contains(leaf->function)) {
+            if (!concurrent(rt, rt->functions.value(leaf->function), visited)) return false;
+        } else if (!Leaf::mathFunction(leaf) && !functions.contains(leaf->function)) return false;
+        foreach(Leaf* l, leaf->fparms) if (!concurrent(rt, l, visited)) return false;
+        return true;
+
+    case Leaf::Index:
+    case Leaf::Select:
+        if (!concurrent(rt, leaf->lvalue.l, visited)) return false;
+        foreach(Leaf* l, leaf->fparms) if (!concurrent(rt, l, visited)) return false;
+        return true;
+
+    case Leaf::Conditional:
+        return concurrent(rt, leaf->cond.l, visited) && concurrent(rt, leaf->lvalue.l, visited) &&
+               concurrent(rt, leaf->rvalue.l, visited);
+
+    default:
+        // python scripts and anything new
+        return false;
+    }
+}
+
+static bool scripted(Leaf *leaf)
+{
+    if (leaf == NULL) return false;
+
+    switch(leaf->type) {
+    case Leaf::Script :
+        return true;
+    case Leaf::Compound :
+        foreach(Leaf *p, *(leaf->lvalue.b)) if (scripted(p)) return true;
+        return false;
+    case Leaf::Operation:
+    case Leaf::BinaryOperation:
+    case Leaf::Logical :
+        return scripted(leaf->lvalue.l) || (leaf->op && scripted(leaf->rvalue.l));
+    case Leaf::UnaryOperation:
+        return scripted(leaf->lvalue.l);
+    case Leaf::Function:
+        foreach(Leaf* l, leaf->fparms) if (scripted(l)) return true;
+        return scripted(leaf->lvalue.l);
+    case Leaf::Index:
+    case Leaf::Select:
+        return scripted(leaf->lvalue.l) || scripted(leaf->fparms[0]);
+    case Leaf::Conditional:
+        return scripted(leaf->cond.l) || scripted(leaf->lvalue.l) || scripted(leaf->rvalue.l);
+    default:
+        return false;
+    }
+}
 
 UserMetric::UserMetric(Context *context, UserMetricSettings settings)
     : RideMetric(), settings(settings)
@@ -38,6 +144,10 @@ UserMetric::UserMetric(Context *context, UserMetricSettings settings)
     fvalue = rt->functions.contains("value") ? rt->functions.value("value") : NULL;
     fcount = rt->functions.contains("count") ? rt->functions.value("count") : NULL;
 
+    // compiled once, so worked out once
+    QSet<Leaf*> visited;
+    concurrent_ = root && concurrent(rt, root, visited);
+
     // we're not a clone, we're the original
     clone_ = false;
 }
@@ -59,6 +169,7 @@ UserMetric::UserMetric(const UserMetric *from) : RideMetric()
     this->fcount = from->fcount;
 
     this->index_ = from->index_;
+    this->concurrent_ = from->concurrent_;
 
     rt = new DataFilterRuntime;
 
@@ -192,6 +303,7 @@ UserMetric::isRelevantForRide(const RideItem *item) const
 {
     if (item->context && root) {
         if (frelevant) {
+            QReadLocker locker(&program->binding);
             Result res = root->eval(rt, frelevant, Result(0), 0, const_cast<RideItem*>(item), NULL, NULL);
             return res.number();
         } else
@@ -200,6 +312,38 @@ UserMetric::isRelevantForRide(const RideItem *item) const
     return false;
 }
 
+bool
+UserMetric::dependencies(QVector<QString> &deps) const
+{
+    if (!root) return true;
+
+    // python can read any of them
+    if (scripted(root)) return false;
+
+    QStringList symbols;
+    root->findSymbols(symbols);
+    foreach(const QString &name, symbols) {
+
+        QString metric;
+        SymbolBinding bound = SymbolBinding::resolve(rt, name);
+        if (bound.kind == SymbolBinding::Number && bound.metric >= 0) {
+            metric = bound.field;
+        } else if (bound.kind == SymbolBinding::Text && bound.field == "") {
+            // user metrics added after us aren't known when compiled
+            foreach(const UserMetricSettings &x, _userMetrics)
+                if (QString(x.name).replace(" ","_") == name) metric = x.symbol;
+        }
+        if (metric != "" && metric != symbol() && !deps.contains(metric)) deps << metric;
+    }
+    return true;
+}
+
+void
+UserMetric::setProfile(DataFilterProfile *profile)
+{
+    rt->profile = profile;
+}
+
 // Compute the ride metric from a file.
 void
 UserMetric::compute(RideItem *item, Specification spec, const QHash<QString,RideMetric*> &pc)
@@ -214,8 +358,12 @@ UserMetric::compute(RideItem *item, Specification spec, const QHash<QString,Ride
         return;
     }
 
-    // clear rt indexes
+    // the tree is shared with the other clones, see DataFilter::configChanged
+    QReadLocker locker(&program->binding);
+
+    // clear rt indexes and the values kept for the ride
     rt->indexes.clear();
+    rt->resetInvariants();
 
     // if there are no precomputed metrics then just use the values for the rideitem
     // this is a specific use case when testing a user metric in preferences
@@ -249,9 +397,12 @@ UserMetric::compute(RideItem *item, Specification spec, const QHash<QString,Ride
     if (!spec.isEmpty(item->ride()) && fsample) {
         RideFileIterator it(item->ride(), spec);
 
-        while(it.hasNext()) {
-            struct RideFilePoint *point = it.next();
-            root->eval(rt, fsample, Result(0), 0, const_cast<RideItem*>(item), point, c, spec);
+        // whole series at once if the sample function allows it
+        if (!fsample->batch || !fsample->batch->run(rt, const_cast<RideItem*>(item), it.firstIndex(), it.lastIndex(), c)) {
+            while(it.hasNext()) {
+                struct RideFilePoint *point = it.next();
+                root->eval(rt, fsample, Result(0), 0, const_cast<RideItem*>(item), point, c, spec);
+            }
         }
     }
 
@@ -96,6 +96,9 @@ class EditUserMetricDialog : public QDialog {
         // the current ride, time to compute all rides)
         void refreshStats();
         void okClicked();
+
+        // compute for the current ride and show where the time went
+        void profileProgram();
         void enableOk();
 
         void setErrors(QStringList&);
@@ -127,7 +130,7 @@ class EditUserMetricDialog : public QDialog {
 
         QLabel *mValue, *iValue, *elapsed;
 
-        QPushButton *test, *okButton, *cancelButton;
+        QPushButton *test, *profile, *okButton, *cancelButton;
 
 };
 #endif
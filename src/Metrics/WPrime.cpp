@@ -46,9 +46,14 @@
 // There may be room for improvement by adopting a different integration strategy
 // in the future, but now, a typical 4 hour hilly ride can be computed in 250ms on
 // and Athlon dual core CPU where previously it took 4000ms.
+//
+// The sum is now run as a recurrence by WPrimeBalance, decaying what has been
+// expended by exp(-1/TAU) each second, so it is a single pass without threads
+// and without the exp(t/TAU) terms that overflowed on very long rides.
 
 
 #include "WPrime.h"
+#include "WPrimeBalance.h"
 #include "RideItem.h"
 #include "Units.h" // for MILES_PER_KM
 #include "Settings.h" // for GC_WBALFORM
@@ -108,8 +113,6 @@ WPrime::check()
 void
 WPrime::setRide(RideFile *input)
 {
-    bool integral = (appsettings->value(NULL, GC_WBALFORM, "int").toString() == "int");
-
     QElapsedTimer time; // for profiling performance of the code
     time.start();
 
@@ -127,6 +130,7 @@ WPrime::setRide(RideFile *input)
     if (!input || input->dataPoints().count() < 2 || input->areDataPresent()->watts == false) {
         return;
     }
+    bool integral = input->context->athlete->settings()->value(SettingsSnapshot::WbalIntegral);
 
     // STEP 1: CONVERT POWER DATA TO A 1 SECOND TIME SERIES
     // create a raw time series in the format QwtSpline wants
@@ -235,23 +239,17 @@ WPrime::setRide(RideFile *input)
         xvalues.resize(last+1);
         xdvalues.resize(last+1);
 
-        QVector<double> myvalues(last+1);
+        WPrimeBalance wbal(WPrimeBalance::Integral);
+        wbal.add(CP, WPRIME, TAU);
 
-        WPrimeIntegrator a(powerValues, 0, last, TAU);
-
-        a.start();
-        a.wait();
-
-        // sum values
         for (int t=0; t<=last; t++) {
-            values[t] = a.output[t];
-            xvalues[t] = t / 60.00f;
-        }
 
-        // now subtract WPRIME and work out minimum etc
-        for(int t=0; t <= last; t++) {
-            double value = WPRIME - values[t];
+            // powerValues holds the watts above CP
+            wbal.step(CP + powerValues[t]);
+
+            double value = wbal.wbal();
             values[t] = value;
+            xvalues[t] = t / 60.00f;
             xdvalues[t] = distance.valueY(t);
 
             if (value > maxY) maxY = value;
@@ -269,15 +267,14 @@ WPrime::setRide(RideFile *input)
         xvalues.resize(last+1);
         xdvalues.resize(last+1);
 
-        double W = WPRIME;
+        WPrimeBalance wbal(WPrimeBalance::Differential);
+        wbal.add(CP, WPRIME, TAU);
+
         for (int t=0; t<=last; t++) {
             int smoothedValue = smoothed.valueY(t);
 
-            if (smoothedValue < CP) {
-                W  = W + (CP-smoothedValue)*(WPRIME-W)/WPRIME;
-            } else {
-                W  = W + (CP-smoothedValue);
-            }
+            wbal.step(smoothedValue);
+            double W = wbal.wbal();
 
             if (W > maxY) maxY = W;
             if (W < minY) minY = W;
@@ -377,7 +374,7 @@ WPrime::setRide(RideFile *input)
 void
 WPrime::setWatts(Context *context, QVector<int>&wattsArray, int CP, int WPRIME)
 {
-    bool integral = (appsettings->value(NULL, GC_WBALFORM, "int").toString() == "int");
+    bool integral = context->athlete->settings()->value(SettingsSnapshot::WbalIntegral);
 
     QElapsedTimer time; // for profiling performance of the code
     time.start();
@@ -407,29 +404,23 @@ WPrime::setWatts(Context *context, QVector<int>&wattsArray, int CP, int WPRIME)
             if (value >= CP) EXP += value; // total expenditure above CP
         }
 
-        TAU = appsettings->cvalue(context->athlete->cyclist, GC_WBALTAU, 300).toInt();
+        TAU = context->athlete->settings()->value(SettingsSnapshot::WbalTau);
 
         // lets run forward from 0s to end of ride
         values.resize(last+1);
         xvalues.resize(last+1);
 
-        QVector<double> myvalues(last+1);
+        WPrimeBalance wbal(WPrimeBalance::Integral);
+        wbal.add(CP, WPRIME, TAU);
 
-        WPrimeIntegrator a(powerValues, 0, last, TAU);
-
-        a.start();
-        a.wait();
-
-        // sum values
         for (int t=0; t<=last; t++) {
-            values[t] = a.output[t];
-            xvalues[t] = t * 1000.00f;
-        }
 
-        // now subtract WPRIME and work out minimum etc
-        for(int t=0; t <= last; t++) {
-            double value = WPRIME - values[t];
+            // powerValues holds the watts above CP
+            wbal.step(CP + powerValues[t]);
+
+            double value = wbal.wbal();
             values[t] = value;
+            xvalues[t] = t * 1000.00f;
 
             if (value > maxY) maxY = value;
             if (value < minY) minY = value;
@@ -444,17 +435,14 @@ WPrime::setWatts(Context *context, QVector<int>&wattsArray, int CP, int WPRIME)
 
         // input array contains the actual W' expenditure
         // and will also contain non-zero values
-        double W = WPRIME;
+        WPrimeBalance wbal(WPrimeBalance::Differential);
+        wbal.add(CP, WPRIME, TAU);
+
         for (int i=0; i<last; i++) {
 
             // get watts at point in time
-            int value = wattsArray[i];
-
-            if(value < CP) {
-                W  = W + (CP-value)*(WPRIME-W)/WPRIME;
-            } else {
-                W  = W + (CP-value);
-            }
+            wbal.step(wattsArray[i]);
+            double W = wbal.wbal();
 
             if (W > maxY) maxY = W;
             if (W < minY) minY = W;
@@ -471,7 +459,7 @@ WPrime::setWatts(Context *context, QVector<int>&wattsArray, int CP, int WPRIME)
 void
 WPrime::setErg(ErgFile *input)
 {
-    bool integral = (appsettings->value(NULL, GC_WBALFORM, "int").toString() == "int");
+    bool integral = input->context->athlete->settings()->value(SettingsSnapshot::WbalIntegral);
 
     QElapsedTimer time; // for profiling performance of the code
     time.start();
@@ -521,29 +509,23 @@ WPrime::setErg(ErgFile *input)
             if (value >= CP) EXP += value; // total expenditure above CP
         }
 
-        TAU = appsettings->cvalue(input->context->athlete->cyclist, GC_WBALTAU, 300).toInt();
+        TAU = input->context->athlete->settings()->value(SettingsSnapshot::WbalTau);
 
         // lets run forward from 0s to end of ride
         values.resize(last+1);
         xvalues.resize(last+1);
 
-        QVector<double> myvalues(last+1);
-
-        WPrimeIntegrator a(powerValues, 0, last, TAU);
+        WPrimeBalance wbal(WPrimeBalance::Integral);
+        wbal.add(CP, WPRIME, TAU);
 
-        a.start();
-        a.wait();
-
-        // sum values
         for (int t=0; t<=last; t++) {
-            values[t] = a.output[t];
-            xvalues[t] = t * 1000.00f;
-        }
 
-        // now subtract WPRIME and work out minimum etc
-        for(int t=0; t <= last; t++) {
-            double value = WPRIME - values[t];
+            // powerValues holds the watts above CP
+            wbal.step(CP + powerValues[t]);
+
+            double value = wbal.wbal();
             values[t] = value;
+            xvalues[t] = t * 1000.00f;
 
             if (value > maxY) maxY = value;
             if (value < minY) minY = value;
@@ -558,19 +540,15 @@ WPrime::setErg(ErgFile *input)
 
         // input array contains the actual W' expenditure
         // and will also contain non-zero values
-        double W = WPRIME;
+        WPrimeBalance wbal(WPrimeBalance::Differential);
+        wbal.add(CP, WPRIME, TAU);
         int lap; // passed by reference
 
         for (int i=0; i<last; i++) {
 
             // get watts at point in time
-            int value = ergFileQueryAdapter.wattsAt(i*1000, lap);
-
-            if(value < CP) {
-                W  = W + (CP-value)*(WPRIME-W)/WPRIME;
-            } else {
-                W  = W + (CP-value);
-            }
+            wbal.step(ergFileQueryAdapter.wattsAt(i*1000, lap));
+            double W = wbal.wbal();
 
             if (W > maxY) maxY = W;
             if (W < minY) minY = W;
@@ -593,10 +571,23 @@ WPrime::PCP()
     // if its way off don't even try!
     if (minY < -10000 || WPRIME < 10000) return PCP_ = 0; // Wprime not set properly
 
+    // try the candidates a few at a time, with a single pass
+    // over the ride for all of them
     int cp = CP;
     do {
-        if (minForCP(cp) > 0) return PCP_=cp;
-        else cp += 3; // +/- 3w is ok, especially since +/- 2kJ is typical accuracy for W' anyway
+        QVector<int> tried;
+        WPrimeBalance wbal(WPrimeBalance::Differential);
+        do {
+            wbal.add(cp, WPRIME, TAU);
+            tried << cp;
+            cp += 3; // +/- 3w is ok, especially since +/- 2kJ is typical accuracy for W' anyway
+        } while (cp <= 500 && tried.count() < 16);
+
+        for (int t=0; t<=last; t++) wbal.step(int(smoothed.valueY(t)));
+
+        for (int i=0; i<tried.count(); i++)
+            if (int(wbal.minimum(i)) > 0) return PCP_=tried[i];
+
     } while (cp <= 500);
 
     return PCP_=cp;
@@ -608,19 +599,11 @@ WPrime::minForCP(int cp)
     // STEP 2: ITERATE OVER DATA TO CREATE W' DATA SERIES
 
     // lets run forward from 0s to end of ride
-    int min = WPRIME;
-    double W = WPRIME;
-    for (int t=0; t<=last; t++) {
-        int smoothedValue = smoothed.valueY(t);
-        if(smoothedValue < cp) {
-            W  = W + (cp-smoothedValue)*(WPRIME-W)/WPRIME;
-        } else {
-            W  = W + (cp-smoothedValue);
-        }
+    WPrimeBalance wbal(WPrimeBalance::Differential);
+    wbal.add(cp, WPRIME, TAU);
+    for (int t=0; t<=last; t++) wbal.step(int(smoothed.valueY(t)));
 
-        if (W < min) min = W;
-    }
-    return min;
+    return int(wbal.minimum());
 }
 
 double
@@ -633,26 +616,6 @@ WPrime::maxMatch()
     return max;
 }
 
-
-// decay and integrate -- split into threads for best performance
-WPrimeIntegrator::WPrimeIntegrator(QVector<int> &source, int begin, int end, double TAU) :
-    source(source), begin(begin), end(end), TAU(TAU)
-{
-    output.resize(source.size());
-}
-
-void
-WPrimeIntegrator::run()
-{
-    // run from start to stop adding decay to end
-    double I = 0.00f;
-    for (int t=0; t<=end; t++) {
-
-        I += exp(((double)(t) / TAU)) * source[t];
-        output[t] = exp(-((double)(t) / TAU)) * I;
-    }
-}
-
 //
 // HTML zone summary
 //
@@ -760,6 +723,7 @@ class MinWPrime : public RideMetric {
     MetricClass classification() const { return Undefined; }
     MetricValidity validity() const { return Unknown; }
     RideMetric *clone() const { return new MinWPrime(*this); }
+    bool isConcurrent() const { return false; }
 };
 
 class MaxWPrime : public RideMetric {
@@ -792,6 +756,7 @@ class MaxWPrime : public RideMetric {
     MetricClass classification() const { return Undefined; }
     MetricValidity validity() const { return Unknown; }
     RideMetric *clone() const { return new MaxWPrime(*this); }
+    bool isConcurrent() const { return false; }
 };
 
 class MaxMatch : public RideMetric {
@@ -824,6 +789,7 @@ class MaxMatch : public RideMetric {
     MetricClass classification() const { return Undefined; }
     MetricValidity validity() const { return Unknown; }
     RideMetric *clone() const { return new MaxMatch(*this); }
+    bool isConcurrent() const { return false; }
 };
 
 class Matches : public RideMetric {
@@ -858,6 +824,7 @@ class Matches : public RideMetric {
     MetricClass classification() const { return Undefined; }
     MetricValidity validity() const { return Unknown; }
     RideMetric *clone() const { return new Matches(*this); }
+    bool isConcurrent() const { return false; }
 };
 
 class WPrimeTau : public RideMetric {
@@ -892,6 +859,7 @@ class WPrimeTau : public RideMetric {
     MetricClass classification() const { return Undefined; }
     MetricValidity validity() const { return Unknown; }
     RideMetric *clone() const { return new WPrimeTau(*this); }
+    bool isConcurrent() const { return false; }
 };
 
 class WPrimeExp : public RideMetric {
@@ -1092,6 +1060,7 @@ class WZoneTime : public RideMetric {
     MetricClass classification() const { return Undefined; }
     MetricValidity validity() const { return Unknown; }
     RideMetric *clone() const { return new WZoneTime(*this); }
+    bool isConcurrent() const { return false; }
 };
 
 class WZoneTime1 : public WZoneTime {
@@ -1242,6 +1211,7 @@ class WCPZoneTime : public RideMetric {
     MetricClass classification() const { return Undefined; }
     MetricValidity validity() const { return Unknown; }
     RideMetric *clone() const { return new WCPZoneTime(*this); }
+    bool isConcurrent() const { return false; }
 };
 
 class WCPZoneTime1 : public WCPZoneTime {
@@ -1383,6 +1353,7 @@ class WZoneWork : public RideMetric {
     MetricClass classification() const { return Undefined; }
     MetricValidity validity() const { return Unknown; }
     RideMetric *clone() const { return new WZoneWork(*this); }
+    bool isConcurrent() const { return false; }
 };
 
 class WZoneWork1 : public WZoneWork {
@@ -102,22 +102,4 @@ class WPrime {
         void check(); // check we don't need to recompute
         bool wasIntegral;
 };
-
-class WPrimeIntegrator : public QThread
-{
-    public:
-        WPrimeIntegrator(QVector<int> &source, int begin, int end, double TAU);
-
-        // integrate from start to stop from source into output
-        // basically sums in the exponential decays, but we break it
-        // into threads to parallelise the work
-        void run();
-
-        QVector<int> &source;
-        int begin, end;
-        double TAU;
-
-        // resized to match source holds results
-        QVector<double> output;
-};
 #endif
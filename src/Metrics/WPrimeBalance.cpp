@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2026 The GoldenCheetah Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "WPrimeBalance.h"
+
+#include <cmath>
+
+int
+WPrimeBalance::add(double CP, double WPRIME, double TAU, double R)
+{
+    cp << CP;
+    wprime << WPRIME;
+    tau << TAU;
+    rate << R;
+    spent << 0;
+    lowest << WPRIME;
+    decay << (secs ? exp(-secs / TAU) : 1);
+    return cp.count() - 1;
+}
+
+void
+WPrimeBalance::reset()
+{
+    spent.fill(0);
+    lowest = wprime;
+}
+
+void
+WPrimeBalance::step(double watts, double secs)
+{
+    const int n = cp.count();
+
+    // raw pointers so the loops below don't check for sharing
+    const double *cp = this->cp.constData();
+    const double *wprime = this->wprime.constData();
+    const double *rate = this->rate.constData();
+    double *spent = this->spent.data();
+    double *lowest = this->lowest.data();
+
+    if (f == Integral) {
+
+        // the decay only changes with the step length, which is
+        // almost always the same from one step to the next
+        if (secs != this->secs) {
+            this->secs = secs;
+            for (int i=0; i<n; i++) decay[i] = exp(-secs / tau[i]);
+        }
+        const double *decay = this->decay.constData();
+
+        for (int i=0; i<n; i++) {
+            double above = watts - cp[i];
+            spent[i] = spent[i] * decay[i] + (above > 0 ? above * secs : 0);
+            double wbal = wprime[i] - spent[i];
+            lowest[i] = wbal < lowest[i] ? wbal : lowest[i];
+        }
+
+    } else {
+
+        // recovery in proportion to the W' expended below CP
+        for (int i=0; i<n; i++) {
+            double below = cp[i] - watts;
+            spent[i] = below > 0 ? spent[i] * (1 - rate[i] * below * secs / wprime[i]) : spent[i] - below * secs;
+            double wbal = wprime[i] - spent[i];
+            lowest[i] = wbal < lowest[i] ? wbal : lowest[i];
+        }
+    }
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2026 The GoldenCheetah Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_WPrimeBalance_h
+#define _GC_WPrimeBalance_h 1
+
+#include <QVector>
+
+//
+// W'bal a sample at a time, for one or more sets of CP, W' and TAU.
+//
+// The integral formulation (Skiba et al) is run as a recurrence: the
+// W' expended and not yet recovered decays by exp(-secs/TAU) each step
+// before the W' expended above CP is added. It is the same sum as
+// exp(-t/TAU) * sum(exp(s/TAU) * expended) without the exponentials
+// that overflow once a ride is longer than about 700 TAU, and a sample
+// costs the same at any point of the ride so it can run live in Train
+// mode. The differential formulation (Froncioni / Clarke) is a
+// recurrence already, R scales its recovery and is 1 other than when
+// solving for it.
+//
+// Parameter sets are held as arrays and a step is a single pass over
+// them that the compiler can vectorise, to try many of them against
+// the same ride in one pass over it.
+//
+class WPrimeBalance
+{
+    public:
+
+        enum formula { Integral, Differential };
+
+        WPrimeBalance(formula f = Integral) : f(f), secs(0) {}
+
+        // add a set of parameters fully charged, returns its index
+        int add(double CP, double WPRIME, double TAU, double R = 1);
+        int count() const { return cp.count(); }
+
+        // back to fully charged
+        void reset();
+
+        // the next secs seconds at watts
+        void step(double watts, double secs = 1.0);
+
+        // W' remaining, expended and not yet recovered, lowest so far
+        double wbal(int i = 0) const { return wprime[i] - spent[i]; }
+        double expended(int i = 0) const { return spent[i]; }
+        double minimum(int i = 0) const { return lowest[i]; }
+
+    private:
+
+        formula f;
+        QVector<double> cp, wprime, tau, rate;
+        QVector<double> spent, lowest;
+        QVector<double> decay;          // exp(-secs/TAU) for the last step length
+        double secs;
+};
+
+#endif // _GC_WPrimeBalance_h
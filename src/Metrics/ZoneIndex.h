@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2026 The GoldenCheetah Authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_ZoneIndex_h
+#define _GC_ZoneIndex_h 1
+
+#include <QDate>
+#include <QList>
+#include <QVector>
+#include <algorithm>
+
+//
+// Lookup tables for a zone configuration (power, hr or pace) so that
+// finding the range for a date and the zone for a value are binary
+// searches rather than scans. They are called per ride during refresh
+// and per sample by the time in zone metrics and charts.
+//
+// The index must be rebuilt whenever the ranges or their zones change,
+// the zone classes do this in every method that changes them. It is
+// read only once built so is safe to use from the refresh threads.
+//
+class ZoneIndex
+{
+    public:
+
+        ZoneIndex() : rangeAt(1, -1) {}
+
+        // R is one of ZoneRange, HrZoneRange or PaceZoneRange
+        template<class R> void build(const QList<R> &ranges);
+
+        // same results as scanning the ranges and zones in order
+        int whichRange(const QDate &date) const {
+            int i = std::upper_bound(boundary.constBegin(), boundary.constEnd(), date.toJulianDay()) - boundary.constBegin();
+            return rangeAt[i];
+        }
+
+        int whichZone(int range, double value) const {
+            const QVector<double> &lo = lows[range], &hi = highs[range];
+            if (ordered[range]) {
+                // last zone starting at or below value
+                int j = int(std::upper_bound(lo.constBegin(), lo.constEnd(), value) - lo.constBegin()) - 1;
+                return (j >= 0 && value < hi[j]) ? j : -1;
+            }
+            for (int j=0; j<lo.count(); j++)
+                if (value >= lo[j] && value < hi[j]) return j;
+            return -1;
+        }
+
+        // zone boundaries for a range, for kernels that bin whole series
+        const QVector<double> &zoneLows(int range) const { return lows[range]; }
+        const QVector<double> &zoneHighs(int range) const { return highs[range]; }
+
+    private:
+
+        // the range in force changes only at a begin or end date,
+        // rangeAt[i] applies from boundary[i-1] up to boundary[i]
+        QVector<qint64> boundary;
+        QVector<int> rangeAt;
+
+        // zone lo/hi per range, ordered when they are ascending and
+        // don't overlap so a binary search finds the same zone
+        QVector<QVector<double> > lows, highs;
+        QVector<bool> ordered;
+};
+
+template<class R> void
+ZoneIndex::build(const QList<R> &ranges)
+{
+    // the original scan, used to fill the table
+    auto scan = [&ranges](const QDate &date) {
+        for (int rnum = 0; rnum < ranges.size(); ++rnum) {
+            const R &range = ranges[rnum];
+            if (((date >= range.begin) || (range.begin.isNull())) &&
+                ((date < range.end) || (range.end.isNull())))
+                return rnum;
+        }
+        return -1;
+    };
+
+    boundary.clear();
+    foreach(const R &range, ranges) {
+        if (!range.begin.isNull()) boundary << range.begin.toJulianDay();
+        if (!range.end.isNull()) boundary << range.end.toJulianDay();
+    }
+    std::sort(boundary.begin(), boundary.end());
+    boundary.erase(std::unique(boundary.begin(), boundary.end()), boundary.end());
+
+    rangeAt.resize(boundary.count() + 1);
+    rangeAt[0] = scan(QDate());
+    for (int i=0; i<boundary.count(); i++) rangeAt[i+1] = scan(QDate::fromJulianDay(boundary[i]));
+
+    lows.resize(ranges.count());
+    highs.resize(ranges.count());
+    ordered.resize(ranges.count());
+    for (int rnum = 0; rnum < ranges.count(); rnum++) {
+        QVector<double> &lo = lows[rnum], &hi = highs[rnum];
+        lo.clear();
+        hi.clear();
+        bool isordered = true;
+        for (int j = 0; j < ranges[rnum].zones.count(); j++) {
+            lo << ranges[rnum].zones[j].lo;
+            hi << ranges[rnum].zones[j].hi;
+            if (j && (lo[j] < lo[j-1] || hi[j-1] > lo[j])) isordered = false;
+        }
+        ordered[rnum] = isordered;
+    }
+}
+
+#endif // _GC_ZoneIndex_h
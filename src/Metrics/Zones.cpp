@@ -74,7 +74,7 @@ void Zones::initializeZoneParameters()
 }
 
 // read zone file, allowing for zones with or without end dates
-bool Zones::read(QFile &file)
+bool Zones::parse(QFile &file)
 {
     defaults_from_user = false;
     scheme.zone_default.clear();
@@ -524,19 +524,18 @@ next_line: {}
     return true;
 }
 
+bool Zones::read(QFile &file)
+{
+    bool returning = parse(file);
+    index.build(ranges);
+    return returning;
+}
+
 // note empty dates are treated as automatic matches for begin or
 // end of range
 int Zones::whichRange(const QDate &date) const
 {
-    for (int rnum = 0; rnum < ranges.size(); ++rnum) {
-
-        const ZoneRange &range = ranges[rnum];
-        if (((date >= range.begin) || (range.begin.isNull())) &&
-            ((date < range.end) || (range.end.isNull())))
-            return rnum;
-
-    }
-    return -1;
+    return index.whichRange(date);
 }
 
 int Zones::numZones(int rnum) const
@@ -548,20 +547,7 @@ int Zones::numZones(int rnum) const
 int Zones::whichZone(int rnum, double value) const
 {
     assert(rnum < ranges.size());
-    const ZoneRange &range = ranges[rnum];
-
-    for (int j = 0; j < range.zones.size(); ++j) {
-
-        const ZoneInfo &info = range.zones[j];
-
-        // note: the "end" of range is actually in the next zone
-        if ((value >= info.lo) && (value < info.hi))
-            return j;
-
-    }
-
-    // if we got here either it is negative, nan, inf or way high
-    return -1;
+    return index.whichZone(rnum, value);
 }
 
 void Zones::zoneInfo(int rnum, int znum, QString &name, QString &description, int &low, int &high) const
@@ -697,6 +683,7 @@ void Zones::setZonesFromCP(int rnum)
 {
     assert((rnum >= 0) && (rnum < ranges.size()));
     setZonesFromCP(ranges[rnum]);
+    index.build(ranges);
 }
 
 // return the list of starting values of zones for a given range
@@ -921,6 +908,7 @@ void Zones::write(QDir home)
 void Zones::addZoneRange(QDate _start, QDate _end, int _cp, int _aet, int _ftp, int _wprime, int _pmax)
 {
     ranges.append(ZoneRange(_start, _end, _cp, _aet, _ftp, _wprime, _pmax));
+    index.build(ranges);
 }
 
 // insert a new zone range using the current scheme
@@ -946,24 +934,28 @@ int Zones::addZoneRange(QDate _start, int _cp, int _aet, int _ftp, int _wprime,
         setZonesFromCP(rnum);
     }
 
+    index.build(ranges);
     return rnum;
 }
 
 void Zones::addZoneRange()
 {
     ranges.append(ZoneRange(date_zero, date_infinity));
+    index.build(ranges);
 }
 
 void Zones::setEndDate(int rnum, QDate endDate)
 {
     ranges[rnum].end = endDate;
     modificationTime = QDateTime::currentDateTime();
+    index.build(ranges);
 }
 
 void Zones::setStartDate(int rnum, QDate startDate)
 {
     ranges[rnum].begin = startDate;
     modificationTime = QDateTime::currentDateTime();
+    index.build(ranges);
 }
 
 QDate Zones::getStartDate(int rnum) const
@@ -1028,6 +1020,7 @@ int Zones::deleteRange(int rnum) {
     // delete this range then
     ranges.removeAt(rnum);
 
+    index.build(ranges);
     return rnum-1;
 }
 
@@ -19,6 +19,7 @@
 #ifndef _Zones_h
 #define _Zones_h
 #include "GoldenCheetah.h"
+#include "ZoneIndex.h"
 #include "Athlete.h"
 
 #include <QtCore>
@@ -71,7 +72,7 @@ struct ZoneRange {
         begin(b), end(e), cp(_cp), aet(_aet), ftp(_ftp), wprime(_wprime), pmax(pmax), zonesSetFromCP(false) {}
 
     // used by std::sort
-    bool operator< (ZoneRange right) const {
+    bool operator< (const ZoneRange &right) const {
         return (((! right.begin.isNull()) &&
                 (begin.isNull() || begin < right.begin )) ||
                 ((begin == right.begin) && (! end.isNull()) &&
@@ -97,6 +98,8 @@ class Zones : public QObject
 
         // CP History
         QList<ZoneRange> ranges;
+        ZoneIndex index; // rebuilt whenever ranges change
+        bool parse(QFile &file);
 
         // utility
         QString err, warning, fileName_;
@@ -138,7 +141,7 @@ class Zones : public QObject
 
         // Get / Set ZoneRange details
         ZoneRange getZoneRange(int rnum) { return ranges[rnum]; }
-        void setZoneRange(int rnum, ZoneRange x) { ranges[rnum] = x; }
+        void setZoneRange(int rnum, ZoneRange x) { ranges[rnum] = x; index.build(ranges); }
 
         // get and set CP for a given range
         int getCP(int rnum) const;
@@ -180,6 +183,9 @@ class Zones : public QObject
         // will return -1 if not in any zone
         int whichZone(int range, double value) const;
 
+        // the lookup tables behind whichRange() and whichZone()
+        const ZoneIndex &zoneIndex() const { return index; }
+
         // how many zones are there for a given range
         int numZones(int range) const;
 
@@ -395,7 +395,6 @@ TrainSidebar::TrainSidebar(Context *context) : GcWindow(context), context(contex
     hrcount = 0;
     spdcount = 0;
     lodcount = 0;
-    wbalr = wbal = 0;
     load_msecs = total_msecs = lap_msecs = 0;
     displayWorkoutDistance = displayDistance = displayPower = displayHeartRate =
     displaySpeed = displayCadence = slope = load = 0;
@@ -1416,8 +1415,7 @@ void TrainSidebar::Start()       // when start button is pressed
         session_elapsed_msec = 0;
         lap_time.start();
         lap_elapsed_msec = 0;
-        wbalr = 0;
-        wbal = WPRIME;
+        wbal = WPrimeBalance(); // parameters as they are when started
         
         resetTextAudioEmitTracking();
 
@@ -1669,8 +1667,7 @@ void TrainSidebar::Stop(int deviceStatus)        // when stop button is pressed
     lodcount = 0;
     displayTemp = 0;
     displayWorkoutLap = 0;
-    wbalr = 0;
-    wbal = WPRIME;
+    wbal = WPrimeBalance(); // parameters as they are when started
     session_elapsed_msec = 0;
     session_time.restart();
     lap_elapsed_msec = 0;
@@ -2179,18 +2176,16 @@ void TrainSidebar::guiUpdate()           // refreshes the telemetry
             rtData.setVirtualSpeed(vs);
 
             // W'bal on the fly
-            // using Dave Waterworth's reformulation
-            double TAU = appsettings->cvalue(context->athlete->cyclist, GC_WBALTAU, 300).toInt();
-
-            // any watts expended in last 200msec?
-            double JOULES = double(rtData.getWatts() - FTP) / 5.00f;
-            if (JOULES < 0) JOULES = 0;
+            // using Dave Waterworth's reformulation, a step at a time
+            if (wbal.count() == 0) {
+                double TAU = appsettings->cvalue(context->athlete->cyclist, GC_WBALTAU, 300).toInt();
+                wbal.add(FTP, WPRIME, TAU);
+            }
 
-            // running total of replenishment
-            wbalr += JOULES * exp((total_msecs/1000.00f) / TAU);
-            wbal = WPRIME - (wbalr * exp((-total_msecs/1000.00f) / TAU));
+            // watts for the last 200msec
+            wbal.step(rtData.getWatts(), REFRESHRATE / 1000.00f);
 
-            rtData.setWbal(wbal);
+            rtData.setWbal(wbal.wbal());
 
             // go update the displays...
             context->notifyTelemetryUpdate(rtData); // signal everyone to update telemetry
@@ -32,6 +32,7 @@
 #include "RemoteControl.h"
 #include "AthleteTab.h"
 #include "PhysicsUtility.h"
+#include "WPrimeBalance.h"
 #include "MultiFilterProxyModel.h"
 #include "InfoWidget.h"
 
@@ -337,7 +338,7 @@ class TrainSidebar : public GcWindow
         QCheckBox   *recordSelector;
         QSharedPointer<QFileSystemWatcher> watcher;
         bool calibrating;
-        double wbalr, wbal;
+        WPrimeBalance wbal;
 };
 
 class MultiDeviceDialog : public QDialog
@@ -0,0 +1,53 @@
+# The DataFilter objects the tests exercise are listed in GC_OBJS, so a
+# test fails to link if one of them goes missing rather than silently
+# leaving it out. DataFilter reaches most of the rest of the application
+# (metrics, models, the ride cache, charts through UserChart and so on),
+# so everything else src was built from, other than main, is linked too
+# with the libraries src links. Include instead of unittests.pri.
+#
+# Optional dependencies enabled in gcconfig.pri (python, R, vlc, ical ..)
+# need their LIBS adding as src.pro does.
+
+GC_OBJS += DataFilter \
+           DataFilter_yacc \
+           DataFilter_lex \
+           moc_DataFilter \
+           DataFilterProgram \
+           DataFilterBatch \
+           DataFilterOptimizer \
+           DataFilterProfile \
+           DataFilterMemo \
+           moc_DataFilterMemo \
+           UserMetric \
+           Specification
+
+include($$PWD/../unittests.pri)
+
+QT += xml sql network svg widgets concurrent serialport multimedia multimediawidgets \
+      webenginecore webenginewidgets webchannel positioning webenginequick core5compat \
+      bluetooth charts opengl
+CONFIG += c++17
+
+INCLUDEPATH += $$PWD/../../src/ANT $$PWD/../../src/Train $$PWD/../../src/FileIO \
+               $$PWD/../../src/Cloud $$PWD/../../src/Charts $$PWD/../../src/Metrics \
+               $$PWD/../../src/Gui $$PWD/../../src/Core $$PWD/../../src/Planning \
+               $$PWD/../../qwt/src \
+               $$PWD/../../contrib/qxt/src \
+               $$PWD/../../contrib/qtsolutions/json \
+               $$PWD/../../contrib/qtsolutions/qwtcurve \
+               $$PWD/../../contrib/lmfit
+DEFINES += QXT_STATIC
+
+# the rest, expanded by make when linking, main is replaced by dataFilterFixture.cpp
+for(obj, GC_OBJS) {
+    GC_LINKED += %/$${obj}.$${PLATFORM_EXT}
+}
+LIBS += $(filter-out %/main.$${PLATFORM_EXT} $${GC_LINKED},$(wildcard $${GC_OBJECTS_DIR}/*.$${PLATFORM_EXT}))
+LIBS += -L$$PWD/../../qwt/lib -lqwt
+
+INCLUDEPATH += $${LIBZ_INCLUDE} $${GSL_INCLUDES}
+LIBS += $${LIBZ_LIBS} $${GSL_LIBS}
+unix:LIBS += -lm
+
+HEADERS += $$PWD/dataFilterFixture.h
+SOURCES += $$PWD/dataFilterFixture.cpp
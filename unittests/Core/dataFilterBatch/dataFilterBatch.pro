@@ -0,0 +1,5 @@
+QT += testlib core
+
+SOURCES = testDataFilterBatch.cpp
+
+include(../dataFilter.pri)
@@ -0,0 +1,137 @@
+#include "Core/DataFilter.h"
+#include "Core/DataFilterBatch.h"
+#include "Core/RideItem.h"
+#include "Core/Specification.h"
+#include "FileIO/RideFile.h"
+#include "../dataFilterFixture.h"
+
+#include <QTest>
+
+
+class TestDataFilterBatch: public QObject
+{
+    Q_OBJECT
+
+    QVector<RideItem*> rides;
+
+    // the symbols after init(), as user charts and metrics start
+    static DataFilterSymbols initial(DataFilter &filter, RideItem *item) {
+        Leaf *init = filter.rt.functions.value("init");
+        if (init) filter.root()->eval(&filter.rt, init, Result(0), 0, item);
+        return filter.rt.symbols;
+    }
+
+    // calling sample() for every sample
+    static void perSample(DataFilter &filter, RideItem *item) {
+        Leaf *sample = filter.rt.functions.value("sample");
+        RideFileIterator it(item->ride(), Specification());
+        filter.rt.resetInvariants(item);
+        while (it.hasNext()) filter.root()->eval(&filter.rt, sample, Result(0), 0, item, it.next());
+    }
+
+    static bool batch(DataFilter &filter, RideItem *item) {
+        Leaf *sample = filter.rt.functions.value("sample");
+        RideFileIterator it(item->ride(), Specification());
+        filter.rt.resetInvariants(item);
+        return sample->batch->run(&filter.rt, item, it.firstIndex(), it.lastIndex(), NULL);
+    }
+
+private slots:
+
+    void initTestCase() {
+        rides = DataFilterFixture::activities(4, true);
+    }
+
+    void cleanupTestCase() {
+        qDeleteAll(rides);
+        rides.clear();
+    }
+
+    void sameAsPerSample_data() {
+        QTest::addColumn<QString>("script");
+
+        QTest::newRow("append and accumulate") << "{ sample { append(a, POWER * 2 + (HEARTRATE > 100)); total <- total + sqrt(CADENCE); append(b, INDEX); } }";
+        QTest::newRow("conditional") << "{ init { n <- 5; } sample { append(v, CADENCE > 80 ? POWER / n : -SPEED); SECS; } }";
+        QTest::newRow("invariant") << "{ sample { total <- total + POWER * sqrt(Duration); } }";
+        QTest::newRow("logical") << "{ sample { total <- total + (POWER > 200 && CADENCE > 0 || HEARTRATE < 100); } }";
+    }
+
+    void sameAsPerSample() {
+        QFETCH(QString, script);
+
+        DataFilter filter(NULL, DataFilterFixture::context(), script);
+        QVERIFY2(filter.root(), qPrintable(filter.getErrors().join(" ")));
+        QVERIFY(filter.rt.functions.value("sample"));
+        QVERIFY(filter.rt.functions.value("sample")->batch);
+
+        DataFilterSymbols pristine = filter.rt.symbols;
+        foreach(RideItem *item, rides) {
+            filter.rt.symbols = pristine;
+            DataFilterSymbols start = initial(filter, item);
+
+            perSample(filter, item);
+            DataFilterSymbols expected = filter.rt.symbols;
+
+            filter.rt.symbols = start;
+            QVERIFY(batch(filter, item));
+            QVERIFY2(DataFilterFixture::same(expected, filter.rt.symbols), qPrintable(item->fileName));
+        }
+    }
+
+    // anything other than the common idioms is run sample by sample
+    void notBatched_data() {
+        QTest::addColumn<QString>("script");
+
+        QTest::newRow("assignment") << "{ sample { a <- POWER; } }";
+        QTest::newRow("depends on the loop") << "{ sample { total <- total + n; n <- n + 1; } }";
+        QTest::newRow("same symbol twice") << "{ sample { append(v, POWER); append(v, CADENCE); } }";
+        QTest::newRow("other functions") << "{ sample { append(v, c(POWER, CADENCE)); } }";
+        QTest::newRow("assign a series") << "{ sample { POWER <- POWER + 1; } }";
+        QTest::newRow("loop") << "{ sample { while (n < 3) { n <- n + 1; } total <- total + POWER; } }";
+    }
+
+    void notBatched() {
+        QFETCH(QString, script);
+
+        DataFilter filter(NULL, DataFilterFixture::context(), script);
+        QVERIFY2(filter.root(), qPrintable(filter.getErrors().join(" ")));
+        QVERIFY(filter.rt.functions.value("sample"));
+        QVERIFY(filter.rt.functions.value("sample")->batch == NULL);
+    }
+
+    // symbols that aren't plain numbers are left for the caller
+    void notNumbers() {
+        DataFilter filter(NULL, DataFilterFixture::context(), "{ init { total <- \"text\"; } sample { total <- total + POWER; } }");
+        QVERIFY(filter.root());
+        QVERIFY(filter.rt.functions.value("sample")->batch);
+
+        DataFilterSymbols start = initial(filter, rides[0]);
+        QVERIFY(!batch(filter, rides[0]));
+        QVERIFY(DataFilterFixture::same(start, filter.rt.symbols));
+    }
+
+    void benchmark_data() {
+        QTest::addColumn<bool>("whole");
+
+        QTest::newRow("per sample") << false;
+        QTest::newRow("whole series") << true;
+    }
+
+    void benchmark() {
+        QFETCH(bool, whole);
+
+        DataFilter filter(NULL, DataFilterFixture::context(), "{ sample { append(a, POWER * 2 + (HEARTRATE > 100)); total <- total + sqrt(CADENCE); } }");
+        QVERIFY(filter.root());
+        DataFilterSymbols pristine = filter.rt.symbols;
+
+        QBENCHMARK {
+            filter.rt.symbols = pristine;
+            if (whole) batch(filter, rides[0]);
+            else perSample(filter, rides[0]);
+        }
+        QVERIFY(filter.rt.symbols.value("total").number() > 0);
+    }
+};
+
+QTEST_MAIN(TestDataFilterBatch)
+#include "testDataFilterBatch.moc"
@@ -0,0 +1,5 @@
+QT += testlib core
+
+SOURCES = testDataFilterBinding.cpp
+
+include(../dataFilter.pri)
@@ -0,0 +1,154 @@
+#include "Core/DataFilter.h"
+#include "Core/RideItem.h"
+#include "FileIO/RideFile.h"
+#include "Metrics/RideMetric.h"
+#include "../dataFilterFixture.h"
+
+#include <QTest>
+
+
+class TestDataFilterBinding: public QObject
+{
+    Q_OBJECT
+
+    QVector<RideItem*> rides;
+
+    static Leaf *symbol(const QString &name) {
+        Leaf *returning = new Leaf(0, name.length());
+        returning->type = Leaf::Symbol;
+        returning->lvalue.n = new QString(name);
+        return returning;
+    }
+
+private slots:
+
+    void initTestCase() {
+        rides = DataFilterFixture::activities(6, true);
+    }
+
+    void cleanupTestCase() {
+        qDeleteAll(rides);
+        rides.clear();
+    }
+
+    void symbols() {
+        DataFilterSymbols symbols;
+
+        // reserving a slot doesn't set it
+        int a = symbols.slot("a");
+        QCOMPARE(symbols.slot("a"), a);
+        QCOMPARE(symbols.find("a"), a);
+        QCOMPARE(symbols.find("b"), -1);
+        QVERIFY(!symbols.contains("a"));
+        QVERIFY(!symbols.isSet(a));
+        QCOMPARE(symbols.count(), 0);
+
+        symbols.assign(a, "a", Result(2));
+        QVERIFY(symbols.contains("a"));
+        QCOMPARE(symbols.at(a).isNumber, true);
+        QCOMPARE(Result(symbols.at(a)).number(), 2.0);
+
+        // by name when the slot wasn't bound
+        symbols.assign(-1, "b", Result(QString("text")));
+        QVERIFY(symbols.find("b") >= 0);
+        QCOMPARE(symbols.value("b").string(), QString("text"));
+
+        symbols.insert("c", Result(3));
+        QCOMPARE(symbols.count(), 3);
+        QStringList keys = symbols.keys();
+        keys.sort();
+        QCOMPARE(keys, QStringList() << "a" << "b" << "c");
+
+        symbols.clear();
+        QCOMPARE(symbols.count(), 0);
+        QCOMPARE(symbols.find("a"), -1);
+    }
+
+    void resolve() {
+        DataFilter filter(NULL, DataFilterFixture::context());
+
+        SymbolBinding duration = SymbolBinding::resolve(&filter.rt, "Duration");
+        QCOMPARE(duration.kind, SymbolBinding::Number);
+        QCOMPARE(duration.field, QString("workout_time"));
+        QCOMPARE(duration.metric, RideMetricFactory::instance().rideMetric("workout_time")->index());
+        QCOMPARE(duration.series, RideFile::none);
+
+        SymbolBinding power = SymbolBinding::resolve(&filter.rt, "POWER");
+        QCOMPARE(power.series, RideFile::watts);
+
+        QCOMPARE(SymbolBinding::resolve(&filter.rt, "isRun").kind, SymbolBinding::IsRun);
+        QCOMPARE(SymbolBinding::resolve(&filter.rt, "recintsecs").kind, SymbolBinding::RecIntSecs);
+        QCOMPARE(SymbolBinding::resolve(&filter.rt, "x").kind, SymbolBinding::X);
+        QCOMPARE(SymbolBinding::resolve(&filter.rt, "Date").kind, SymbolBinding::Date);
+    }
+
+    // a bound leaf loads what looking it up by name would find
+    void sameAsByName_data() {
+        QTest::addColumn<QString>("name");
+
+        QTest::newRow("metric") << "Duration";
+        QTest::newRow("another metric") << "Average_Power";
+        QTest::newRow("series") << "POWER";
+        QTest::newRow("index") << "INDEX";
+        QTest::newRow("reserved") << "isRun";
+        QTest::newRow("date") << "Date";
+        QTest::newRow("time") << "Time";
+        QTest::newRow("recording interval") << "RECINTSECS";
+        QTest::newRow("unknown") << "nothing_here";
+    }
+
+    void sameAsByName() {
+        QFETCH(QString, name);
+
+        DataFilter filter(NULL, DataFilterFixture::context());
+        Leaf *unbound = symbol(name);
+        Leaf *bound = symbol(name);
+        bound->bind(&filter.rt, bound);
+        QVERIFY(bound->bound.kind != SymbolBinding::Unbound);
+
+        foreach(RideItem *item, rides) {
+            QList<RideFilePoint*> points;
+            points << NULL << item->ride()->dataPoints().first() << item->ride()->dataPoints().last();
+            foreach(RideFilePoint *point, points) {
+                Result byname = Leaf::symbol(&filter.rt, unbound, Result(0), 0, item, point, NULL);
+                Result byslot = Leaf::symbol(&filter.rt, bound, Result(0), 0, item, point, NULL);
+                QVERIFY2(DataFilterFixture::same(byname, byslot), qPrintable(item->fileName));
+            }
+        }
+
+        unbound->clear(unbound);
+        bound->clear(bound);
+        delete unbound;
+        delete bound;
+    }
+
+    // assigned symbols override the builtins, by slot or by name
+    void override() {
+        DataFilter metric(NULL, DataFilterFixture::context(), "Duration");
+        DataFilter assigned(NULL, DataFilterFixture::context(), "{ Duration <- 5; Duration; }");
+        QVERIFY(metric.root() && assigned.root());
+
+        QVERIFY(metric.evaluate(rides[0], NULL).number() > 5);
+        QCOMPARE(assigned.evaluate(rides[0], NULL).number(), 5.0);
+
+        metric.rt.symbols.insert("Duration", Result(7));
+        QCOMPARE(metric.evaluate(rides[0], NULL).number(), 7.0);
+    }
+
+    // metrics and metadata are bound again when the config changes
+    void rebind() {
+        DataFilter filter(NULL, DataFilterFixture::context(), "Duration + Average_Power + POWER");
+        QVERIFY(filter.root());
+
+        QVector<Result> before;
+        foreach(RideItem *item, rides) before << filter.evaluate(item, item->ride()->dataPoints().first());
+
+        filter.configChanged(0);
+
+        for (int i=0; i<rides.count(); i++)
+            QVERIFY(DataFilterFixture::same(before[i], filter.evaluate(rides[i], rides[i]->ride()->dataPoints().first())));
+    }
+};
+
+QTEST_MAIN(TestDataFilterBinding)
+#include "testDataFilterBinding.moc"
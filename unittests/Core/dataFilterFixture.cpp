@@ -0,0 +1,108 @@
+#include "dataFilterFixture.h"
+
+#include "Core/Context.h"
+#include "Core/RideItem.h"
+#include "FileIO/RideFile.h"
+#include "Metrics/RideMetric.h"
+
+#include <QApplication>
+#include <cmath>
+
+// the globals main.cpp would have defined
+bool restarting = false;
+QString gcroot;
+QApplication *application = NULL;
+#ifdef GC_WANT_HTTP
+class HttpListener;
+HttpListener *listener = NULL;
+#endif
+#ifdef GC_WANT_R
+class RTool;
+RTool *rtool = NULL;
+#endif
+
+Context *
+DataFilterFixture::context()
+{
+    static Context *context = NULL;
+    if (!context) {
+        context = new Context(NULL);
+        context->athlete = NULL;
+        context->tab = NULL;
+    }
+    return context;
+}
+
+static void
+setMetric(RideItem *item, QString symbol, double value)
+{
+    const RideMetric *metric = RideMetricFactory::instance().rideMetric(symbol);
+    if (metric) item->metrics()[metric->index()] = value;
+}
+
+RideItem *
+DataFilterFixture::activity(int n, bool samples)
+{
+    QDateTime start(QDate(2025, 1, 1).addDays(n), QTime(6 + n % 12, 0));
+    double duration = 1800 + (n * 397) % 7200;
+
+    RideFile *ride = NULL;
+    if (samples) {
+        ride = new RideFile(start, 1.0);
+
+        // ten minutes with the odd dropout
+        for (int i=0; i<600; i++) {
+            RideFilePoint point;
+            point.secs = i;
+            point.watts = (i + n) % 97 == 0 ? 0 : 150 + ((i * 7 + n * 13) % 200);
+            point.hr = 90 + ((i + n) % 80);
+            point.cad = (i + n) % 53 == 0 ? 0 : 70 + ((i * 3 + n) % 40);
+            point.kph = 20 + ((i * 11 + n) % 200) / 10.0;
+            point.km = i * point.kph / 3600.0;
+            point.alt = 50 + ((i * 5 + n * 3) % 120);
+            ride->appendPoint(point);
+        }
+    }
+
+    RideItem *returning = new RideItem(ride, context());
+    returning->fileName = QString("%1.%2").arg(start.toString("yyyy_MM_dd_HH_mm_ss")).arg(n % 4 ? "json" : "tcx");
+    returning->dateTime = start;
+    returning->isRun = (n % 3 == 0);
+    returning->isBike = !returning->isRun;
+
+    setMetric(returning, "workout_time", duration);
+    setMetric(returning, "total_distance", duration / 3600.0 * (returning->isRun ? 11 : 31));
+    setMetric(returning, "average_power", returning->isRun ? 0 : 120 + (n * 37) % 150);
+    setMetric(returning, "average_hr", 110 + (n * 11) % 60);
+    return returning;
+}
+
+QVector<RideItem*>
+DataFilterFixture::activities(int count, bool samples)
+{
+    QVector<RideItem*> returning;
+    for (int n=0; n<count; n++) returning << activity(n, samples);
+    return returning;
+}
+
+bool
+DataFilterFixture::same(Result a, Result b)
+{
+    if (a.isNumber != b.isNumber || a.isVector() != b.isVector()) return false;
+
+    if (a.isNumber) {
+        if (a.number() != b.number() && !(std::isnan(a.number()) && std::isnan(b.number()))) return false;
+        return a.asNumeric() == b.asNumeric();
+    }
+    return a.string() == b.string() && a.asString() == b.asString();
+}
+
+bool
+DataFilterFixture::same(const DataFilterSymbols &a, const DataFilterSymbols &b)
+{
+    if (a.count() != b.count()) return false;
+
+    foreach(const QString &name, a.keys())
+        if (!b.contains(name) || !same(a.value(name), b.value(name))) return false;
+    return true;
+}
@@ -0,0 +1,32 @@
+#ifndef _GC_dataFilterFixture_h
+#define _GC_dataFilterFixture_h 1
+
+#include "Core/DataFilter.h"
+
+#include <QVector>
+
+class Context;
+class RideItem;
+
+// what the DataFilter tests evaluate expressions against: a context
+// with no athlete and activities made up here rather than read from
+// a library, so only expressions that read the activity and its
+// samples can be used (no config(), best(), pmc and so on). The memo
+// is only reached with one set on the runtime (DataFilterRuntime::memo)
+class DataFilterFixture
+{
+    public:
+
+        static Context *context();
+
+        // the same activity for the same n, with a few minutes of
+        // samples if asked for. Owned by the caller.
+        static RideItem *activity(int n, bool samples);
+        static QVector<RideItem*> activities(int count, bool samples);
+
+        // results and symbols that are the same, NaN included
+        static bool same(Result a, Result b);
+        static bool same(const DataFilterSymbols &a, const DataFilterSymbols &b);
+};
+
+#endif // _GC_dataFilterFixture_h
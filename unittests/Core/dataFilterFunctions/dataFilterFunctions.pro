@@ -0,0 +1,5 @@
+QT += testlib core
+
+SOURCES = testDataFilterFunctions.cpp
+
+include(../dataFilter.pri)
@@ -0,0 +1,166 @@
+#include "Core/DataFilter.h"
+#include "Core/RideItem.h"
+#include "FileIO/RideFile.h"
+#include "../dataFilterFixture.h"
+
+#include <QTest>
+
+
+// forget the function ids bound when validated, so
+// calls are looked up by name as unchecked ones are
+static void
+unbind(Leaf *leaf)
+{
+    if (!leaf) return;
+
+    switch (leaf->type) {
+
+    case Leaf::Compound :
+        foreach(Leaf *p, *(leaf->lvalue.b)) unbind(p);
+        break;
+
+    case Leaf::Operation :
+    case Leaf::BinaryOperation :
+    case Leaf::Logical :
+        unbind(leaf->lvalue.l);
+        if (leaf->op) unbind(leaf->rvalue.l);
+        break;
+
+    case Leaf::UnaryOperation :
+        unbind(leaf->lvalue.l);
+        break;
+
+    case Leaf::Function :
+        leaf->builtin = leaf->fnum = -1;
+        unbind(leaf->lvalue.l);
+        unbind(leaf->series);
+        foreach(Leaf *p, leaf->fparms) unbind(p);
+        break;
+
+    case Leaf::Index :
+    case Leaf::Select :
+        unbind(leaf->lvalue.l);
+        foreach(Leaf *p, leaf->fparms) unbind(p);
+        break;
+
+    case Leaf::Conditional :
+        unbind(leaf->cond.l);
+        unbind(leaf->lvalue.l);
+        unbind(leaf->rvalue.l);
+        break;
+
+    default:
+        break;
+    }
+}
+
+class TestDataFilterFunctions: public QObject
+{
+    Q_OBJECT
+
+    QVector<RideItem*> rides;
+
+private slots:
+
+    void initTestCase() {
+        rides = DataFilterFixture::activities(4, true);
+    }
+
+    void cleanupTestCase() {
+        qDeleteAll(rides);
+        rides.clear();
+    }
+
+    // from the top, middle and end of the v4 table and the builtins
+    void values_data() {
+        QTest::addColumn<QString>("script");
+        QTest::addColumn<double>("expected");
+
+        QTest::newRow("math.h") << "floor(2.7) + ceil(2.2) + fabs(-3)" << 8.0;
+        QTest::newRow("round") << "round(2.567, 2)" << 2.57;
+        QTest::newRow("variable parameters") << "sum(1,2,3) + max(1,5,3) + min(4,2,8) + count(1,2,3)" << 16.0;
+        QTest::newRow("vector") << "length(c(1,2,3,4))" << 4.0;
+        QTest::newRow("vector result") << "cumsum(c(1,2,3))" << 10.0;
+        QTest::newRow("types") << "isNumber(1) + isString(\"a\")" << 2.0;
+        QTest::newRow("ride") << "filename() endsWith \".tcx\"" << 1.0;
+        QTest::newRow("user function shadows builtin") << "{ round { 42; } main { round(2.5); } }" << 42.0;
+    }
+
+    void values() {
+        QFETCH(QString, script);
+        QFETCH(double, expected);
+
+        DataFilter filter(NULL, DataFilterFixture::context(), script);
+        QVERIFY2(filter.root(), qPrintable(filter.getErrors().join(" ")));
+
+        Result result = filter.evaluate(rides[0], NULL);
+        QVERIFY(result.isNumber);
+        QVERIFY(qFuzzyCompare(1 + result.number(), 1 + expected));
+    }
+
+    void strings() {
+        DataFilter filter(NULL, DataFilterFixture::context(), "toupper(\"abc\")");
+        QVERIFY(filter.root());
+        Result result = filter.evaluate(rides[0], NULL);
+        QVERIFY(!result.isNumber);
+        QCOMPARE(result.string(), QString("ABC"));
+    }
+
+    // the ids are bound when validated
+    void bound() {
+        DataFilter v4(NULL, DataFilterFixture::context(), "round(2.5)");
+        QVERIFY(v4.root());
+        QCOMPARE(v4.root()->type, Leaf::Function);
+        QVERIFY(v4.root()->builtin >= 0);
+        QVERIFY(v4.root()->fnum >= 0);
+
+        DataFilter builtin(NULL, DataFilterFixture::context(), "length(c(1,2))");
+        QVERIFY(builtin.root());
+        QVERIFY(builtin.root()->builtin > 0);
+        QVERIFY(builtin.root()->fnum > v4.root()->fnum);
+
+        // the parameter count is checked once, when validated
+        DataFilter wrong(NULL, DataFilterFixture::context(), "length(1, 2)");
+        QVERIFY(!wrong.getErrors().isEmpty());
+    }
+
+    // bound or looked up by name, per sample
+    void sameAsByName() {
+        QString script("round(SPEED, 1) + stddev(c(POWER, HEARTRATE)) + sqrt(POWER) + length(c(CADENCE)) + max(POWER, HEARTRATE)");
+        DataFilter bound(NULL, DataFilterFixture::context(), script);
+        DataFilter byname(NULL, DataFilterFixture::context(), script);
+        QVERIFY(bound.root() && byname.root());
+        unbind(byname.root());
+
+        foreach(RideItem *item, rides) {
+            foreach(RideFilePoint *point, item->ride()->dataPoints())
+                QVERIFY(DataFilterFixture::same(bound.evaluate(item, point), byname.evaluate(item, point)));
+        }
+    }
+
+    // functions late in the lists, for every sample in a ride
+    void benchmark_data() {
+        QTest::addColumn<bool>("bind");
+
+        QTest::newRow("by name") << false;
+        QTest::newRow("bound") << true;
+    }
+
+    void benchmark() {
+        QFETCH(bool, bind);
+
+        DataFilter filter(NULL, DataFilterFixture::context(), "round(SPEED, 1) + stddev(c(POWER, HEARTRATE)) + variance(c(CADENCE, POWER))");
+        QVERIFY(filter.root());
+        if (!bind) unbind(filter.root());
+
+        double total = 0;
+        QBENCHMARK {
+            foreach(RideFilePoint *point, rides[0]->ride()->dataPoints())
+                total += filter.evaluate(rides[0], point).number();
+        }
+        QVERIFY(total > 0);
+    }
+};
+
+QTEST_MAIN(TestDataFilterFunctions)
+#include "testDataFilterFunctions.moc"
@@ -0,0 +1,5 @@
+QT += testlib core
+
+SOURCES = testDataFilterMemo.cpp
+
+include(../dataFilter.pri)
@@ -0,0 +1,204 @@
+#include "Core/DataFilter.h"
+#include "Core/DataFilterMemo.h"
+#include "Core/Context.h"
+#include "Core/RideItem.h"
+#include "Core/Specification.h"
+#include "../dataFilterFixture.h"
+
+#include <QTest>
+
+
+class TestDataFilterMemo: public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void lookup() {
+        DataFilterMemo memo(DataFilterFixture::context());
+        Result value;
+        int generation;
+
+        QVERIFY(!memo.lookup("key", value, generation));
+        memo.insert("key", Result(42), generation);
+
+        QVERIFY(memo.lookup("key", value, generation));
+        QCOMPARE(value.number(), 42.0);
+
+        DataFilterMemo::Stats stats = memo.stats();
+        QCOMPARE(stats.hits, qint64(1));
+        QCOMPARE(stats.misses, qint64(1));
+        QCOMPARE(stats.entries, 1);
+    }
+
+    void vectors() {
+        DataFilterMemo memo(DataFilterFixture::context());
+        Result value;
+        int generation;
+
+        QVector<double> bests;
+        for (int i=0; i<3600; i++) bests << 1000 - i / 10.0;
+        QVERIFY(!memo.lookup("bests", value, generation));
+        memo.insert("bests", Result(bests), generation);
+
+        QVERIFY(memo.lookup("bests", value, generation));
+        QVERIFY(DataFilterFixture::same(value, Result(bests)));
+        QVERIFY(memo.stats().cost >= int(3600 * sizeof(double)));
+    }
+
+    // computed from data that changed since it was looked up
+    void stale() {
+        DataFilterMemo memo(DataFilterFixture::context());
+        Result value;
+        int generation;
+
+        QVERIFY(!memo.lookup("key", value, generation));
+        memo.invalidate();
+        memo.insert("key", Result(1), generation);
+        QVERIFY(!memo.lookup("key", value, generation));
+    }
+
+    // anything that changes rides, metrics or estimates
+    void invalidated() {
+        Context *context = DataFilterFixture::context();
+        DataFilterMemo memo(context);
+        Result value;
+        int generation;
+
+        for (int i=0; i<6; i++) {
+            QVERIFY(!memo.lookup("key", value, generation));
+            memo.insert("key", Result(i), generation);
+            QVERIFY(memo.lookup("key", value, generation));
+
+            switch (i) {
+            case 0: emit context->rideAdded(NULL); break;
+            case 1: emit context->rideDeleted(NULL); break;
+            case 2: emit context->rideSaved(NULL); break;
+            case 3: emit context->refreshUpdate(QDate::currentDate()); break;
+            case 4: emit context->estimatesRefreshed(); break;
+            case 5: emit context->configChanged(0); break;
+            }
+            QCOMPARE(memo.stats().entries, 0);
+        }
+        QCOMPARE(memo.stats().invalidations, qint64(6));
+    }
+
+    // least recently used are dropped beyond the budget
+    void budget() {
+        DataFilterMemo memo(DataFilterFixture::context());
+        memo.setBudget(64 * 1024);
+
+        QVector<double> large(1024, 1.0);
+        for (int i=0; i<20; i++) {
+            Result value;
+            int generation;
+            memo.lookup(QString::number(i), value, generation);
+            memo.insert(QString::number(i), Result(large), generation);
+        }
+
+        DataFilterMemo::Stats stats = memo.stats();
+        QVERIFY(stats.entries < 20);
+        QVERIFY(stats.cost <= stats.budget);
+
+        Result value;
+        int generation;
+        QVERIFY(memo.lookup("19", value, generation));
+        QVERIFY(!memo.lookup("0", value, generation));
+    }
+
+    // the date range builtins are marked when bound
+    void marked_data() {
+        QTest::addColumn<QString>("script");
+        QTest::addColumn<bool>("memoised");
+
+        QTest::newRow("aggmetrics") << "aggmetrics(Duration)" << true;
+        QTest::newRow("estimates") << "estimates(cp3, cp)" << true;
+        QTest::newRow("estimate") << "estimate(cp3, cp)" << false;
+        QTest::newRow("per ride") << "length(c(1,2))" << false;
+    }
+
+    void marked() {
+        QFETCH(QString, script);
+        QFETCH(bool, memoised);
+
+        DataFilter filter(NULL, DataFilterFixture::context(), script);
+        QVERIFY2(filter.root(), qPrintable(filter.getErrors().join(" ")));
+        QCOMPARE(filter.root()->memo.isEmpty(), !memoised);
+    }
+
+    // kept for the date range and filters, whichever ride asks for it.
+    // A miss would compute it from the athlete, which there isn't one
+    // of here, so only keys that were seeded are evaluated
+    void evaluated() {
+        Context *context = DataFilterFixture::context();
+        DataFilterMemo memo(context);
+        DataFilter filter(NULL, context, "aggmetrics(Duration)");
+        QVERIFY2(filter.root(), qPrintable(filter.getErrors().join(" ")));
+        filter.rt.memo = &memo;
+
+        RideItem *first = DataFilterFixture::activity(1, false);
+        RideItem *second = DataFilterFixture::activity(2, false);
+        DateRange year(QDate(2020,1,1), QDate(2020,12,31));
+        DateRange month(QDate(2020,6,1), QDate(2020,6,30));
+
+        Specification spec, other;
+        spec.setDateRange(year);
+        spec.setRideItem(first);
+        other.setDateRange(year);
+        other.setRideItem(second);
+
+        // the same for every ride in the same range
+        QString key = Leaf::memoKey(&filter.rt, filter.root(), Result(0), 0, first, NULL, NULL, spec, year);
+        QVERIFY(key != "");
+        QCOMPARE(Leaf::memoKey(&filter.rt, filter.root(), Result(0), 0, second, NULL, NULL, other, year), key);
+
+        Result value;
+        int generation;
+        QVERIFY(!memo.lookup(key, value, generation));
+        memo.insert(key, Result(1), generation);
+
+        QCOMPARE(filter.root()->eval(&filter.rt, filter.root(), Result(0), 0, first, NULL, NULL, spec, year).number(), 1.0);
+        QCOMPARE(filter.root()->eval(&filter.rt, filter.root(), Result(0), 0, second, NULL, NULL, other, year).number(), 1.0);
+        QCOMPARE(memo.stats().hits, qint64(2));
+
+        // another date range is another entry
+        Specification june;
+        june.setDateRange(month);
+        june.setRideItem(first);
+        QString monthly = Leaf::memoKey(&filter.rt, filter.root(), Result(0), 0, first, NULL, NULL, june, month);
+        QVERIFY(monthly != key);
+        QVERIFY(!memo.lookup(monthly, value, generation));
+        memo.insert(monthly, Result(2), generation);
+        QCOMPARE(filter.root()->eval(&filter.rt, filter.root(), Result(0), 0, first, NULL, NULL, june, month).number(), 2.0);
+
+        // and so are other filters, in the specification or the context
+        Specification filtered = spec;
+        filtered.setFilterSet(FilterSet(true, QStringList() << first->fileName));
+        QString selected = Leaf::memoKey(&filter.rt, filter.root(), Result(0), 0, first, NULL, NULL, filtered, year);
+        QVERIFY(selected != key);
+
+        QStringList names = QStringList() << second->fileName;
+        context->isfiltered = true;
+        context->filters = names;
+        QString searched = Leaf::memoKey(&filter.rt, filter.root(), Result(0), 0, first, NULL, NULL, spec, year);
+        QVERIFY(searched != key && searched != selected);
+        QVERIFY(!memo.lookup(searched, value, generation));
+        memo.insert(searched, Result(3), generation);
+        QCOMPARE(filter.root()->eval(&filter.rt, filter.root(), Result(0), 0, first, NULL, NULL, spec, year).number(), 3.0);
+
+        context->isfiltered = false;
+        context->filters.clear();
+        QCOMPARE(filter.root()->eval(&filter.rt, filter.root(), Result(0), 0, first, NULL, NULL, spec, year).number(), 1.0);
+
+        DataFilterMemo::Stats stats = memo.stats();
+        QCOMPARE(stats.hits, qint64(5));
+        QCOMPARE(stats.misses, qint64(3));
+        QCOMPARE(stats.entries, 3);
+
+        delete first;
+        delete second;
+    }
+};
+
+QTEST_MAIN(TestDataFilterMemo)
+#include "testDataFilterMemo.moc"
@@ -0,0 +1,5 @@
+QT += testlib core
+
+SOURCES = testDataFilterOptimizer.cpp
+
+include(../dataFilter.pri)
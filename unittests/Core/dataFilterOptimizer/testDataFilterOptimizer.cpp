@@ -0,0 +1,167 @@
+#include "Core/DataFilter.h"
+#include "Core/DataFilterOptimizer.h"
+#include "Core/RideItem.h"
+#include "Core/Specification.h"
+#include "FileIO/RideFile.h"
+#include "../dataFilterFixture.h"
+
+#include <QTest>
+
+
+class TestDataFilterOptimizer: public QObject
+{
+    Q_OBJECT
+
+    QVector<RideItem*> rides;
+
+    // the tree as parsed, with nothing optimised
+    static DataFilter *parsed(const QString &script) {
+        DataFilterOptimizer::enabled = false;
+        DataFilter *returning = new DataFilter(NULL, DataFilterFixture::context(), script);
+        DataFilterOptimizer::enabled = true;
+        return returning;
+    }
+
+    // as user charts and metrics run it, sample() for every sample
+    static void run(DataFilter &filter, RideItem *item, Result &result) {
+        Leaf *sample = filter.rt.functions.value("sample");
+        Leaf *init = filter.rt.functions.value("init");
+
+        filter.rt.resetInvariants();
+        if (!sample) {
+            result = filter.evaluate(item, NULL);
+            return;
+        }
+        if (init) filter.root()->eval(&filter.rt, init, Result(0), 0, item);
+        RideFileIterator it(item->ride(), Specification());
+        while (it.hasNext()) filter.root()->eval(&filter.rt, sample, Result(0), 0, item, it.next());
+    }
+
+private slots:
+
+    void initTestCase() {
+        rides = DataFilterFixture::activities(4, true);
+    }
+
+    void cleanupTestCase() {
+        qDeleteAll(rides);
+        rides.clear();
+    }
+
+    // folded, dead branches and invariants against the tree as parsed
+    void sameAsParsed_data() {
+        QTest::addColumn<QString>("script");
+
+        QTest::newRow("folded condition") << "2 * 3 + 1 > 6 ? Duration : 0";
+        QTest::newRow("dead code") << "{ 1; if (0) { a <- 1; } else { a <- 2; } while (0) { 3; } (3 - 1) ^ 2 + floor(16.5) * Distance + a; }";
+        QTest::newRow("not exact") << "1 / 3 + Duration * 0";
+        QTest::newRow("invariants") << "{ sample { append(v, POWER / sqrt(Duration) * 100); total <- total + (Average_Power > 0 ? HEARTRATE * round(Average_Power, 1) : 0) + CADENCE * round(Average_Power, 1); } }";
+        QTest::newRow("invariants and symbols") << "{ init { n <- 0; } sample { n <- n + 1; append(b, round(POWER * 2 / 3 + sqrt(Duration), 1) + n * -(2 ^ 3)); } }";
+    }
+
+    void sameAsParsed() {
+        QFETCH(QString, script);
+
+        QScopedPointer<DataFilter> before(parsed(script));
+        DataFilter after(NULL, DataFilterFixture::context(), script);
+        QVERIFY2(before->root() && after.root(), qPrintable(after.getErrors().join(" ")));
+
+        const DataFilterOptimizer::Stats &done = after.optimizations();
+        QVERIFY(done.folded + done.branches + done.statements + done.hoisted > 0);
+
+        DataFilterSymbols pristine[2] = { before->rt.symbols, after.rt.symbols };
+        foreach(RideItem *item, rides) {
+            Result results[2];
+
+            before->rt.symbols = pristine[0];
+            run(*before, item, results[0]);
+            after.rt.symbols = pristine[1];
+            run(after, item, results[1]);
+
+            QVERIFY2(DataFilterFixture::same(results[0], results[1]), qPrintable(item->fileName));
+            QVERIFY2(DataFilterFixture::same(before->rt.symbols, after.rt.symbols), qPrintable(item->fileName));
+        }
+    }
+
+    void folds() {
+        DataFilter filter(NULL, DataFilterFixture::context(), "{ 1; 2; (2 * 3 + 1) * (1 > 0); }");
+        QVERIFY(filter.root());
+        QCOMPARE(filter.optimizations().statements, 2);
+        QVERIFY(filter.optimizations().folded >= 3);
+        QCOMPARE(filter.evaluate(rides[0], NULL).number(), 7.0);
+
+        // a float can't hold a third exactly, so it is left
+        DataFilter third(NULL, DataFilterFixture::context(), "1 / 3");
+        QVERIFY(third.root());
+        QCOMPARE(third.optimizations().folded, 0);
+        QCOMPARE(third.evaluate(rides[0], NULL).number(), 1.0 / 3.0);
+    }
+
+    void branches() {
+        DataFilter filter(NULL, DataFilterFixture::context(), "if (1 > 2) { Duration; } else { Distance; }");
+        QVERIFY(filter.root());
+        QCOMPARE(filter.optimizations().branches, 1);
+
+        DataFilter distance(NULL, DataFilterFixture::context(), "Distance");
+        QCOMPARE(filter.evaluate(rides[0], NULL).number(), distance.evaluate(rides[0], NULL).number());
+
+        // a loop that never runs
+        DataFilter loop(NULL, DataFilterFixture::context(), "{ while (0) { 1; } Duration; }");
+        QVERIFY(loop.root());
+        QCOMPARE(loop.optimizations().branches, 1);
+    }
+
+    // only in the per sample functions, and shared when the same
+    void hoists() {
+        DataFilter filter(NULL, DataFilterFixture::context(), "{ sample { total <- total + POWER * sqrt(Duration) + HEARTRATE * sqrt(Duration); } }");
+        QVERIFY(filter.root());
+        QCOMPARE(filter.optimizations().hoisted, 1);
+        QCOMPARE(filter.optimizations().shared, 1);
+        QVERIFY(DataFilterOptimizer::dump(filter.root()).contains("once per ride"));
+
+        DataFilter activity(NULL, DataFilterFixture::context(), "POWER * sqrt(Duration)");
+        QCOMPARE(activity.optimizations().hoisted, 0);
+
+        // a symbol assigned anywhere isn't invariant
+        DataFilter assigned(NULL, DataFilterFixture::context(), "{ sample { a <- Duration; total <- total + sqrt(a) * POWER; } }");
+        QCOMPARE(assigned.optimizations().hoisted, 0);
+
+        // nor are the series
+        DataFilter series(NULL, DataFilterFixture::context(), "{ sample { total <- total + sqrt(POWER); } }");
+        QCOMPARE(series.optimizations().hoisted, 0);
+    }
+
+    void disabled() {
+        QScopedPointer<DataFilter> filter(parsed("{ 1; 2 * 3; }"));
+        QVERIFY(filter->root());
+        const DataFilterOptimizer::Stats &done = filter->optimizations();
+        QCOMPARE(done.folded + done.branches + done.statements + done.hoisted + done.shared, 0);
+    }
+
+    // as parsed and optimised, for every sample in a ride
+    void benchmark_data() {
+        QTest::addColumn<bool>("optimise");
+
+        QTest::newRow("parsed") << false;
+        QTest::newRow("optimised") << true;
+    }
+
+    void benchmark() {
+        QFETCH(bool, optimise);
+
+        QString script("{ sample { total <- total + (Average_Power > 0 ? HEARTRATE * round(Average_Power, 1) : 0) + CADENCE * round(Average_Power, 1) * (2 * 3 + 1); } }");
+        QScopedPointer<DataFilter> filter(optimise ? new DataFilter(NULL, DataFilterFixture::context(), script) : parsed(script));
+        QVERIFY(filter->root());
+
+        DataFilterSymbols pristine = filter->rt.symbols;
+        Result result;
+        QBENCHMARK {
+            filter->rt.symbols = pristine;
+            run(*filter, rides[1], result);
+        }
+        QVERIFY(filter->rt.symbols.value("total").number() > 0);
+    }
+};
+
+QTEST_MAIN(TestDataFilterOptimizer)
+#include "testDataFilterOptimizer.moc"
@@ -0,0 +1,5 @@
+QT += testlib core
+
+SOURCES = testDataFilterParallel.cpp
+
+include(../dataFilter.pri)
@@ -0,0 +1,95 @@
+#include "Core/DataFilter.h"
+#include "Core/RideItem.h"
+#include "../dataFilterFixture.h"
+
+#include <QTest>
+
+
+class TestDataFilterParallel: public QObject
+{
+    Q_OBJECT
+
+    // enough for the rides to be split across threads
+    QVector<RideItem*> rides;
+
+    static QVector<Result> serial(DataFilter &filter, const QVector<RideItem*> &rides) {
+        QVector<Result> returning;
+        foreach(RideItem *item, rides) returning << filter.evaluate(item, NULL);
+        return returning;
+    }
+
+private slots:
+
+    void initTestCase() {
+        rides = DataFilterFixture::activities(2000, false);
+    }
+
+    void cleanupTestCase() {
+        qDeleteAll(rides);
+        rides.clear();
+    }
+
+    void sameAsSerial_data() {
+        QTest::addColumn<QString>("script");
+        QTest::addColumn<bool>("concurrent");
+
+        QTest::newRow("filter") << "Duration > 3600 && Average_Power > 150 || isRun" << true;
+        QTest::newRow("user functions") << "{ long { Duration > 5400; } main { long() || (Distance > 50 && filename() endsWith \".json\"); } }" << true;
+        QTest::newRow("strings") << "isRun ? \"run\" : filename()" << true;
+        QTest::newRow("local symbols") << "{ a <- Duration / 60; a > 60; }" << false;
+        QTest::newRow("shared state") << "{ main { n <- n + 1; n; } }" << false;
+        QTest::newRow("side effects") << "{ append(v, Duration); length(v); }" << false;
+    }
+
+    void sameAsSerial() {
+        QFETCH(QString, script);
+        QFETCH(bool, concurrent);
+
+        DataFilter filter(NULL, DataFilterFixture::context(), script);
+        QVERIFY2(filter.root(), qPrintable(filter.getErrors().join(" ")));
+        QCOMPARE(filter.isConcurrent(), concurrent);
+
+        DataFilterSymbols pristine = filter.rt.symbols;
+        QVector<Result> expected = serial(filter, rides);
+        filter.rt.symbols = pristine;
+        QVector<Result> results = filter.evaluate(rides);
+
+        QCOMPARE(results.count(), rides.count());
+        for (int i=0; i<rides.count(); i++)
+            QVERIFY2(DataFilterFixture::same(expected[i], results[i]), qPrintable(rides[i]->fileName));
+    }
+
+    void empty() {
+        DataFilter filter(NULL, DataFilterFixture::context(), "Duration > 3600");
+        QVERIFY(filter.evaluate(QVector<RideItem*>()).isEmpty());
+
+        DataFilter broken(NULL, DataFilterFixture::context(), "Duration >");
+        QVector<Result> results = broken.evaluate(rides);
+        QCOMPARE(results.count(), rides.count());
+        QCOMPARE(results[0].number(), 0.0);
+    }
+
+    void benchmark_data() {
+        QTest::addColumn<bool>("parallel");
+
+        QTest::newRow("serial") << false;
+        QTest::newRow("parallel") << true;
+    }
+
+    void benchmark() {
+        QFETCH(bool, parallel);
+
+        DataFilter filter(NULL, DataFilterFixture::context(), "{ long { Duration > 5400; } main { long() || (Distance > 50 && filename() endsWith \".json\"); } }");
+        QVERIFY(filter.isConcurrent());
+
+        int count = 0;
+        QBENCHMARK {
+            QVector<Result> results = parallel ? filter.evaluate(rides) : serial(filter, rides);
+            count = results.count();
+        }
+        QCOMPARE(count, rides.count());
+    }
+};
+
+QTEST_MAIN(TestDataFilterParallel)
+#include "testDataFilterParallel.moc"
@@ -0,0 +1,5 @@
+QT += testlib core
+
+SOURCES = testDataFilterProfile.cpp
+
+include(../dataFilter.pri)
@@ -0,0 +1,155 @@
+#include "Core/DataFilter.h"
+#include "Core/DataFilterProfile.h"
+#include "Core/RideItem.h"
+#include "../dataFilterFixture.h"
+
+#include <QTest>
+#include <QtConcurrent>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+
+
+// spend a little time, so it shows up in the profile
+static void
+busy(int usecs)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.nsecsElapsed() < usecs * 1000) ;
+}
+
+static DataFilterProfile::Entry
+entry(const DataFilterProfile &profile, const QString &name)
+{
+    foreach(const DataFilterProfile::Entry &entry, profile.entries())
+        if (entry.name == name) return entry;
+    return DataFilterProfile::Entry();
+}
+
+class TestDataFilterProfile: public QObject
+{
+    Q_OBJECT
+
+    RideItem *ride;
+
+private slots:
+
+    void initTestCase() {
+        ride = DataFilterFixture::activity(2, false);
+    }
+
+    void cleanupTestCase() {
+        delete ride;
+    }
+
+    void nested() {
+        DataFilterProfile profile;
+        QVERIFY(profile.isEmpty());
+
+        profile.enter("outer");
+        busy(500);
+        for (int i=0; i<3; i++) {
+            DataFilterProfile::Scope scope(&profile, "inner");
+            busy(500);
+        }
+        profile.leave();
+
+        DataFilterProfile::Entry outer = entry(profile, "outer");
+        DataFilterProfile::Entry inner = entry(profile, "inner");
+        QCOMPARE(outer.calls, qint64(1));
+        QCOMPARE(inner.calls, qint64(3));
+        QCOMPARE(inner.total, inner.self);
+        QVERIFY(outer.total >= outer.self + inner.total);
+        QVERIFY(outer.self >= 500000);
+
+        // most self time first
+        QCOMPARE(profile.entries().first().name, QString("inner"));
+
+        profile.clear();
+        QVERIFY(profile.isEmpty());
+    }
+
+    // the outer call already includes the inner one
+    void recursive() {
+        DataFilterProfile profile;
+        profile.enter("f");
+        busy(200);
+        profile.enter("f");
+        busy(200);
+        profile.leave();
+        profile.leave();
+
+        DataFilterProfile::Entry f = entry(profile, "f");
+        QCOMPARE(f.calls, qint64(2));
+        QCOMPARE(f.total, f.self);
+
+        // unbalanced leaves are ignored
+        profile.leave();
+        QCOMPARE(entry(profile, "f").calls, qint64(2));
+    }
+
+    void allocations() {
+        DataFilterProfile profile;
+        profile.enter("vectors");
+        {
+            Result vector(QVector<double>() << 1 << 2);
+            Result copy = vector;
+            Result number(3);
+        }
+        profile.leave();
+        QCOMPARE(entry(profile, "vectors").allocations, qint64(2));
+    }
+
+    // runtimes copied for other threads share the profile
+    void threads() {
+        DataFilterProfile profile;
+        QVector<int> work(64, 100);
+        QtConcurrent::blockingMap(work, [&profile] (int &usecs) {
+            DataFilterProfile::Scope outer(&profile, "worker");
+            DataFilterProfile::Scope inner(&profile, "step");
+            busy(usecs);
+        });
+
+        QCOMPARE(entry(profile, "worker").calls, qint64(64));
+        QCOMPARE(entry(profile, "step").calls, qint64(64));
+        QVERIFY(entry(profile, "worker").total >= entry(profile, "step").total);
+    }
+
+    void reports() {
+        DataFilterProfile profile;
+        { DataFilterProfile::Scope scope(&profile, "sample { }"); busy(100); }
+
+        QString report = profile.report();
+        QCOMPARE(report.split("\n", Qt::SkipEmptyParts).count(), 2);
+        QVERIFY(report.contains("sample { }"));
+
+        QTemporaryDir dir;
+        QString filename = dir.path() + "/profile.csv";
+        QVERIFY(profile.save(filename));
+        QFile file(filename);
+        QVERIFY(file.open(QIODevice::ReadOnly | QIODevice::Text));
+        QStringList lines = QString(file.readAll()).split("\n", Qt::SkipEmptyParts);
+        QCOMPARE(lines.count(), 2);
+        QVERIFY(lines[1].startsWith("\"sample { }\",1,"));
+    }
+
+    // profiling records the calls, without changing the result
+    void evaluated() {
+        DataFilter filter(NULL, DataFilterFixture::context(), "{ f { sqrt(Duration) + round(Distance, 1); } main { f() + f() + isRun; } }");
+        QVERIFY(filter.root());
+
+        Result plain = filter.evaluate(ride, NULL);
+
+        DataFilterProfile profile;
+        filter.rt.profile = &profile;
+        Result profiled = filter.evaluate(ride, NULL);
+        filter.rt.profile = NULL;
+
+        QVERIFY(DataFilterFixture::same(plain, profiled));
+        QCOMPARE(entry(profile, "f()").calls, qint64(2));
+        QVERIFY(entry(profile, "f()").total >= entry(profile, "f()").self);
+    }
+};
+
+QTEST_MAIN(TestDataFilterProfile)
+#include "testDataFilterProfile.moc"
@@ -0,0 +1,5 @@
+QT += testlib core
+
+SOURCES = testDataFilterProgram.cpp
+
+include(../dataFilter.pri)
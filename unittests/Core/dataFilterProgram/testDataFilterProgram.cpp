@@ -0,0 +1,163 @@
+#include "Core/DataFilter.h"
+#include "Core/DataFilterProgram.h"
+#include "Core/RideItem.h"
+#include "FileIO/RideFile.h"
+#include "../dataFilterFixture.h"
+
+#include <QTest>
+
+
+class TestDataFilterProgram: public QObject
+{
+    Q_OBJECT
+
+    QVector<RideItem*> rides;
+
+    // evaluated from the same symbols by the tree and the program
+    static bool agrees(DataFilter &filter, RideItem *item, RideFilePoint *point) {
+        DataFilterSymbols initial = filter.rt.symbols;
+
+        filter.rt.interpret = true;
+        Result interpreted = filter.evaluate(item, point);
+        DataFilterSymbols symbols = filter.rt.symbols;
+
+        filter.rt.symbols = initial;
+        filter.rt.interpret = false;
+        Result compiled = filter.evaluate(item, point);
+
+        bool returning = DataFilterFixture::same(compiled, interpreted) &&
+                         DataFilterFixture::same(symbols, filter.rt.symbols);
+        filter.rt.symbols = initial;
+        return returning;
+    }
+
+private slots:
+
+    void initTestCase() {
+        rides = DataFilterFixture::activities(12, true);
+    }
+
+    void cleanupTestCase() {
+        qDeleteAll(rides);
+        rides.clear();
+    }
+
+    // each node the compiler handles, along with the fallbacks
+    // and mixed number/string/vector operands
+    void activities_data() {
+        QTest::addColumn<QString>("script");
+
+        QTest::newRow("arithmetic") << "1 + 2 * 3 - 4 / 5";
+        QTest::newRow("power and divide by zero") << "2 ^ 10 - -3 + 7 / 0";
+        QTest::newRow("not") << "!0 + !5 + !\"text\"";
+        QTest::newRow("logical") << "1 < 2 && 2 >= 2 || 0";
+        QTest::newRow("logical string") << "0 || \"text\" && 1";
+        QTest::newRow("string compare") << "\"abc\" < \"abd\"";
+        QTest::newRow("string ternary") << "\"abc\" = \"abc\" ? 1 : 2";
+        QTest::newRow("string add") << "\"text\" + 1";
+        QTest::newRow("vector add") << "c(1,2,3) + 1";
+        QTest::newRow("vector multiply") << "c(1,2,3) * c(2,2)";
+        QTest::newRow("vector compare") << "c(1,2,3) = 6";
+        QTest::newRow("elvis false") << "0 ?: 7";
+        QTest::newRow("elvis true") << "3 ?: 7";
+        QTest::newRow("function call") << "filename() endsWith \".json\"";
+        QTest::newRow("symbol") << "isRun ? 1 : 2";
+        QTest::newRow("metric") << "Duration > 3600 ? \"long\" : \"short\"";
+        QTest::newRow("date") << "Date - Date + Duration / 60";
+        QTest::newRow("if else") << "if (Duration > 600) { 1; } else { 0; }";
+        QTest::newRow("while") << "{ a <- 0; n <- 0; while (n < 10) { a <- a + n; n <- n + 1; } a; }";
+        QTest::newRow("index assign") << "{ a <- c(1,2); a[1] <- 5; a; }";
+        QTest::newRow("select") << "{ v <- c(1,2,3,4); v[x>2]; }";
+        QTest::newRow("string assign") << "{ s <- \"a\"; s <- s + \"b\"; s; }";
+        QTest::newRow("user function") << "{ f { 3 * 2; } main { f() + 1; } }";
+        QTest::newRow("math") << "round(2.567, 2) + sin(0) + cos(0)";
+        QTest::newRow("math vector") << "log(c(1,10,100)) + floor(Duration / 7) + exp(1 + 1)";
+        QTest::newRow("indexing") << "c(1,2,3)[1] + c(4,5,6)[c(0,2,7)] + c(1,2)[5] + c(1,2)[-1]";
+        QTest::newRow("indexing strings") << "{ s <- c(\"a\",\"b\"); s[1] + s[c(1,0)]; }";
+        QTest::newRow("reserved") << "NA + RECINTSECS + Today - Current + Time + Planned + isRide + isSwim + isXtrain + isAero";
+        QTest::newRow("overridden") << "{ Date <- 5; Date + Duration * 0; }";
+    }
+
+    void activities() {
+        QFETCH(QString, script);
+
+        DataFilter filter(NULL, DataFilterFixture::context(), script);
+        QVERIFY2(filter.root(), qPrintable(filter.getErrors().join(" ")));
+
+        foreach(RideItem *item, rides)
+            QVERIFY2(agrees(filter, item, NULL), qPrintable(item->fileName));
+    }
+
+    void samples_data() {
+        QTest::addColumn<QString>("script");
+
+        QTest::newRow("ternary") << "POWER > 200 ? POWER * 2 : HEARTRATE";
+        QTest::newRow("assign") << "{ a <- POWER + CADENCE; a / 2; }";
+        QTest::newRow("index") << "(SECS - INDEX) * (ALTITUDE > 100)";
+        QTest::newRow("overridden") << "{ POWER <- 3; POWER + (HEARTRATE > 100); }";
+        QTest::newRow("math") << "cos(POWER) + log(HEARTRATE * 2) + floor(SPEED)";
+        QTest::newRow("late functions") << "round(SPEED, 1) + stddev(c(POWER, HEARTRATE)) + sqrt(POWER)";
+    }
+
+    void samples() {
+        QFETCH(QString, script);
+
+        DataFilter filter(NULL, DataFilterFixture::context(), script);
+        QVERIFY2(filter.root(), qPrintable(filter.getErrors().join(" ")));
+
+        for (int i=0; i<3; i++) {
+            foreach(RideFilePoint *point, rides[i]->ride()->dataPoints())
+                QVERIFY2(agrees(filter, rides[i], point), qPrintable(QString("%1 at %2").arg(rides[i]->fileName).arg(point->secs)));
+        }
+    }
+
+    // a lone symbol or call is no quicker compiled
+    void notCompiled() {
+        DataFilter symbol(NULL, DataFilterFixture::context(), "Duration");
+        QVERIFY(symbol.root());
+        QVERIFY(symbol.root()->program == NULL);
+
+        DataFilter expression(NULL, DataFilterFixture::context(), "Duration > 3600");
+        QVERIFY(expression.root());
+        QVERIFY(expression.root()->program != NULL);
+    }
+
+    // math.h functions and indexing don't go back to the tree
+    void compiledCalls() {
+        DataFilter math(NULL, DataFilterFixture::context(), "cos(Duration) + log(2 * 3)");
+        QVERIFY(math.root());
+        QVERIFY(math.root()->program != NULL);
+        QCOMPARE(math.root()->program->evaluates(), 0);
+
+        DataFilter index(NULL, DataFilterFixture::context(), "{ v <- c(1,2,3); v[1] + v[c(0,2)]; }");
+        QVERIFY(index.root());
+        QVERIFY(index.root()->program != NULL);
+        QCOMPARE(index.root()->program->evaluates(), 2); // the calls to c()
+    }
+
+    // a sample expression for every sample in a ride, by either engine
+    void benchmark_data() {
+        QTest::addColumn<bool>("interpret");
+
+        QTest::newRow("interpreted") << true;
+        QTest::newRow("compiled") << false;
+    }
+
+    void benchmark() {
+        QFETCH(bool, interpret);
+
+        DataFilter filter(NULL, DataFilterFixture::context(), "{ a <- POWER + CADENCE; a > 300 ? a / 2 : HEARTRATE * 2; }");
+        QVERIFY(filter.root());
+        filter.rt.interpret = interpret;
+
+        double total = 0;
+        QBENCHMARK {
+            foreach(RideFilePoint *point, rides[0]->ride()->dataPoints())
+                total += filter.evaluate(rides[0], point).number();
+        }
+        QVERIFY(total > 0);
+    }
+};
+
+QTEST_MAIN(TestDataFilterProgram)
+#include "testDataFilterProgram.moc"
@@ -0,0 +1,5 @@
+QT += testlib core
+
+SOURCES = testDataFilterResult.cpp
+
+include(../dataFilter.pri)
@@ -0,0 +1,127 @@
+#include "Core/DataFilter.h"
+#include "Core/RideItem.h"
+#include "../dataFilterFixture.h"
+
+#include <QTest>
+
+
+class TestDataFilterResult: public QObject
+{
+    Q_OBJECT
+
+    RideItem *ride;
+
+private slots:
+
+    void initTestCase() {
+        ride = DataFilterFixture::activity(1, false);
+    }
+
+    void cleanupTestCase() {
+        delete ride;
+    }
+
+    // numbers are held inline, nothing is allocated for them
+    void numbers() {
+        qint64 before = Result::allocations;
+
+        Result a(1), b(2.5);
+        Result c = a;
+        c = b;
+        Result d(std::move(c));
+        QCOMPARE(d.number(), 2.5);
+        QVERIFY(!d.isVector());
+        QCOMPARE(Result::allocations, before);
+
+        // as evaluated, by the tree for every node
+        DataFilter filter(NULL, DataFilterFixture::context(), "1 + 2 * 3 - 4 / 5 + (Duration > 0 ? 1 : 0)");
+        QVERIFY(filter.root());
+        filter.rt.interpret = true;
+        before = Result::allocations;
+        QCOMPARE(filter.evaluate(ride, NULL).number(), 7.2);
+        QCOMPARE(Result::allocations, before);
+    }
+
+    // each result has its own containers
+    void copies() {
+        Result v(QVector<double>() << 1 << 2 << 3);
+        Result w = v;
+        w.asNumeric()[0] = 10;
+        QCOMPARE(v.asNumeric()[0], 1.0);
+
+        Result s(QString("text"));
+        Result t;
+        t = s;
+        t.string() = "changed";
+        QCOMPARE(s.string(), QString("text"));
+
+        // a number assigned over a string or vector
+        s = Result(5);
+        QVERIFY(s.isNumber);
+        QVERIFY(!s.isVector());
+        QCOMPARE(s.number(), 5.0);
+    }
+
+    void moves() {
+        Result v(QVector<double>() << 1 << 2 << 3);
+        Result m(std::move(v));
+        QCOMPARE(m.asNumeric().count(), 3);
+        QCOMPARE(m.number(), 6.0);
+
+        Result n;
+        n = std::move(m);
+        QCOMPARE(n.number(), 6.0);
+        QCOMPARE(n.asNumeric().count(), 3);
+    }
+
+    // a vector's number is its sum
+    void sums() {
+        Result v(QVector<double>() << 1 << 2 << 3.5);
+        QCOMPARE(v.number(), 6.5);
+
+        Result empty((QVector<double>()));
+        QCOMPARE(empty.number(), 0.0);
+        QVERIFY(!empty.isVector());
+
+        Result repeated(2);
+        repeated.vectorize(3);
+        QCOMPARE(repeated.asNumeric(), QVector<double>() << 2 << 2 << 2);
+        QCOMPARE(repeated.number(), 6.0);
+    }
+
+    void coerced() {
+        QCOMPARE(Result(3.5).string(), QString("3.5"));
+        QCOMPARE(Result(QString("2.5")).number(), 2.5);
+
+        QStringList list = QStringList() << "1" << "2";
+        Result strings(list);
+        QVERIFY(!strings.isNumber);
+        QCOMPARE(strings.asNumeric(), QVector<double>() << 1 << 2);
+        QCOMPARE(strings.number(), 3.0);
+    }
+
+    // the cost of the values passed from node to node
+    void benchmarkScalar() {
+        DataFilter filter(NULL, DataFilterFixture::context(), "1 + 2 * 3 - 4 / 5");
+        QVERIFY(filter.root());
+        filter.rt.interpret = true;
+
+        double total = 0;
+        QBENCHMARK { total += filter.evaluate(ride, NULL).number(); }
+        QVERIFY(total > 0);
+    }
+
+    void benchmarkVectorCopy() {
+        Result vector(QVector<double>(16, 1.0));
+
+        double total = 0;
+        QBENCHMARK {
+            Result copy = vector;
+            total += copy.number();
+        }
+        QVERIFY(total > 0);
+    }
+};
+
+QTEST_MAIN(TestDataFilterResult)
+#include "testDataFilterResult.moc"
@@ -0,0 +1,6 @@
+QT += testlib core
+
+SOURCES = testEffortSearch.cpp
+GC_OBJS = EffortSearch
+
+include(../../unittests.pri)
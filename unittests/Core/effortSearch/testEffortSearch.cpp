@@ -0,0 +1,156 @@
+#include "Core/EffortSearch.h"
+
+#include <QTest>
+#include <QFile>
+#include <QTextStream>
+
+
+// the watts column of a GoldenCheetah csv export, integrated
+static QVector<long>
+readIntegrated(const QString &filename)
+{
+    QVector<long> returning;
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return returning;
+
+    QTextStream in(&file);
+    in.readLine(); // header
+    long total = 0;
+    while (!in.atEnd()) {
+        QStringList fields = in.readLine().split(",");
+        if (fields.count() > 3) returning << (total += fields[3].toInt());
+    }
+    return returning;
+}
+
+// the search a second at a time, as updateIntervals used to do it
+static void
+search(const long *integrated, long secs, double CP, double WPRIME, double PMAX, long i,
+       bool &found, EffortSearch::Effort &tte, bool &foundSprint, EffortSearch::Effort &sprint)
+{
+    int t = (secs-i-1) > 3600 ? 3600 : secs-i-1;
+    found = foundSprint = false;
+
+    while (t > 120) {
+        double tc = ((integrated[i+t]-integrated[i]) - WPRIME) / CP;
+        if (tc >= (t*0.85f)) {
+            double thisquality = tc / double(t);
+            if (found == false || tte.quality < thisquality) {
+                found = true;
+                tte.start = i + 1;
+                tte.duration = t;
+                tte.joules = integrated[i+t]-integrated[i];
+                tte.quality = thisquality;
+            }
+            t--;
+        } else {
+            t = tc;
+            if (t<120) t=120;
+        }
+    }
+
+    while (t >= 5) {
+        double p = (integrated[i+t]-integrated[i])/t;
+        if (p>0.5*(PMAX-CP)+CP) {
+            double tc = WPRIME / (p-CP) + WPRIME / ( CP - PMAX);
+            if (tc >= (t*0.85f)) {
+                double thisquality = double(t) + (integrated[i+t]-integrated[i])/t/1000.0;
+                if (foundSprint == false || sprint.quality < thisquality) {
+                    foundSprint = true;
+                    sprint.start = i + 1;
+                    sprint.duration = t;
+                    sprint.joules = integrated[i+t]-integrated[i];
+                    sprint.quality = thisquality;
+                }
+            }
+        }
+        t--;
+    }
+}
+
+static bool
+same(const EffortSearch::Effort &a, const EffortSearch::Effort &b)
+{
+    return a.start == b.start && a.duration == b.duration && a.joules == b.joules && a.quality == b.quality;
+}
+
+// every start second gives the same efforts as the old search
+static int
+compare(const QVector<long> &integrated, double CP, double WPRIME, double PMAX, long &found)
+{
+    int mismatches = 0;
+    long secs = integrated.count();
+    EffortSearch effortSearch(integrated.constData(), secs, CP, WPRIME, PMAX);
+
+    for (long i=0; i<secs; i++) {
+        bool f, fs;
+        EffortSearch::Effort tte, sprint, e;
+        search(integrated.constData(), secs, CP, WPRIME, PMAX, i, f, tte, fs, sprint);
+
+        if (effortSearch.tte(i, e) != f || (f && !same(e, tte))) mismatches++;
+        if (effortSearch.sprint(i, e) != fs || (fs && !same(e, sprint))) mismatches++;
+        if (f) found++;
+    }
+    return mismatches;
+}
+
+class TestEffortSearch: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void rides_data() {
+        QTest::addColumn<QString>("ride");
+        QTest::newRow("2009_05_27") << QFINDTESTDATA("../../../test/rides/2009_05_27_01_01_01.csv");
+        QTest::newRow("2009_07_10") << QFINDTESTDATA("../../../test/rides/2009_07_10_17_55_06.csv");
+        QTest::newRow("2009_11_28 11:00") << QFINDTESTDATA("../../../test/rides/2009_11_28_11_00_00.csv");
+        QTest::newRow("2009_11_28 12:00") << QFINDTESTDATA("../../../test/rides/2009_11_28_12_00_00.csv");
+        QTest::newRow("joule") << QFINDTESTDATA("../../../test/rides/joule-ride.csv");
+    }
+
+    void rides() {
+        QFETCH(QString, ride);
+        QVector<long> integrated = readIntegrated(ride);
+        QVERIFY(integrated.count() > 1000);
+
+        long found = 0;
+        const double CPs[] = { 150, 200, 250 };
+        for (double CP : CPs) QCOMPARE(compare(integrated, CP, 20000, 900, found), 0);
+        QVERIFY(found > 0);
+    }
+
+    void long_ride() {
+        // 4 hours: easy, a hard hour, then tempo with a sprint every 5 minutes
+        QVector<long> integrated;
+        long total = 0;
+        quint32 seed = 7;
+        for (int t=0; t<4*3600; t++) {
+            seed = seed * 1103515245 + 12345;
+            int noise = (seed >> 16) % 40;
+            int watts = t < 3600 ? 180 : t < 7200 ? 265 + noise : (t % 300 < 10 ? 1000 : 230 + noise);
+            integrated << (total += watts);
+        }
+
+        long found = 0;
+        QCOMPARE(compare(integrated, 250, 20000, 1100, found), 0);
+        QCOMPARE(compare(integrated, 270, 15000, 1100, found), 0);
+        QVERIFY(found > 0);
+    }
+
+    void steady() {
+        // steady power puts many durations on the same line, and
+        // a W' with a fraction is searched a second at a time
+        QVector<long> integrated;
+        long total = 0;
+        for (int t=0; t<2*3600; t++) integrated << (total += t % 600 < 300 ? 300 : 280);
+
+        long found = 0;
+        QCOMPARE(compare(integrated, 250, 20000, 1100, found), 0);
+        QCOMPARE(compare(integrated, 250, 20000.5, 1100, found), 0);
+        QVERIFY(found > 0);
+    }
+};
+
+
+QTEST_MAIN(TestEffortSearch)
+#include "testEffortSearch.moc"
@@ -0,0 +1,6 @@
+QT += testlib widgets
+
+SOURCES = testMeasures.cpp
+GC_OBJS = Measures
+
+include(../../unittests.pri)
@@ -0,0 +1,112 @@
+#include "Core/Measures.h"
+
+#include <QTest>
+
+
+// ten years of daily readings, with a gap every few weeks
+// and the odd second reading later in the same day
+static QList<Measure>
+tenYears()
+{
+    QList<Measure> returning;
+    QDateTime when(QDate(2015, 1, 1), QTime(7, 0));
+    for (int day=0; day<3650; day++) {
+        if (day % 23 == 5) continue;
+
+        Measure m;
+        m.when = when.addDays(day);
+        m.values[0] = 70.0 + (day % 100) / 10.0;
+        m.values[1] = day;
+        returning << m;
+
+        if (day % 17 == 3) {
+            m.when = m.when.addSecs(3600);
+            m.values[1] = -day;
+            returning << m;
+        }
+    }
+    return returning;
+}
+
+// the original linear search, as a reference
+static Measure
+reference(const QList<Measure> &measures, QDate date, bool carryForward)
+{
+    Measure here;
+    foreach(Measure x, measures) {
+        if (carryForward && x.when.date() < date) here = x;
+        if (x.when.date() == date) here = x;
+        if (x.when.date() > date) break;
+    }
+    return here;
+}
+
+static MeasuresGroup *
+group(QString symbol)
+{
+    QStringList symbols = QStringList() << "weightkg" << "seq";
+    QList<double> factors = QList<double>() << 1.0 << 1.0;
+    QList<QStringList> headers = QList<QStringList>() << QStringList() << QStringList();
+    MeasuresGroup *returning = new MeasuresGroup(symbol, symbol, symbols, symbols, symbols, symbols, factors, headers);
+    QList<Measure> measures = tenYears();
+    returning->setMeasures(measures);
+    return returning;
+}
+
+class TestMeasures: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void sameAsLinearSearch_data() {
+        QTest::addColumn<QString>("symbol");
+        QTest::newRow("body") << QString("Body");
+        QTest::newRow("hrv") << QString("Hrv");
+    }
+
+    void sameAsLinearSearch() {
+        QFETCH(QString, symbol);
+        QScopedPointer<MeasuresGroup> g(group(symbol));
+        QList<Measure> measures = g->measures();
+
+        for (QDate date(2014, 12, 1); date < QDate(2025, 2, 1); date = date.addDays(1)) {
+            Measure expected = reference(measures, date, symbol == "Body");
+            Measure got;
+            g->getMeasure(date, got);
+            QCOMPARE(got.when, expected.when);
+            QCOMPARE(got.values[1], expected.values[1]);
+            QCOMPARE(g->getFieldValue(date, 0), expected.values[0]);
+        }
+    }
+
+    void empty() {
+        MeasuresGroup g;
+        QVERIFY(g.getMeasure(QDate(2020, 1, 1)) == NULL);
+        QCOMPARE(g.getFieldValue(QDate(2020, 1, 1)), 0.0);
+    }
+
+    void benchmarkLinear() {
+        QScopedPointer<MeasuresGroup> g(group("Body"));
+        QList<Measure> measures = g->measures();
+        QBENCHMARK {
+            double total = 0;
+            for (QDate date(2015, 1, 1); date < QDate(2025, 1, 1); date = date.addDays(3))
+                total += reference(measures, date, true).values[0];
+            QVERIFY(total > 0);
+        }
+    }
+
+    void benchmarkIndexed() {
+        QScopedPointer<MeasuresGroup> g(group("Body"));
+        QBENCHMARK {
+            double total = 0;
+            for (QDate date(2015, 1, 1); date < QDate(2025, 1, 1); date = date.addDays(3))
+                total += g->getFieldValue(date, 0);
+            QVERIFY(total > 0);
+        }
+    }
+};
+
+
+QTEST_MAIN(TestMeasures)
+#include "testMeasures.moc"
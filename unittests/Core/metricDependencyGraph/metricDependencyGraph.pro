@@ -0,0 +1,6 @@
+QT += testlib core concurrent
+
+SOURCES = testMetricDependencyGraph.cpp
+GC_OBJS = MetricDependencyGraph
+
+include(../../unittests.pri)
@@ -0,0 +1,202 @@
+#include "Metrics/MetricDependencyGraph.h"
+
+#include <QTest>
+#include <QtConcurrent>
+#include <QRandomGenerator>
+
+
+// a synthetic metric set shaped like the builtins: a few
+// hundred metrics, most with no dependencies, some chains
+struct SyntheticMetrics
+{
+    QStringList symbols;
+    QVector<QVector<QString> > deps;
+    QVector<double> samples;
+
+    SyntheticMetrics(int n, int secs) {
+        QRandomGenerator rng(42);
+        for (int i=0; i<n; i++) {
+            symbols << QString("metric_%1").arg(i);
+            QVector<QString> d;
+            if (i > 10 && rng.bounded(3) == 0) {
+                int k = 1 + rng.bounded(3);
+                while (k--) d << symbols[rng.bounded(i)];
+            }
+            deps << d;
+        }
+        for (int i=0; i<secs; i++) samples << rng.bounded(400);
+    }
+
+    // a metric is a pass over the ride plus its dependencies
+    double compute(int i, const QVector<double> &depValues) const {
+        double sum = 0;
+        for (int j=0; j<samples.count(); j++) sum += samples[j] * ((i % 7) + 1);
+        foreach(double v, depValues) sum += v;
+        return sum / samples.count();
+    }
+};
+
+// what RideMetric::computeMetrics used to do, resolving
+// dependencies by name and re-queuing till they are done
+static QHash<QString,double>
+legacyCompute(const SyntheticMetrics &set)
+{
+    QHash<QString,int> index;
+    for (int i=0; i<set.symbols.count(); i++) index.insert(set.symbols[i], i);
+
+    QStringList builtin = set.symbols;
+    QHash<QString,double> done;
+    while (!builtin.isEmpty()) {
+        QString symbol = builtin.takeFirst();
+        const QVector<QString> &deps = set.deps[index.value(symbol)];
+        bool ready = true;
+        foreach(QString dep, deps) {
+            if (!done.contains(dep)) {
+                ready = false;
+                if (!builtin.contains(dep)) builtin.append(dep);
+            }
+        }
+        if (ready) {
+            QVector<double> values;
+            foreach(QString dep, deps) values << done.value(dep);
+            done.insert(symbol, set.compute(index.value(symbol), values));
+        } else if (!builtin.contains(symbol)) builtin.append(symbol);
+    }
+    return done;
+}
+
+static QVector<double>
+compiledCompute(const SyntheticMetrics &set, const MetricDependencyGraph &graph, bool concurrent)
+{
+    QVector<int> wanted;
+    for (int i=0; i<graph.count(); i++) wanted << i;
+
+    QVector<double> done(graph.count(), 0);
+    foreach(QVector<int> level, graph.schedule(wanted)) {
+        auto compute = [&set, &graph, &done] (int id) {
+            QVector<double> values;
+            foreach(int dep, graph.dependencies(id)) values << done[dep];
+            done[id] = set.compute(id, values);
+        };
+        if (concurrent) QtConcurrent::blockingMap(level, compute);
+        else foreach(int id, level) compute(id);
+    }
+    return done;
+}
+
+class TestMetricDependencyGraph : public QObject
+{
+    Q_OBJECT
+
+private slots:
+
+    void levels() {
+        MetricDependencyGraph graph;
+        QVector<QVector<QString> > deps;
+        deps << QVector<QString>()                                   // a
+             << (QVector<QString>() << "a")                          // b
+             << (QVector<QString>() << "a" << "b")                   // c
+             << QVector<QString>()                                   // d
+             << QVector<QString>();                                  // user
+        QVector<bool> deferred;
+        deferred << false << false << false << false << true;
+
+        graph.compile(QStringList() << "a" << "b" << "c" << "d" << "user", deps, deferred);
+
+        QCOMPARE(graph.count(), 5);
+        QCOMPARE(graph.id("c"), 2);
+        QCOMPARE(graph.id("missing"), -1);
+        QCOMPARE(graph.level(0), 0);
+        QCOMPARE(graph.level(1), 1);
+        QCOMPARE(graph.level(2), 2);
+        QCOMPARE(graph.level(3), 0);
+        QCOMPARE(graph.level(4), 3); // after all the builtins
+
+        // dependencies are pulled in, unwanted metrics are not
+        QVector<QVector<int> > worklist = graph.schedule(QVector<int>() << 2);
+        QCOMPARE(worklist.count(), 3);
+        QCOMPARE(worklist[0], QVector<int>() << 0);
+        QCOMPARE(worklist[1], QVector<int>() << 1);
+        QCOMPARE(worklist[2], QVector<int>() << 2);
+    }
+
+    // a metric depending on a deferred one is deferred along with it,
+    // so the deferred one is still levelled after all the builtins
+    void dependsOnDeferred() {
+        MetricDependencyGraph graph;
+        QVector<QVector<QString> > deps;
+        deps << QVector<QString>()                                   // a
+             << (QVector<QString>() << "a")                          // b
+             << (QVector<QString>() << "b")                          // c
+             << (QVector<QString>() << "python")                     // user
+             << QVector<QString>();                                  // python
+        QVector<bool> deferred;
+        deferred << false << false << false << false << true;
+
+        graph.compile(QStringList() << "a" << "b" << "c" << "user" << "python", deps, deferred);
+
+        QCOMPARE(graph.level(2), 2);
+        QCOMPARE(graph.level(4), 3);
+        QCOMPARE(graph.level(3), 4);
+        QVERIFY(graph.isDeferred(3));
+        QVERIFY(!graph.isDeferred(2));
+
+        QVector<QVector<int> > worklist = graph.schedule(QVector<int>() << 3);
+        QCOMPARE(worklist.count(), 2);
+        QCOMPARE(worklist[0], QVector<int>() << 4);
+        QCOMPARE(worklist[1], QVector<int>() << 3);
+    }
+
+    void brokenDependencies() {
+        MetricDependencyGraph graph;
+        QVector<QVector<QString> > deps;
+        deps << (QVector<QString>() << "b")                          // a
+             << (QVector<QString>() << "a")                          // b
+             << (QVector<QString>() << "unknown");                   // c
+        graph.compile(QStringList() << "a" << "b" << "c", deps, QVector<bool>(3, false));
+
+        // cycles and unknowns are dropped rather than looping forever
+        QVector<QVector<int> > worklist = graph.schedule(QVector<int>() << 0 << 1 << 2);
+        int scheduled = 0;
+        foreach(const QVector<int> &level, worklist) scheduled += level.count();
+        QCOMPARE(scheduled, 3);
+        QVERIFY(graph.dependencies(2).isEmpty());
+    }
+
+    void sameResults() {
+        SyntheticMetrics set(300, 600);
+        MetricDependencyGraph graph;
+        graph.compile(set.symbols, set.deps, QVector<bool>(set.symbols.count(), false));
+
+        QHash<QString,double> legacy = legacyCompute(set);
+        QVector<double> serial = compiledCompute(set, graph, false);
+        QVector<double> concurrent = compiledCompute(set, graph, true);
+        for (int i=0; i<set.symbols.count(); i++) {
+            QCOMPARE(serial[i], legacy.value(set.symbols[i]));
+            QCOMPARE(concurrent[i], serial[i]);
+        }
+    }
+
+    // per-ride compute time for a one hour ride, before and after
+    void benchmarkLegacy() {
+        SyntheticMetrics set(300, 3600);
+        QBENCHMARK { legacyCompute(set); }
+    }
+
+    void benchmarkCompiled() {
+        SyntheticMetrics set(300, 3600);
+        MetricDependencyGraph graph;
+        graph.compile(set.symbols, set.deps, QVector<bool>(set.symbols.count(), false));
+        QBENCHMARK { compiledCompute(set, graph, false); }
+    }
+
+    void benchmarkCompiledConcurrent() {
+        SyntheticMetrics set(300, 3600);
+        MetricDependencyGraph graph;
+        graph.compile(set.symbols, set.deps, QVector<bool>(set.symbols.count(), false));
+        QBENCHMARK { compiledCompute(set, graph, true); }
+    }
+};
+
+QTEST_MAIN(TestMetricDependencyGraph)
+#include "testMetricDependencyGraph.moc"
@@ -0,0 +1,6 @@
+QT += testlib core
+
+SOURCES = testSeriesAlignment.cpp
+GC_OBJS = SeriesAlignment
+
+include(../../unittests.pri)
@@ -0,0 +1,138 @@
+#include "Core/SeriesAlignment.h"
+
+#include <QTest>
+#include <QFile>
+#include <QTextStream>
+#include <cmath>
+
+
+// a column of a GoldenCheetah or Joule csv export, the samples
+// follow the header line starting Minutes, which in a Joule export
+// comes after a few lines about the ride
+static QVector<double>
+readColumn(const QString &filename, int column)
+{
+    QVector<double> returning;
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return returning;
+
+    QTextStream in(&file);
+    while (!in.atEnd() && !in.readLine().startsWith("Minutes,")) ;
+    while (!in.atEnd()) {
+        QStringList fields = in.readLine().split(",");
+        if (fields.count() > column) returning << fields[column].toDouble();
+    }
+    return returning;
+}
+
+class TestSeriesAlignment: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void rides_data() {
+        QTest::addColumn<QString>("ride");
+        QTest::addColumn<int>("column");
+        QTest::addColumn<int>("shift");
+
+        QString ride1 = QFINDTESTDATA("../../../test/rides/2009_07_10_17_55_06.csv");
+        QString ride2 = QFINDTESTDATA("../../../test/rides/joule-ride.csv");
+        QTest::newRow("watts") << ride1 << 3 << 37;
+        QTest::newRow("cadence") << ride1 << 5 << 311;
+        QTest::newRow("hr") << ride1 << 6 << 0;
+        QTest::newRow("joule watts") << ride2 << 3 << 311;
+        QTest::newRow("joule hr") << ride2 << 6 << 37;
+    }
+
+    void rides() {
+        QFETCH(QString, ride);
+        QFETCH(int, column);
+        QFETCH(int, shift);
+
+        // two thirds of the ride from shift, with a little noise
+        QVector<double> base = readColumn(ride, column);
+        QVERIFY(base.count() > 1000);
+        QVector<double> fit;
+        quint32 seed = 11;
+        for (int i=0; i<base.count()*2/3 && shift+i<base.count(); i++) {
+            seed = seed * 1103515245 + 12345;
+            fit << base[shift+i] + ((seed >> 16) % 5) - 2.0;
+        }
+
+        // the same best offset and fit as trying each offset in turn
+        int range = base.count()/3;
+        double bestR2 = 0;
+        int bestOffset = 0;
+        for (int offset=-range; offset<range; offset++) {
+            double R2 = SeriesAlignment::direct(base, fit, offset);
+            if (R2 > bestR2) {
+                bestR2 = R2;
+                bestOffset = offset;
+            }
+        }
+        QCOMPARE(bestOffset, shift);
+
+        SeriesAlignment alignment(range);
+        int index = alignment.add(base, fit);
+        QCOMPARE(alignment.offset(index), bestOffset);
+        QCOMPARE(alignment.fit(index), bestR2);
+
+        // and the fit at every other offset to within rounding
+        for (int offset=-range; offset<range; offset++) {
+            double R2 = SeriesAlignment::direct(base, fit, offset);
+            if (std::isfinite(R2)) QVERIFY(fabs(alignment.fits(index)[offset+range] - R2) < 1e-6);
+        }
+    }
+
+    void joint() {
+        // watts and cadence together
+        QString ride = QFINDTESTDATA("../../../test/rides/2009_07_10_17_55_06.csv");
+        SeriesAlignment alignment(1200);
+        foreach(int column, QList<int>() << 3 << 5) {
+            QVector<double> base = readColumn(ride, column);
+            alignment.add(base, base.mid(100, 2400));
+        }
+        QCOMPARE(alignment.count(), 2);
+        QCOMPARE(alignment.offset(0), 100);
+        QCOMPARE(alignment.offset(1), 100);
+
+        // which stands out clearly from any other alignment
+        QVERIFY(alignment.confidence(100) > 0.5);
+        QCOMPARE(alignment.confidence(1000), 0.0);
+    }
+
+    void badFits() {
+        // watts, a series that fits nothing and one that fits worse than nothing
+        QString ride = QFINDTESTDATA("../../../test/rides/2009_07_10_17_55_06.csv");
+        QVector<double> base = readColumn(ride, 3);
+        QVector<double> inverted;
+        foreach(double watts, base.mid(100, 2400)) inverted << -watts;
+
+        SeriesAlignment watts(1200), all(1200);
+        watts.add(base, base.mid(100, 2400));
+        all.add(base, base.mid(100, 2400));
+        all.add(QVector<double>(base.count(), 0), QVector<double>(2400, 0));
+        all.add(base, inverted);
+
+        // the flat series has no say, the inverted one counts as no fit
+        QVector<double> joint = all.joint();
+        for (int k=0; k<joint.count(); k++) {
+            QVERIFY(!std::isnan(joint[k]) || std::isnan(watts.joint()[k]));
+            QVERIFY(std::isnan(joint[k]) || (joint[k] >= 0 && joint[k] <= 1));
+        }
+        QVERIFY(all.confidence(100) > 0.25);
+        QVERIFY(all.confidence(100) <= watts.confidence(100));
+    }
+
+    void unrecorded() {
+        // a series that is all zeros fits nothing
+        SeriesAlignment alignment(100);
+        int index = alignment.add(QVector<double>(300, 0), QVector<double>(200, 0));
+        QCOMPARE(alignment.fit(index), 0.0);
+        QCOMPARE(alignment.offset(index), 0);
+    }
+};
+
+
+QTEST_MAIN(TestSeriesAlignment)
+#include "testSeriesAlignment.moc"
@@ -0,0 +1,144 @@
+#include "Metrics/WPrimeBalance.h"
+
+#include <QTest>
+#include <QFile>
+#include <QTextStream>
+#include <cmath>
+
+
+// the watts column of a GoldenCheetah csv export
+static QVector<int>
+readWatts(const QString &filename)
+{
+    QVector<int> returning;
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return returning;
+
+    QTextStream in(&file);
+    in.readLine(); // header
+    while (!in.atEnd()) {
+        QStringList fields = in.readLine().split(",");
+        if (fields.count() > 3) returning << fields[3].toInt();
+    }
+    return returning;
+}
+
+// W'bal as WPrime used to compute it
+static QVector<double>
+integral(const QVector<int> &watts, double CP, double WPRIME, double TAU)
+{
+    QVector<double> returning;
+    double I = 0;
+    for (int t=0; t<watts.count(); t++) {
+        I += exp(((double)(t) / TAU)) * (watts[t] > CP ? watts[t]-CP : 0);
+        returning << WPRIME - (exp(-((double)(t) / TAU)) * I);
+    }
+    return returning;
+}
+
+static QVector<double>
+differential(const QVector<int> &watts, double CP, double WPRIME)
+{
+    QVector<double> returning;
+    double W = WPRIME;
+    for (int t=0; t<watts.count(); t++) {
+        if (watts[t] < CP) W  = W + (CP-watts[t])*(WPRIME-W)/WPRIME;
+        else W  = W + (CP-watts[t]);
+        returning << W;
+    }
+    return returning;
+}
+
+class TestWPrimeBalance: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void rides_data() {
+        QTest::addColumn<QString>("ride");
+        QTest::newRow("2009_05_27") << QFINDTESTDATA("../../../test/rides/2009_05_27_01_01_01.csv");
+        QTest::newRow("2009_07_10") << QFINDTESTDATA("../../../test/rides/2009_07_10_17_55_06.csv");
+        QTest::newRow("2009_11_28 12:00") << QFINDTESTDATA("../../../test/rides/2009_11_28_12_00_00.csv");
+        QTest::newRow("2009_11_28 13:00") << QFINDTESTDATA("../../../test/rides/2009_11_28_13_00_00.csv");
+    }
+
+    void rides() {
+        QFETCH(QString, ride);
+        QVector<int> watts = readWatts(ride);
+        QVERIFY(watts.count() > 1000);
+
+        // all the parameters in one pass, each against the old code
+        const double CPs[] = { 150, 250, 350 };
+        const double TAUs[] = { 300, 450, 600 };
+        WPrimeBalance integrals(WPrimeBalance::Integral), differentials(WPrimeBalance::Differential);
+        QVector<QVector<double> > expected, expectedd;
+        for (double CP : CPs) {
+            for (double TAU : TAUs) {
+                integrals.add(CP, 20000, TAU);
+                differentials.add(CP, 20000, TAU);
+                expected << integral(watts, CP, 20000, TAU);
+                expectedd << differential(watts, CP, 20000);
+            }
+        }
+
+        QVector<double> lowest(expected.count(), 20000);
+        for (int t=0; t<watts.count(); t++) {
+            integrals.step(watts[t]);
+            differentials.step(watts[t]);
+            for (int i=0; i<expected.count(); i++) {
+                QVERIFY(fabs(integrals.wbal(i) - expected[i][t]) < 1e-6);
+                QVERIFY(fabs(differentials.wbal(i) - expectedd[i][t]) < 1e-6);
+                lowest[i] = qMin(lowest[i], expected[i][t]);
+            }
+        }
+        for (int i=0; i<expected.count(); i++) QVERIFY(fabs(integrals.minimum(i) - lowest[i]) < 1e-6);
+    }
+
+    void long_ride() {
+        // 2 days of 30/30s with a TAU of a minute, so t/TAU is well past
+        // the ~709 where exp(t/TAU) overflows in the old formulation
+        const double CP = 250, WPRIME = 20000, TAU = 60;
+        QVector<int> watts;
+        for (int t=0; t<48*3600; t++) watts << (t % 60 < 30 ? 300 : 200);
+        QVERIFY(!std::isfinite(integral(watts, CP, WPRIME, TAU).last()));
+
+        // W' expended decays by exp(-1/TAU) each second
+        WPrimeBalance wbal;
+        wbal.add(CP, WPRIME, TAU);
+        double spent = 0;
+        for (int t=0; t<watts.count(); t++) {
+            wbal.step(watts[t]);
+            spent = spent * exp(-1.0 / TAU) + (watts[t] > CP ? watts[t] - CP : 0);
+            QVERIFY(std::isfinite(wbal.wbal()));
+            QVERIFY(fabs(wbal.wbal() - (WPRIME - spent)) < 1e-6);
+        }
+
+        // which settles to the same W'bal every minute
+        double before = wbal.wbal();
+        for (int t=0; t<60; t++) wbal.step(t % 60 < 30 ? 300 : 200);
+        QVERIFY(fabs(wbal.wbal() - before) < 1e-6);
+        QVERIFY(wbal.minimum() > 0 && wbal.minimum() < WPRIME);
+    }
+
+    void step_length() {
+        // five 200ms steps are one second of the same watts
+        WPrimeBalance second, fifths;
+        second.add(250, 20000, 300);
+        fifths.add(250, 20000, 300);
+        for (int t=0; t<600; t++) {
+            int watts = t < 300 ? 400 : 100;
+            second.step(watts);
+            for (int i=0; i<5; i++) fifths.step(watts, 0.2);
+        }
+        QVERIFY(fabs(second.wbal() - 20000) > 1000);
+        QVERIFY(fabs(second.wbal() - fifths.wbal()) < 50);
+
+        fifths.reset();
+        QCOMPARE(fifths.wbal(), 20000.0);
+        QCOMPARE(fifths.minimum(), 20000.0);
+    }
+};
+
+
+QTEST_MAIN(TestWPrimeBalance)
+#include "testWPrimeBalance.moc"
@@ -0,0 +1,6 @@
+QT += testlib core
+
+SOURCES = testWPrimeBalance.cpp
+GC_OBJS = WPrimeBalance
+
+include(../../unittests.pri)
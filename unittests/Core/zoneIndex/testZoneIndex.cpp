@@ -0,0 +1,98 @@
+#include "Metrics/ZoneIndex.h"
+
+#include <QTest>
+#include <cmath>
+
+
+// just enough of a zone range for the index
+struct TestZone {
+    double lo, hi;
+    TestZone(double lo, double hi) : lo(lo), hi(hi) {}
+};
+
+struct TestRange {
+    QDate begin, end;
+    QList<TestZone> zones;
+    TestRange(QDate b, QDate e) : begin(b), end(e) {}
+};
+
+// the scans the zone classes used to do
+static int
+scanRange(const QList<TestRange> &ranges, const QDate &date)
+{
+    for (int rnum = 0; rnum < ranges.size(); ++rnum) {
+        const TestRange &range = ranges[rnum];
+        if (((date >= range.begin) || (range.begin.isNull())) &&
+            ((date < range.end) || (range.end.isNull())))
+            return rnum;
+    }
+    return -1;
+}
+
+static int
+scanZone(const QList<TestRange> &ranges, int rnum, double value)
+{
+    for (int j = 0; j < ranges[rnum].zones.size(); ++j)
+        if ((value >= ranges[rnum].zones[j].lo) && (value < ranges[rnum].zones[j].hi))
+            return j;
+    return -1;
+}
+
+class TestZoneIndex: public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void empty() {
+        ZoneIndex index;
+        QCOMPARE(index.whichRange(QDate(2020, 1, 1)), -1);
+        index.build(QList<TestRange>());
+        QCOMPARE(index.whichRange(QDate(2020, 1, 1)), -1);
+        QCOMPARE(index.whichRange(QDate()), -1);
+    }
+
+    void ranges() {
+        // open start, a gap, an overlap and open end
+        QList<TestRange> ranges;
+        ranges << TestRange(QDate(), QDate(2018, 1, 1));
+        ranges << TestRange(QDate(2018, 3, 1), QDate(2019, 6, 1));
+        ranges << TestRange(QDate(2019, 1, 1), QDate(2021, 1, 1));
+        ranges << TestRange(QDate(2021, 1, 1), QDate());
+
+        ZoneIndex index;
+        index.build(ranges);
+
+        QCOMPARE(index.whichRange(QDate()), scanRange(ranges, QDate()));
+        for (QDate date(2016, 1, 1); date < QDate(2023, 1, 1); date = date.addDays(1))
+            QCOMPARE(index.whichRange(date), scanRange(ranges, date));
+    }
+
+    void zones() {
+        QList<TestRange> ranges;
+
+        // contiguous, as read from power.zones
+        ranges << TestRange(QDate(), QDate());
+        ranges[0].zones << TestZone(0, 150) << TestZone(150, 200) << TestZone(200, 250) << TestZone(250, 1e9);
+
+        // with a gap and an empty zone
+        ranges << TestRange(QDate(), QDate());
+        ranges[1].zones << TestZone(10, 100) << TestZone(120, 120) << TestZone(120, 300);
+
+        // overlapping, must still return the first match
+        ranges << TestRange(QDate(), QDate());
+        ranges[2].zones << TestZone(0, 200) << TestZone(100, 150) << TestZone(150, 400);
+
+        ZoneIndex index;
+        index.build(ranges);
+
+        for (int rnum = 0; rnum < ranges.count(); rnum++) {
+            for (double value = -10; value < 450; value += 0.5)
+                QCOMPARE(index.whichZone(rnum, value), scanZone(ranges, rnum, value));
+            QCOMPARE(index.whichZone(rnum, std::nan("")), -1);
+        }
+    }
+};
+
+
+QTEST_MAIN(TestZoneIndex)
+#include "testZoneIndex.moc"
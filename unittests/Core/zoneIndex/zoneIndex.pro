@@ -0,0 +1,5 @@
+QT += testlib core
+
+SOURCES = testZoneIndex.cpp
+
+include(../../unittests.pri)
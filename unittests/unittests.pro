@@ -12,6 +12,21 @@ equals(GC_UNITTESTS, active) {
 			   Core/utils \
 			   Core/signalSafety \
 			   Core/splineCrash \
+			   Core/metricDependencyGraph \
+			   Core/measures \
+			   Core/zoneIndex \
+			   Core/wprimeBalance \
+			   Core/effortSearch \
+			   Core/seriesAlignment \
+			   Core/dataFilterProgram \
+			   Core/dataFilterBinding \
+			   Core/dataFilterFunctions \
+			   Core/dataFilterBatch \
+			   Core/dataFilterParallel \
+			   Core/dataFilterMemo \
+			   Core/dataFilterResult \
+			   Core/dataFilterOptimizer \
+			   Core/dataFilterProfile \
 			   Gui/calendarData
 	CONFIG += ordered
 } else {